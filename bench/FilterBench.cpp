@@ -0,0 +1,454 @@
+/**
+ * @file FilterBench.cpp
+ * @brief So sánh các bộ lọc trọng lượng trên chuỗi mẫu HX711 tổng hợp và ghi lại
+ *
+ * Build và chạy:
+ *   pio run -e bench && .pio/build/bench/program
+ *   .pio/build/bench/program --csv > filters.csv
+ *   .pio/build/bench/program --trace capture.csv --cpg 340
+ *
+ * Tham số (mặc định trong ngoặc):
+ *   --sps 10|80|all     tốc độ của chuỗi tổng hợp (all)
+ *   --trace FILE        thêm chuỗi ghi lại "t_ms,raw[,truth]" (có thể lặp lại)
+ *   --cpg C             hệ số hiệu chuẩn count/gram (340)
+ *   --seed S            hạt giống ngẫu nhiên (1)
+ *   --repeat N          số lần chạy lại mỗi chuỗi khi đo thời gian (200)
+ *   --csv               in CSV thay vì bảng
+ *
+ * Chỉ số của mỗi bộ lọc trên mỗi chuỗi:
+ *   ns/mau      thời gian trên máy tính cho một mẫu (chỉ để so sánh tương đối)
+ *   AVR cyc     số chu kỳ ước lượng trên ATmega328P theo mô hình chi phí bên dưới
+ *   CPU %       AVR cyc * SPS / 16 MHz
+ *   settle ms   từ lúc trọng lượng thật đổi tới lúc đầu ra vào và ở trong ±1 g (trung bình)
+ *   RMS g       sai số RMS ở trạng thái ổn định (bỏ qua 1.5 s đầu sau mỗi bước)
+ *   peak g      sai số lớn nhất ở trạng thái ổn định - spike lọt qua bộ lọc
+ * Với bộ phát hiện ổn định, settle là thời điểm ra quyết định, RMS/peak là sai số của
+ * median lúc quyết định so với trọng lượng thật (chỉ các bước đặt sản phẩm).
+ */
+
+#include "Traces.h"
+#include "WeightFilter.h"
+#include "SettleDetector.h"
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+
+// Giống firmware (include/LoadCellManager.h)
+static const double SPIKE_THRESHOLD_G = 50.0;
+static const double SETTLE_TOLERANCE_G = 0.5;
+static const double SETTLE_NOISE_SIGMAS = 4.0;
+static const double SETTLE_NOISE_MAX = 2.0;
+static const uint32_t SETTLE_RUN_MS = 300;
+
+// Tiêu chí đo
+static const double SETTLE_BAND_G = 1.0;        // Đã ổn định khi sai số trong ±1 g
+static const uint32_t STEADY_AFTER_MS = 1500;   // Trạng thái ổn định: sau bước 1.5 s
+static const uint32_t MIN_SEGMENT_MS = 500;     // Bỏ qua đoạn ngắn hơn (sườn của dữ liệu ghi lại)
+static const double STEP_G = 5.0;               // Trọng lượng thật đổi hơn mức này là một bước
+static const double AVR_HZ = 16e6;
+
+/**
+ * Mô hình chi phí trên ATmega328P (chu kỳ cho mỗi mẫu), đếm từ mã avr-gcc -Os:
+ * - RunningMedian::add: tìm nhị phân ceil(log2(w+1)) vòng ~14 chu kỳ, dịch mảng
+ *   sorted và xoá mẫu cũ ~16 chu kỳ/phần tử, cộng ~56 chu kỳ gọi hàm và ring
+ * - EMA Q8: nhân int32 x uint8 bằng phần mềm và dịch 8 bit ~85 chu kỳ
+ * - Cách cũ (getWeight theo lô): mỗi mẫu qua get_units() gồm chuyển long->float,
+ *   trừ offset và chia float (~480), cộng insertion sort float trên w mẫu (~280 trung
+ *   bình mỗi mẫu) ~760 chu kỳ
+ * - SettleDetector::update: min/max int32 của đoạn và so biên độ với dung sai ~40 chu
+ *   kỳ (chỉ chạy khi đang cân). SettlingPredictor trước đây (khớp AR(2) bằng float trên
+ *   12 mẫu) tốn ~25000 chu kỳ
+ */
+static double medianCycles(uint8_t window) {
+    int steps = (int)ceil(log2(window + 1.0));
+    return steps * 14 + window * 16 + 56;
+}
+static const double EMA_CYCLES = 85;
+static const double LEGACY_CYCLES = 760;
+static const double SETTLE_CYCLES = 40;
+
+enum VariantKind {
+    VARIANT_LEGACY,      // Trung vị của lô w mẫu mới, đầu ra giữ nguyên giữa hai lô
+    VARIANT_STREAM,      // WeightFilter: median trượt + EMA (alpha 256 = không EMA)
+    VARIANT_SETTLE       // SettleDetector trên mẫu thô, giá trị là median trượt w mẫu
+};
+
+struct Variant {
+    const char* name;
+    VariantKind kind;
+    uint8_t window;
+    uint16_t alpha;
+    bool production;
+};
+
+static const Variant VARIANTS[] = {
+    { "legacy lo 5",        VARIANT_LEGACY,    5, 256, false },
+    { "median3",            VARIANT_STREAM,    3, 256, false },
+    { "median5",            VARIANT_STREAM,    5, 256, false },
+    { "median7",            VARIANT_STREAM,    7, 256, false },
+    { "median3+ema32",      VARIANT_STREAM,    3, 32,  false },
+    { "median3+ema64",      VARIANT_STREAM,    3, 64,  false },
+    { "median3+ema128",     VARIANT_STREAM,    3, 128, false },
+    { "median5+ema32",      VARIANT_STREAM,    5, 32,  false },
+    { "median5+ema64",      VARIANT_STREAM,    5, 64,  true  },
+    { "median5+ema128",     VARIANT_STREAM,    5, 128, false },
+    { "median7+ema32",      VARIANT_STREAM,    7, 32,  false },
+    { "median7+ema64",      VARIANT_STREAM,    7, 64,  false },
+    { "median7+ema128",     VARIANT_STREAM,    7, 128, false },
+    { "settle(median5)",    VARIANT_SETTLE,    5, 256, true  },
+};
+static const size_t VARIANT_COUNT = sizeof(VARIANTS) / sizeof(VARIANTS[0]);
+
+struct Result {
+    double nsPerSample;
+    double avrCycles;
+    double cpuPercent;
+    double settleMs;     ///< < 0 nếu không bước nào ổn định
+    double rmsG;
+    double peakG;
+    unsigned int steps;
+    unsigned int unsettled;
+};
+
+/**
+ * Một đoạn trọng lượng thật không đổi
+ */
+struct Segment {
+    size_t begin;
+    size_t end;     // Không bao gồm
+    int32_t level;
+    bool load;      // Bước tăng (đặt sản phẩm)
+};
+
+static std::vector<Segment> findSegments(const Trace& trace, int32_t stepCounts) {
+    std::vector<Segment> segments;
+    const std::vector<TraceSample>& s = trace.samples;
+    size_t start = 0;
+    for (size_t i = 1; i <= s.size(); i++) {
+        if (i < s.size() && abs(s[i].truth - s[start].truth) <= stepCounts) {
+            continue;
+        }
+        Segment seg;
+        seg.begin = start;
+        seg.end = i;
+        seg.level = s[i - 1].truth;  // Giá trị cuối đoạn: dữ liệu ghi lại đã ổn định
+        seg.load = start > 0 && seg.level > s[start - 1].truth;
+        if (s[i - 1].timeMs - s[start].timeMs >= MIN_SEGMENT_MS) {
+            segments.push_back(seg);
+        }
+        start = i;
+    }
+    return segments;
+}
+
+/**
+ * Chạy một bộ lọc qua chuỗi, trả về đầu ra cho mỗi mẫu
+ */
+static void runFilter(const Variant& v, const Trace& trace, int32_t spikeCounts,
+                      std::vector<int32_t>& out) {
+    const std::vector<TraceSample>& s = trace.samples;
+    out.resize(s.size());
+    if (v.kind == VARIANT_LEGACY) {
+        int32_t batch[MEDIAN_MAX_WINDOW];
+        uint8_t n = 0;
+        int32_t held = 0;
+        for (size_t i = 0; i < s.size(); i++) {
+            // Insertion sort như getWeight() cũ
+            int32_t key = s[i].raw;
+            int j = n - 1;
+            while (j >= 0 && batch[j] > key) {
+                batch[j + 1] = batch[j];
+                j--;
+            }
+            batch[j + 1] = key;
+            if (++n == v.window) {
+                held = batch[n / 2];
+                n = 0;
+            }
+            out[i] = held;
+        }
+        return;
+    }
+    WeightFilter filter(v.window, v.alpha, spikeCounts);
+    for (size_t i = 0; i < s.size(); i++) {
+        filter.add(s[i].raw);
+        out[i] = filter.getValue();
+    }
+}
+
+static double timeFilter(const Variant& v, const Trace& trace, int32_t spikeCounts,
+                         unsigned int repeat) {
+    std::vector<int32_t> out;
+    volatile int32_t sink = 0;
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    for (unsigned int r = 0; r < repeat; r++) {
+        runFilter(v, trace, spikeCounts, out);
+        sink = sink + out.back();
+    }
+    std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+    double ns = std::chrono::duration<double, std::nano>(t1 - t0).count();
+    return ns / ((double)repeat * trace.samples.size());
+}
+
+static Result evaluateFilter(const Variant& v, const Trace& trace, double cpg,
+                             unsigned int repeat) {
+    int32_t spikeCounts = (int32_t)lround(SPIKE_THRESHOLD_G * cpg);
+    std::vector<int32_t> out;
+    runFilter(v, trace, spikeCounts, out);
+
+    Result r;
+    memset(&r, 0, sizeof(r));
+    r.nsPerSample = timeFilter(v, trace, spikeCounts, repeat);
+    if (v.kind == VARIANT_LEGACY) {
+        r.avrCycles = LEGACY_CYCLES;
+    } else {
+        r.avrCycles = medianCycles(v.window) + (v.alpha < 256 ? EMA_CYCLES : 0);
+    }
+
+    const std::vector<TraceSample>& s = trace.samples;
+    double band = SETTLE_BAND_G * cpg;
+    double settleSum = 0, sq = 0;
+    unsigned long steadyCount = 0;
+    std::vector<Segment> segments = findSegments(trace, (int32_t)lround(STEP_G * cpg));
+    for (size_t k = 0; k < segments.size(); k++) {
+        const Segment& seg = segments[k];
+        if (seg.begin > 0) {
+            // Thời điểm cuối cùng đầu ra còn nằm ngoài dải ±1 g
+            size_t last = seg.begin;
+            bool outside = false;
+            for (size_t i = seg.begin; i < seg.end; i++) {
+                if (fabs((double)out[i] - seg.level) > band) {
+                    last = i;
+                    outside = true;
+                }
+            }
+            r.steps++;
+            if (outside && last + 1 >= seg.end) {
+                r.unsettled++;
+            } else {
+                size_t settledAt = outside ? last + 1 : seg.begin;
+                settleSum += s[settledAt].timeMs - s[seg.begin].timeMs;
+            }
+        }
+        for (size_t i = seg.begin; i < seg.end; i++) {
+            if (s[i].timeMs - s[seg.begin].timeMs < STEADY_AFTER_MS) {
+                continue;
+            }
+            double err = ((double)out[i] - seg.level) / cpg;
+            sq += err * err;
+            steadyCount++;
+            r.peakG = std::max(r.peakG, fabs(err));
+        }
+    }
+    unsigned int settled = r.steps - r.unsettled;
+    r.settleMs = settled ? settleSum / settled : -1;
+    r.rmsG = steadyCount ? sqrt(sq / steadyCount) : 0;
+    return r;
+}
+
+/**
+ * Độ lệch chuẩn nhiễu từ hiệu hai mẫu liên tiếp của đoạn đầu (cân rỗng). Firmware
+ * (LoadCellManager::trackNoise) bỏ các hiệu lớn hơn 4 sigma; ở đây dùng median của
+ * |hiệu| để spike không làm tăng ước lượng: sigma = median / (0.6745 * sqrt(2))
+ */
+static double estimateNoise(const Trace& trace, const std::vector<Segment>& segments) {
+    const std::vector<TraceSample>& s = trace.samples;
+    size_t end = segments.empty() ? s.size() : segments[0].end;
+    std::vector<double> diffs;
+    for (size_t i = 1; i < end; i++) {
+        diffs.push_back(fabs((double)s[i].raw - s[i - 1].raw));
+    }
+    if (diffs.empty()) {
+        return 0;
+    }
+    std::nth_element(diffs.begin(), diffs.begin() + diffs.size() / 2, diffs.end());
+    return diffs[diffs.size() / 2] / (0.6745 * sqrt(2.0));
+}
+
+/**
+ * Bộ phát hiện ổn định: mỗi bước đặt sản phẩm thì reset, đưa mẫu thô vào tới khi đủ
+ * đoạn ổn định; giá trị là median trượt lúc đó, như LoadCellManager::getSettledWeight
+ */
+static Result evaluateSettle(const Variant& v, const Trace& trace, double cpg,
+                             unsigned int repeat) {
+    const std::vector<TraceSample>& s = trace.samples;
+    std::vector<Segment> segments = findSegments(trace, (int32_t)lround(STEP_G * cpg));
+    double noise = std::min(SETTLE_NOISE_SIGMAS * estimateNoise(trace, segments),
+                            SETTLE_NOISE_MAX * SETTLE_TOLERANCE_G * cpg);
+    int32_t tolerance = (int32_t)lround(SETTLE_TOLERANCE_G * cpg + noise);
+    uint8_t run = (uint8_t)(SETTLE_RUN_MS * trace.sps / 1000);
+    uint8_t half = v.window / 2 + 1;
+    if (run < half) {
+        run = half;
+    }
+
+    Result r;
+    memset(&r, 0, sizeof(r));
+    double decideSum = 0, sq = 0;
+    unsigned long updates = 0;
+    double ns = 0;
+    for (size_t k = 0; k < segments.size(); k++) {
+        const Segment& seg = segments[k];
+        if (!seg.load) {
+            continue;
+        }
+        r.steps++;
+
+        bool decided = false;
+        size_t decidedAt = seg.begin;
+        int32_t value = 0;
+        std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+        for (unsigned int rep = 0; rep < repeat; rep++) {
+            RunningMedian median(v.window);
+            SettleDetector detector;
+            detector.reset(run, tolerance);
+            // Median đã có các mẫu cân rỗng trước bước, giống firmware
+            size_t warm = seg.begin >= v.window ? seg.begin - v.window : 0;
+            for (size_t i = warm; i < seg.begin; i++) {
+                median.add(s[i].raw);
+            }
+            for (size_t i = seg.begin; i < seg.end; i++) {
+                int32_t m = median.add(s[i].raw);
+                detector.update(s[i].raw);
+                if (rep == 0) {
+                    updates++;
+                }
+                if (detector.isSettled()) {
+                    decided = true;
+                    decidedAt = i;
+                    value = m;
+                    break;
+                }
+            }
+        }
+        std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+        ns += std::chrono::duration<double, std::nano>(t1 - t0).count() / repeat;
+
+        if (!decided) {
+            r.unsettled++;
+            continue;
+        }
+        decideSum += s[decidedAt].timeMs - s[seg.begin].timeMs;
+        double err = ((double)value - seg.level) / cpg;
+        sq += err * err;
+        r.peakG = std::max(r.peakG, fabs(err));
+    }
+    unsigned int settled = r.steps - r.unsettled;
+    r.nsPerSample = updates ? ns / updates : 0;
+    r.avrCycles = medianCycles(v.window) + SETTLE_CYCLES;
+    r.settleMs = settled ? decideSum / settled : -1;
+    r.rmsG = settled ? sqrt(sq / settled) : 0;
+    return r;
+}
+
+static void printHeader(bool csv) {
+    if (csv) {
+        printf("trace,sps,filter,production,ns_per_sample,avr_cycles,cpu_percent,"
+               "settle_ms,rms_g,peak_g,steps,unsettled\n");
+    }
+}
+
+static void printTraceTitle(const Trace& trace, bool csv) {
+    if (csv) {
+        return;
+    }
+    printf("\n=== %s, %u SPS, %zu mau%s ===\n", trace.name.c_str(), trace.sps,
+           trace.samples.size(), trace.synthetic ? "" : " (tham chieu: median 15 mau)");
+    printf("%-20s %8s %9s %6s %9s %7s %7s %6s\n",
+           "bo loc", "ns/mau", "AVR cyc", "CPU %", "settle ms", "RMS g", "peak g", "sot");
+}
+
+static void printRow(const Trace& trace, const Variant& v, const Result& r, bool csv) {
+    if (csv) {
+        printf("%s,%u,%s,%d,%.1f,%.0f,%.2f,%.0f,%.3f,%.2f,%u,%u\n",
+               trace.name.c_str(), trace.sps, v.name, v.production ? 1 : 0,
+               r.nsPerSample, r.avrCycles, r.cpuPercent, r.settleMs, r.rmsG, r.peakG,
+               r.steps, r.unsettled);
+        return;
+    }
+    char settle[16];
+    if (r.settleMs < 0) {
+        snprintf(settle, sizeof(settle), "-");
+    } else {
+        snprintf(settle, sizeof(settle), "%.0f", r.settleMs);
+    }
+    printf("%-19s%s %8.1f %9.0f %6.2f %9s %7.3f %7.2f %3u/%-2u\n",
+           v.name, v.production ? "*" : " ", r.nsPerSample, r.avrCycles, r.cpuPercent,
+           settle, r.rmsG, r.peakG, r.unsettled, r.steps);
+}
+
+int main(int argc, char** argv) {
+    bool csv = false;
+    double cpg = 340.0;
+    uint32_t seed = 1;
+    unsigned int repeat = 200;
+    bool sps10 = true, sps80 = true;
+    std::vector<std::string> files;
+
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        const char* value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+        if (strcmp(arg, "--csv") == 0) {
+            csv = true;
+            continue;
+        }
+        if (value == nullptr) {
+            fprintf(stderr, "Thieu gia tri cho %s\n", arg);
+            return 2;
+        }
+        if (strcmp(arg, "--sps") == 0) {
+            sps10 = strcmp(value, "80") != 0;
+            sps80 = strcmp(value, "10") != 0;
+        } else if (strcmp(arg, "--trace") == 0) {
+            files.push_back(value);
+        } else if (strcmp(arg, "--cpg") == 0) {
+            cpg = atof(value);
+        } else if (strcmp(arg, "--seed") == 0) {
+            seed = (uint32_t)strtoul(value, nullptr, 10);
+        } else if (strcmp(arg, "--repeat") == 0) {
+            repeat = (unsigned int)std::max(1, atoi(value));
+        } else {
+            fprintf(stderr, "Tham so khong hop le: %s\n", arg);
+            return 2;
+        }
+        i++;
+    }
+
+    std::vector<Trace> traces;
+    if (sps10) {
+        std::vector<Trace> t = makeSyntheticTraces(10, cpg, seed);
+        traces.insert(traces.end(), t.begin(), t.end());
+    }
+    if (sps80) {
+        std::vector<Trace> t = makeSyntheticTraces(80, cpg, seed);
+        traces.insert(traces.end(), t.begin(), t.end());
+    }
+    for (size_t i = 0; i < files.size(); i++) {
+        Trace trace;
+        if (!loadTraceCsv(files[i], trace)) {
+            fprintf(stderr, "Khong doc duoc %s\n", files[i].c_str());
+            return 1;
+        }
+        traces.push_back(trace);
+    }
+
+    printHeader(csv);
+    for (size_t t = 0; t < traces.size(); t++) {
+        printTraceTitle(traces[t], csv);
+        for (size_t k = 0; k < VARIANT_COUNT; k++) {
+            const Variant& v = VARIANTS[k];
+            Result r = (v.kind == VARIANT_SETTLE)
+                           ? evaluateSettle(v, traces[t], cpg, repeat)
+                           : evaluateFilter(v, traces[t], cpg, repeat);
+            r.cpuPercent = r.avrCycles * traces[t].sps / AVR_HZ * 100.0;
+            printRow(traces[t], v, r, csv);
+        }
+    }
+    if (!csv) {
+        printf("\n* cau hinh dang dung trong firmware. sot = so buoc khong on dinh / tong so buoc\n");
+    }
+    return 0;
+}
@@ -0,0 +1,192 @@
+/**
+ * @file Traces.cpp
+ * @brief Sinh và đọc chuỗi mẫu cho bench
+ */
+
+#include "Traces.h"
+#include <algorithm>
+#include <math.h>
+#include <random>
+#include <stdio.h>
+#include <utility>
+
+// Mô hình cân giống bộ mô phỏng dây chuyền (sim/BeltSimulator.cpp)
+static const double SCALE_NATURAL_HZ = 4.0;
+static const double SCALE_DAMPING = 0.3;
+static const double NOISE_COUNTS = 30.0;
+
+// Kịch bản: cân rỗng 2 s, có sản phẩm 4 s, cân rỗng 2 s, lặp lại
+static const double EMPTY_S = 2.0;
+static const double LOADED_S = 4.0;
+static const int CYCLES = 4;
+
+/**
+ * Kịch bản của một chuỗi tổng hợp
+ */
+struct Scenario {
+    const char* name;
+    double grams;         ///< Trọng lượng sản phẩm
+    double noise;         ///< Độ lệch chuẩn nhiễu (count)
+    double spikeRate;     ///< Xác suất một mẫu bắt đầu spike
+    int spikeLength;      ///< Số mẫu liên tiếp của mỗi spike
+    double spikeGrams;    ///< Biên độ spike
+};
+
+static Trace makeTrace(const Scenario& sc, unsigned int sps, double cpg, std::mt19937& rng) {
+    Trace trace;
+    trace.name = sc.name;
+    trace.sps = sps;
+    trace.synthetic = true;
+
+    std::normal_distribution<double> noise(0.0, sc.noise);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+
+    const double w = 2.0 * M_PI * SCALE_NATURAL_HZ;
+    const double dt = 0.0005;
+    const double period = 1.0 / sps;
+    double pos = 0, vel = 0, t = 0, nextSample = period;
+    int spikeLeft = 0;
+    double spikeSign = 1;
+
+    double total = CYCLES * (EMPTY_S + LOADED_S) + EMPTY_S;
+    while (t < total) {
+        double phase = fmod(t, EMPTY_S + LOADED_S);
+        bool loaded = (t < CYCLES * (EMPTY_S + LOADED_S)) && phase >= EMPTY_S;
+        double target = loaded ? sc.grams : 0.0;
+
+        double accel = w * w * (target - pos) - 2.0 * SCALE_DAMPING * w * vel;
+        vel += accel * dt;
+        pos += vel * dt;
+        t += dt;
+
+        if (t >= nextSample) {
+            nextSample += period;
+            double value = pos * cpg + noise(rng);
+            if (spikeLeft == 0 && sc.spikeRate > 0 && uniform(rng) < sc.spikeRate) {
+                spikeLeft = sc.spikeLength;
+                spikeSign = uniform(rng) < 0.5 ? -1.0 : 1.0;
+            }
+            if (spikeLeft > 0) {
+                value += spikeSign * sc.spikeGrams * cpg;
+                spikeLeft--;
+            }
+            TraceSample s;
+            s.timeMs = (uint32_t)lround(t * 1000.0);
+            s.raw = (int32_t)lround(value);
+            s.truth = (int32_t)lround(target * cpg);
+            trace.samples.push_back(s);
+        }
+    }
+    return trace;
+}
+
+std::vector<Trace> makeSyntheticTraces(unsigned int sps, double countsPerGram, uint32_t seed) {
+    static const Scenario scenarios[] = {
+        { "step",   150.0, NOISE_COUNTS,       0.0,  0, 0.0 },
+        { "spikes", 150.0, NOISE_COUNTS,       0.02, 1, 60.0 },
+        { "bursts", 150.0, NOISE_COUNTS,       0.02, 2, 60.0 },
+        { "noisy",  150.0, NOISE_COUNTS * 4.0, 0.0,  0, 0.0 },
+        { "light",   20.0, NOISE_COUNTS,       0.0,  0, 0.0 },
+    };
+    std::mt19937 rng(seed);
+    std::vector<Trace> traces;
+    for (size_t i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); i++) {
+        traces.push_back(makeTrace(scenarios[i], sps, countsPerGram, rng));
+    }
+    return traces;
+}
+
+/**
+ * Median trung tâm của 15 mẫu làm giá trị tham chiếu khi không có trọng lượng thật
+ */
+static void fillReferenceTruth(Trace& trace) {
+    const int half = 7;
+    std::vector<int32_t> window;
+    std::vector<int32_t> truth(trace.samples.size());
+    for (size_t i = 0; i < trace.samples.size(); i++) {
+        window.clear();
+        for (int k = -half; k <= half; k++) {
+            long j = (long)i + k;
+            if (j >= 0 && j < (long)trace.samples.size()) {
+                window.push_back(trace.samples[j].raw);
+            }
+        }
+        std::nth_element(window.begin(), window.begin() + window.size() / 2, window.end());
+        truth[i] = window[window.size() / 2];
+    }
+    for (size_t i = 0; i < trace.samples.size(); i++) {
+        trace.samples[i].truth = truth[i];
+    }
+}
+
+bool loadTraceCsv(const std::string& path, Trace& trace) {
+    FILE* file = fopen(path.c_str(), "r");
+    if (file == nullptr) {
+        return false;
+    }
+    trace.name = path;
+    trace.synthetic = false;
+    trace.samples.clear();
+
+    bool hasTruth = false;
+    bool hasTare = false;
+    long tare = 0;
+    // Điểm 0 đổi giữa đoạn ghi (tare lại, tự bám): áp dụng từ mẫu có chỉ số first
+    std::vector<std::pair<size_t, long> > zeroChanges;
+    char line[128];
+    while (fgets(line, sizeof(line), file)) {
+        unsigned long t;
+        long raw, truth, cpgQ8, zero;
+        if (sscanf(line, "# tare=%ld,cpg_q8=%ld", &zero, &cpgQ8) == 2) {
+            // Điểm 0 lúc ghi (tools/telemetry_decode.py --samples-csv)
+            if (!hasTare && trace.samples.empty()) {
+                tare = zero;
+                hasTare = true;
+            } else {
+                zeroChanges.push_back(std::make_pair(trace.samples.size(), zero));
+            }
+            continue;
+        }
+        if (sscanf(line, "# zero=%ld", &zero) == 1) {
+            zeroChanges.push_back(std::make_pair(trace.samples.size(), zero));
+            continue;
+        }
+        int fields = sscanf(line, "%lu,%ld,%ld", &t, &raw, &truth);
+        if (fields < 2) {
+            continue;  // Dòng tiêu đề hoặc dòng trống
+        }
+        TraceSample s;
+        s.timeMs = (uint32_t)t;
+        s.raw = (int32_t)raw;
+        s.truth = (fields == 3) ? (int32_t)truth : 0;
+        hasTruth = hasTruth || fields == 3;
+        trace.samples.push_back(s);
+    }
+    fclose(file);
+    if (trace.samples.size() < 2) {
+        return false;
+    }
+
+    uint32_t span = trace.samples.back().timeMs - trace.samples.front().timeMs;
+    trace.sps = span ? (unsigned int)lround((trace.samples.size() - 1) * 1000.0 / span) : 10;
+
+    if (!hasTruth) {
+        // Trừ điểm 0 lúc ghi, nếu không có thì median của 10 mẫu đầu (cân rỗng)
+        std::vector<int32_t> head;
+        for (size_t i = 0; i < trace.samples.size() && i < 10; i++) {
+            head.push_back(trace.samples[i].raw);
+        }
+        std::nth_element(head.begin(), head.begin() + head.size() / 2, head.end());
+        int32_t zero = hasTare ? (int32_t)tare : head[head.size() / 2];
+        size_t change = 0;
+        for (size_t i = 0; i < trace.samples.size(); i++) {
+            while (change < zeroChanges.size() && zeroChanges[change].first <= i) {
+                zero = (int32_t)zeroChanges[change].second;
+                change++;
+            }
+            trace.samples[i].raw -= zero;
+        }
+        fillReferenceTruth(trace);
+    }
+    return true;
+}
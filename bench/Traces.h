@@ -0,0 +1,54 @@
+/**
+ * @file Traces.h
+ * @brief Chuỗi mẫu HX711 dùng cho bench: tổng hợp (biết trọng lượng thật) và ghi lại
+ * @author FTH Arduino Uno Project
+ * @date 2026
+ */
+
+#ifndef BENCH_TRACES_H
+#define BENCH_TRACES_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Một mẫu: thời điểm, giá trị đã trừ điểm 0 và giá trị tĩnh thật (count)
+ */
+struct TraceSample {
+    uint32_t timeMs;
+    int32_t raw;
+    int32_t truth;
+};
+
+/**
+ * @brief Một chuỗi mẫu có tên
+ */
+struct Trace {
+    std::string name;
+    unsigned int sps;
+    bool synthetic;   ///< false: truth là median trung tâm 15 mẫu của dữ liệu ghi lại
+    std::vector<TraceSample> samples;
+};
+
+/**
+ * @brief Sinh các chuỗi tổng hợp ở một tốc độ lấy mẫu
+ * @details Cân bậc hai 4 Hz, hệ số cản 0.3, nhiễu Gauss; các chuỗi:
+ *          step (đặt/lấy 150 g), spikes (spike đơn ±60 g), bursts (spike 2 mẫu liền),
+ *          noisy (nhiễu gấp 4), light (sản phẩm 20 g sát ngưỡng)
+ * @param sps Tốc độ lấy mẫu (10 hoặc 80)
+ * @param countsPerGram Hệ số hiệu chuẩn (count/gram)
+ * @param seed Hạt giống ngẫu nhiên
+ */
+std::vector<Trace> makeSyntheticTraces(unsigned int sps, double countsPerGram, uint32_t seed);
+
+/**
+ * @brief Đọc chuỗi ghi lại dạng CSV: "t_ms,raw" hoặc "t_ms,raw,truth" (count)
+ * @details Nếu không có cột truth, raw được trừ điểm 0 ở dòng "# tare=.." (nếu có) hoặc
+ *          median của 10 mẫu đầu (cân rỗng), đổi theo các dòng "# zero=.." và "# tare=.."
+ *          giữa đoạn ghi; tham chiếu là median trung tâm 15 mẫu
+ * @return false nếu không đọc được file
+ */
+bool loadTraceCsv(const std::string& path, Trace& trace);
+
+#endif
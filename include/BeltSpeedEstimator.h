@@ -0,0 +1,94 @@
+/**
+ * @file BeltSpeedEstimator.h
+ * @brief Ước lượng tốc độ băng chuyền từ thời gian sản phẩm đạt chuẩn đi tới cảm biến cuối
+ * @author FTH Arduino Uno Project
+ * @date 2026
+ *
+ * Mỗi sản phẩm đạt chuẩn được đẩy lên băng chuyền tại thời điểm đã biết, rồi che cảm
+ * biến IR cuối băng chuyền. Sản phẩm trên băng không vượt nhau, nên cạnh IR thứ k ứng
+ * với sản phẩm đạt chuẩn thứ k chưa tới: ghép theo thứ tự (FIFO) cho ra một lần đo thời
+ * gian đẩy -> cảm biến cuối. Lần đo lệch quá BELT_MATCH_RATIO lần so với ước lượng là
+ * ghép sai (sản phẩm bị lấy ra tay, vật lạ che cảm biến) và bị bỏ.
+ *
+ * Vị trí servo 2 và cảm biến cuối cố định trên băng, nên thời gian tới servo 2 tỉ lệ
+ * với thời gian tới cảm biến cuối: transit = TRANSIT_TIME_MS * đo / EXIT_TIME_MS.
+ * Băng chạy nhanh/chậm hơn thiết kế thì servo 2 gạt theo tốc độ đo được, không phải
+ * chỉnh lại hằng số trong firmware. Không có cảm biến cuối thì ước lượng giữ danh định.
+ */
+
+#ifndef BELT_SPEED_ESTIMATOR_H
+#define BELT_SPEED_ESTIMATOR_H
+
+#include "Hal.h"
+
+// Thời gian từ lúc servo 1 đẩy xong tới lúc sản phẩm che cảm biến cuối (ms) ở tốc độ
+// băng thiết kế - cùng tốc độ với TRANSIT_TIME_MS (chỉnh cả hai khi đổi vị trí cảm biến)
+constexpr unsigned long EXIT_TIME_MS = 2400;
+
+// Số sản phẩm đạt chuẩn chờ tới cảm biến cuối (băng chuyền + đoạn sau servo 2)
+constexpr uint8_t BELT_PENDING_CAPACITY = 8;
+
+// Lần đo nằm ngoài [ước lượng / tỉ lệ, ước lượng * tỉ lệ] bị coi là ghép sai;
+// ước lượng cũng bị giới hạn trong [danh định / tỉ lệ, danh định * tỉ lệ]
+constexpr uint8_t BELT_MATCH_RATIO = 4;
+
+// Trọng số của lần đo mới trong trung bình trượt: 1 / BELT_SMOOTHING
+constexpr int32_t BELT_SMOOTHING = 4;
+
+class BeltSpeedEstimator {
+private:
+    uint32_t pending[BELT_PENDING_CAPACITY];  ///< micros() lúc đẩy của các sản phẩm đạt chuẩn chờ tới cảm biến
+    uint8_t head;                             ///< Sản phẩm đẩy sớm nhất
+    uint8_t count;                            ///< Số sản phẩm đang chờ
+    int32_t exitUs;                           ///< Ước lượng thời gian đẩy -> cảm biến cuối (µs)
+    uint32_t lastExitUs;                      ///< Lần đo được chấp nhận gần nhất (µs)
+    uint16_t matched;                         ///< Số lần đo được chấp nhận
+
+public:
+    /**
+     * @brief Constructor - ước lượng bắt đầu ở tốc độ danh định
+     */
+    BeltSpeedEstimator();
+
+    /**
+     * @brief Sản phẩm đạt chuẩn được đẩy lên băng chuyền
+     * @param pushUs micros() lúc sản phẩm rời cân (có thể ở tương lai gần)
+     * @details Hàng đợi đầy (cảm biến cuối hỏng) thì bỏ sản phẩm cũ nhất
+     */
+    void expect(uint32_t pushUs);
+
+    /**
+     * @brief Cảm biến cuối bị che
+     * @param edgeUs micros() lúc bị che (IrSensor)
+     * @return true nếu ghép được với một sản phẩm và ước lượng đã cập nhật
+     */
+    bool observe(uint32_t edgeUs);
+
+    /**
+     * @brief Đổi một thời gian trên băng ở tốc độ danh định sang tốc độ đo được
+     * @param nominalMs Thời gian ở tốc độ thiết kế (ví dụ TRANSIT_TIME_MS)
+     */
+    unsigned long scale(unsigned long nominalMs) const;
+
+    /**
+     * @brief Ước lượng thời gian đẩy -> cảm biến cuối (ms)
+     */
+    uint16_t getExitMs() const;
+
+    /**
+     * @brief Lần đo được chấp nhận gần nhất (ms, 0 nếu chưa có)
+     */
+    uint16_t getLastExitMs() const;
+
+    /**
+     * @brief Tốc độ băng so với thiết kế (%)
+     */
+    uint16_t getSpeedPercent() const;
+
+    /**
+     * @brief Số lần đo được chấp nhận
+     */
+    uint16_t getMatchCount() const;
+};
+
+#endif
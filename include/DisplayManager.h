@@ -6,27 +6,60 @@
  * 
  * Class này quản lý việc hiển thị thông tin lên màn hình LCD 16x2 qua giao thức I2C.
  * Hiển thị trọng lượng sản phẩm và trạng thái hệ thống cho người dùng.
+ * 
+ * Các hàm print/displayWeight chỉ ghi vào bộ đệm trong RAM (frame). flush() so sánh
+ * frame với nội dung LCD đang hiển thị (shown) và chỉ gửi các ô thay đổi, mỗi lần gọi
+ * một ít ô trong giới hạn thời gian, để LCD không chiếm nhiều thời gian của vòng lặp.
  */
 
 #ifndef DISPLAY_MANAGER_H
 #define DISPLAY_MANAGER_H
 
-#include <Arduino.h>
-#include "LiquidCrystal_I2C.h"
+#include "Hal.h"
+
+// Kích thước tối đa của bộ đệm màn hình (LCD 16x2)
+constexpr uint8_t DISPLAY_MAX_COLUMNS = 16;
+constexpr uint8_t DISPLAY_MAX_ROWS = 2;
+
+// Thời gian tối đa cho mỗi lần flush (µs) - mỗi ký tự qua I2C mất khoảng 0.5 ms
+constexpr unsigned int DISPLAY_FLUSH_BUDGET_US = 1000;
+
+// Số cột của một ô khi hiển thị nhiều làn (mỗi hàng 2 ô, ví dụ "1:123.4 ")
+constexpr uint8_t DISPLAY_LANE_CELL_COLUMNS = 8;
+
+// Bộ đệm định dạng số: dấu, 10 chữ số của long, dấu chấm, '\0'
+constexpr uint8_t DISPLAY_NUMBER_BUFFER = 16;
+
+// Số chữ số thập phân tối đa của printNumber
+constexpr uint8_t DISPLAY_MAX_DECIMALS = 4;
+
+// Thời gian hiển thị thông báo khởi động (ms)
+constexpr unsigned long DISPLAY_SPLASH_TIME_MS = 2000;
 
 class DisplayManager {
 private:
-    LiquidCrystal_I2C lcd;  ///< Đối tượng LCD I2C để giao tiếp với màn hình
+    HalDisplay lcd;         ///< Đối tượng LCD I2C để giao tiếp với màn hình
     int address;            ///< Địa chỉ I2C của LCD (thường là 0x27 hoặc 0x3F)
     int columns;            ///< Số cột của LCD (16 cho LCD 16x2)
     int rows;               ///< Số hàng của LCD (2 cho LCD 16x2)
+    
+    char frame[DISPLAY_MAX_ROWS][DISPLAY_MAX_COLUMNS];  ///< Nội dung cần hiển thị
+    char shown[DISPLAY_MAX_ROWS][DISPLAY_MAX_COLUMNS];  ///< Nội dung LCD đang hiển thị
+    uint8_t writeCol;           ///< Vị trí ghi tiếp theo trong frame (cột)
+    uint8_t writeRow;           ///< Vị trí ghi tiếp theo trong frame (hàng)
+    int8_t lcdCol;              ///< Vị trí con trỏ thật của LCD (-1 nếu chưa biết)
+    int8_t lcdRow;              ///< Hàng của con trỏ thật của LCD
+    uint8_t scanIndex;          ///< Ô bắt đầu quét ở lần flush tiếp theo
+    uint8_t laneCount;          ///< Số làn hiển thị (1: bố cục một cân, >1: mỗi làn một ô)
+    bool splashActive;          ///< Đang hiển thị thông báo khởi động
+    unsigned long splashStart;  ///< Thời điểm (millis) bắt đầu thông báo khởi động
 
 public:
     /**
      * @brief Constructor - Khởi tạo DisplayManager với thông số LCD
      * @param address Địa chỉ I2C của LCD (kiểm tra bằng I2C scanner)
-     * @param columns Số cột của LCD
-     * @param rows Số hàng của LCD
+     * @param columns Số cột của LCD (tối đa DISPLAY_MAX_COLUMNS)
+     * @param rows Số hàng của LCD (tối đa DISPLAY_MAX_ROWS)
      */
     DisplayManager(int address, int columns, int rows);
     
@@ -38,34 +71,119 @@ public:
     
     /**
      * @brief Xóa toàn bộ nội dung trên màn hình
+     * @details Chỉ xóa bộ đệm; các ô thay đổi được gửi dần qua flush()
      */
     void clear();
     
     /**
      * @brief Hiển thị chuỗi text tại vị trí con trỏ hiện tại
-     * @param text Nội dung cần hiển thị
+     * @param text Chuỗi kết thúc bằng '\0' (bộ đệm char, không dùng String/heap)
      */
-    void print(const String& text);
+    void print(const char* text);
     
     /**
      * @brief Hiển thị chuỗi text tại vị trí chỉ định
-     * @param text Nội dung cần hiển thị
+     * @param text Chuỗi kết thúc bằng '\0'
      * @param col Cột bắt đầu (0-15)
      * @param row Hàng (0-1)
      */
-    void print(const String& text, int col, int row);
+    void print(const char* text, int col, int row);
+    
+    /**
+     * @brief Hiển thị chuỗi trong Flash (message(), F()) tại vị trí con trỏ hiện tại
+     */
+    void print(const __FlashStringHelper* text);
+    
+    /**
+     * @brief Hiển thị chuỗi trong Flash tại vị trí chỉ định
+     */
+    void print(const __FlashStringHelper* text, int col, int row);
+    
+    /**
+     * @brief Hiển thị số nguyên có dấu chấm thập phân cố định tại vị trí con trỏ hiện tại
+     * @param value Giá trị đã nhân 10^decimals (ví dụ 12345 với decimals = 2 -> "123.45")
+     * @param decimals Số chữ số thập phân (0..DISPLAY_MAX_DECIMALS)
+     */
+    void printNumber(long value, uint8_t decimals = 0);
+    
+    /**
+     * @brief Như printNumber(value, decimals) nhưng tại vị trí chỉ định
+     */
+    void printNumber(long value, uint8_t decimals, int col, int row);
+    
+    /**
+     * @brief Đặt số làn hiển thị (gọi trước init)
+     * @param count Số làn; nhiều hơn số ô trên màn hình thì các làn thừa không hiển thị
+     */
+    void setLaneCount(uint8_t count);
     
     /**
      * @brief Hiển thị trọng lượng đo được lên màn hình
      * @param weight Trọng lượng tính bằng gram
+     * @param lane Làn của sản phẩm; khi có nhiều làn chỉ ô của làn đó được ghi lại
+     * @param trend Ký hiệu xu hướng ở cột cuối của hàng/ô (ProcessStats::getTrend)
      */
-    void displayWeight(float weight);
+    void displayWeight(float weight, uint8_t lane = 0, char trend = ' ');
     
     /**
      * @brief Hiển thị thông báo hệ thống sẵn sàng
-     * @details Hiển thị "SYSTEM READY..." trong 2 giây rồi xóa màn hình
+     * @details Hiển thị "SYSTEM READY..." trong DISPLAY_SPLASH_TIME_MS rồi tự xóa
+     *          (qua update()), không chặn vòng lặp
      */
     void showStartupMessage();
+    
+    /**
+     * @brief Gửi các ô thay đổi xuống LCD trong giới hạn thời gian
+     * @param budgetUs Thời gian tối đa (µs); luôn gửi ít nhất một ô nếu có thay đổi
+     * @return true nếu LCD đã khớp hoàn toàn với bộ đệm
+     */
+    bool flush(unsigned int budgetUs = DISPLAY_FLUSH_BUDGET_US);
+    
+    /**
+     * @brief Cập nhật màn hình - gọi ở mỗi vòng lặp
+     * @details Xóa thông báo khởi động khi hết thời gian rồi flush()
+     */
+    void update();
+
+private:
+    /**
+     * @brief Ghi một ký tự vào bộ đệm tại vị trí ghi và tiến vị trí ghi
+     */
+    void putChar(char c);
+    
+    /**
+     * @brief Ghi chuỗi vào bộ đệm tại vị trí ghi
+     */
+    void putText(const char* text);
+    
+    /**
+     * @brief Ghi chuỗi trong Flash vào bộ đệm (đọc từng byte bằng pgm_read_byte)
+     */
+    void putText(const __FlashStringHelper* text);
+    
+    /**
+     * @brief Điền khoảng trắng tới cuối hàng hiện tại
+     */
+    void padRow();
+    
+    /**
+     * @brief Điền khoảng trắng tới cột chỉ định (không vượt cuối hàng)
+     */
+    void padTo(uint8_t col);
+    
+    /**
+     * @brief Định dạng trọng lượng bằng số nguyên (không dùng String/dtostrf)
+     * @param weight Trọng lượng (gram)
+     * @param decimals Số chữ số thập phân (1 hoặc 2)
+     * @param buffer Bộ đệm nhận chuỗi (tối thiểu DISPLAY_NUMBER_BUFFER ký tự)
+     */
+    static void formatWeight(float weight, uint8_t decimals, char* buffer);
+    
+    /**
+     * @brief Định dạng số nguyên đã nhân 10^decimals thành "<nguyên>.<thập phân>"
+     * @param buffer Bộ đệm nhận chuỗi (tối thiểu DISPLAY_NUMBER_BUFFER ký tự)
+     */
+    static void formatFixed(long value, uint8_t decimals, char* buffer);
 };
 
 #endif
@@ -0,0 +1,107 @@
+/**
+ * @file FastPin.h
+ * @brief Truy cập một chân GPIO cố định lúc biên dịch
+ * @author FTH Arduino Uno Project
+ * @date 2026
+ *
+ * FastPin<PIN> tính địa chỉ PINx/DDRx/PORTx và bit của chân từ sơ đồ chân của Uno
+ * (halPinPort/halPinMask). Địa chỉ và bit đều là hằng số nên avr-gcc dịch read() thành
+ * một lệnh sbis/sbic, high()/low() thành một lệnh sbi/cbi (2 chu kỳ), không tra bảng
+ * PROGMEM như digitalRead()/digitalWrite() và không cần con trỏ thanh ghi trong RAM.
+ *
+ * Ngoài board (bộ mô phỏng) các hàm gọi digitalRead()/digitalWrite() của HAL native để
+ * mô phỏng vẫn thấy từng cạnh.
+ */
+
+#ifndef FAST_PIN_H
+#define FAST_PIN_H
+
+#include "Hal.h"
+
+#if defined(ARDUINO) && defined(__AVR_ATmega328P__)
+#define FAST_PIN_DIRECT 1
+#else
+#define FAST_PIN_DIRECT 0
+#endif
+
+/**
+ * Địa chỉ (vùng nhớ dữ liệu) của PINx; DDRx = PINx + 1, PORTx = PINx + 2.
+ * ATmega328P: PINB 0x23, PINC 0x26, PIND 0x29
+ */
+constexpr uint8_t fastPinInputAddress(uint8_t pin) {
+    return (uint8_t)(0x23 + 3 * (halPinPort(pin) - PB));
+}
+
+template <uint8_t PIN>
+class FastPin {
+    static_assert(PIN < 20, "FastPin chi ho tro chan 0..19 cua Uno");
+
+    static constexpr uint8_t MASK = halPinMask(PIN);
+    static constexpr uint8_t PIN_ADDRESS = fastPinInputAddress(PIN);
+
+public:
+    /**
+     * @brief Đặt chân là đầu vào (không kéo lên)
+     */
+    static inline void input() {
+#if FAST_PIN_DIRECT
+        reg(PIN_ADDRESS + 1) &= (uint8_t)~MASK;
+        reg(PIN_ADDRESS + 2) &= (uint8_t)~MASK;
+#else
+        pinMode(PIN, INPUT);
+#endif
+    }
+
+    /**
+     * @brief Đặt chân là đầu ra
+     */
+    static inline void output() {
+#if FAST_PIN_DIRECT
+        reg(PIN_ADDRESS + 1) |= MASK;
+#else
+        pinMode(PIN, OUTPUT);
+#endif
+    }
+
+    /**
+     * @brief Mức hiện tại của chân (sbis/sbic)
+     */
+    static inline bool read() {
+#if FAST_PIN_DIRECT
+        return (reg(PIN_ADDRESS) & MASK) != 0;
+#else
+        return digitalRead(PIN) == HIGH;
+#endif
+    }
+
+    /**
+     * @brief Kéo chân lên mức cao (sbi)
+     */
+    static inline void high() {
+#if FAST_PIN_DIRECT
+        reg(PIN_ADDRESS + 2) |= MASK;
+#else
+        digitalWrite(PIN, HIGH);
+#endif
+    }
+
+    /**
+     * @brief Kéo chân xuống mức thấp (cbi)
+     */
+    static inline void low() {
+#if FAST_PIN_DIRECT
+        reg(PIN_ADDRESS + 2) &= (uint8_t)~MASK;
+#else
+        digitalWrite(PIN, LOW);
+#endif
+    }
+
+private:
+#if FAST_PIN_DIRECT
+    static inline volatile uint8_t& reg(uint8_t address) {
+        return *(volatile uint8_t*)(uintptr_t)address;
+    }
+#endif
+};
+
+#endif
@@ -0,0 +1,114 @@
+/**
+ * @file GradeEngine.h
+ * @brief Phân hạng sản phẩm theo bảng cận trọng lượng trong Flash, tra bằng tìm kiếm nhị phân
+ * @author FTH Arduino Uno Project
+ * @date 2026
+ *
+ * Bảng phân hạng là một mảng GradeBand trong PROGMEM, cận dưới tăng dần: hạng i gồm
+ * các trọng lượng từ cận dưới của nó tới trước cận dưới của hạng i+1, hạng 0 không có
+ * cận dưới. Mỗi hạng chọn cơ cấu xử lý sản phẩm (đi hết băng chuyền hoặc servo 2 gạt)
+ * và tên in ra Serial. Bảng cũ [min, max] là bảng 3 hạng: quá nhẹ, đạt, quá nặng.
+ *
+ * Cận được đổi sang count một lần cho mỗi làn (hệ số hiệu chuẩn riêng) rồi tra bằng tìm
+ * kiếm nhị phân trên int32: MAX_GRADES hạng tốn tối đa 3 phép so sánh. Cận, bộ đếm
+ * từng hạng đều là mảng cố định MAX_GRADES phần tử, thêm hạng không tốn RAM hay thời
+ * gian vòng lặp.
+ */
+
+#ifndef GRADE_ENGINE_H
+#define GRADE_ENGINE_H
+
+#include "Hal.h"
+#include "Messages.h"
+
+// Số hạng tối đa của một bảng
+constexpr uint8_t MAX_GRADES = 6;
+
+// Cơ cấu xử lý sản phẩm của một hạng
+enum EjectAction : uint8_t {
+    EJECT_NONE = 0,     // Đi hết băng chuyền (cảm biến cuối đếm)
+    EJECT_SERVO_2 = 1   // Servo 2 gạt ra khỏi băng chuyền
+};
+
+/**
+ * @brief Một hạng của bảng phân hạng (phần tử trong PROGMEM)
+ */
+struct GradeBand {
+    float fromGrams;    ///< Cận dưới (gram, tính cả cận), tăng dần; bỏ qua ở hạng đầu
+    uint8_t action;     ///< EjectAction của hạng
+    uint8_t name;       ///< MessageId tên hạng (Serial)
+};
+
+class GradeEngine {
+private:
+    const GradeBand* table;                 ///< Bảng trong PROGMEM
+    uint8_t gradeCount;                     ///< Số hạng (1..MAX_GRADES)
+    uint8_t firstPassGrade;                 ///< Hạng đầu tiên không bị gạt (để suy ra Verdict)
+    int32_t lowerBounds[MAX_GRADES - 1];    ///< Cận dưới của hạng 1..n-1 (count), tăng dần
+    uint16_t counts[MAX_GRADES];            ///< Số sản phẩm mỗi hạng (tràn vòng)
+
+public:
+    /**
+     * @brief Constructor - chỉ lưu bảng, cận được đổi sang count trong setLowerBound()
+     * @param table Mảng GradeBand trong PROGMEM, cận dưới tăng dần
+     * @param gradeCount Số phần tử (giới hạn MAX_GRADES)
+     */
+    GradeEngine(const GradeBand* table, uint8_t gradeCount);
+
+    /**
+     * @brief Số hạng của bảng
+     */
+    uint8_t getGradeCount() const;
+
+    /**
+     * @brief Cận dưới của một hạng trong bảng (gram)
+     * @param grade Hạng 1..n-1
+     */
+    float getFromGrams(uint8_t grade) const;
+
+    /**
+     * @brief Đặt cận dưới của một hạng đã đổi sang count (khi khởi tạo hoặc đổi hệ số)
+     * @param grade Hạng 1..n-1
+     * @param counts Cận dưới (count đã trừ điểm 0)
+     */
+    void setLowerBound(uint8_t grade, int32_t counts);
+
+    /**
+     * @brief Các cận sau khi đổi sang count có tăng dần không (bảng cấu hình sai)
+     */
+    bool isSorted() const;
+
+    /**
+     * @brief Hạng của một trọng lượng (tìm kiếm nhị phân trên cận dưới)
+     * @param rawWeight Trọng lượng (count)
+     */
+    uint8_t classify(int32_t rawWeight) const;
+
+    /**
+     * @brief Đếm một sản phẩm vào hạng
+     */
+    void count(uint8_t grade);
+
+    /**
+     * @brief Cơ cấu xử lý sản phẩm của hạng (EjectAction)
+     */
+    uint8_t getAction(uint8_t grade) const;
+
+    /**
+     * @brief Tên hạng (ID thông báo trong Flash)
+     */
+    MessageId getName(uint8_t grade) const;
+
+    /**
+     * @brief Verdict gửi telemetry: đạt nếu không bị gạt, còn lại quá nhẹ/quá nặng
+     *        theo vị trí so với hạng đạt đầu tiên
+     */
+    uint8_t getVerdict(uint8_t grade) const;
+
+    /**
+     * @brief Số sản phẩm của hạng
+     */
+    uint16_t getCount(uint8_t grade) const;
+};
+
+#endif
@@ -0,0 +1,65 @@
+/**
+ * @file Hal.h
+ * @brief Lớp trừu tượng phần cứng (HAL) mỏng cho firmware
+ * @author FTH Arduino Uno Project
+ * @date 2026
+ * 
+ * Firmware chỉ dùng các tên được liệt kê dưới đây, không include trực tiếp
+ * Arduino.h/Servo.h/LiquidCrystal_I2C.h trong các module:
+ * - Đồng hồ: millis(), micros(), delayMicroseconds()
+ * - GPIO: pinMode(), digitalRead(), digitalWrite(), attachInterrupt(), detachInterrupt(),
+ *   digitalPinToInterrupt(), noInterrupts(), interrupts()
+ * - Ngắt đổi mức chân (IrSensor): PCICR/PCMSKx và ISR(PCINTn_vect) trên AVR,
+ *   halAttachPinChange() trong native
+ * - Thanh ghi cổng: digitalPinToPort(), digitalPinToBitMask(), portInputRegister(),
+ *   portOutputRegister() và kiểu HalPortRegister (đọc/ghi 8 chân của một cổng một lần);
+ *   halPinPort()/halPinMask() tính cổng/bit lúc biên dịch (sơ đồ chân của Uno)
+ * - Serial: HardwareSerial / Print, đối tượng Serial
+ * - EEPROM: eeprom_read_byte(), eeprom_update_byte(), eeprom_is_ready() của avr-libc,
+ *   E2END (địa chỉ byte cuối)
+ * - Thiết bị: HalServo (API của Servo), HalDisplay (API của LiquidCrystal_I2C);
+ *   HX711 được đọc trực tiếp qua thanh ghi cổng (Hx711Driver)
+ * 
+ * Trên board (ARDUINO được định nghĩa) các tên này là của Arduino core và các thư viện,
+ * không tốn thêm lệnh nào. Trong môi trường native (pio run -e native) chúng được
+ * cài đặt bởi bộ mô phỏng băng chuyền trong thư mục sim/.
+ */
+
+#ifndef HAL_H
+#define HAL_H
+
+#ifdef ARDUINO
+
+#include <Arduino.h>
+#include <avr/eeprom.h>
+#include <Servo.h>
+#include <LiquidCrystal_I2C.h>
+
+typedef Servo HalServo;
+typedef LiquidCrystal_I2C HalDisplay;
+typedef volatile uint8_t HalPortRegister;
+
+#else
+
+#include "HalNative.h"
+
+#endif
+
+/**
+ * Cổng của chân trên ATmega328P (Uno/Nano): D0..D7 = PORTD, D8..D13 = PORTB,
+ * A0..A5 (14..19) = PORTC, chân khác = NOT_A_PORT. Khác digitalPinToPort() (tra bảng
+ * trong PROGMEM), hàm constexpr được tính lúc biên dịch khi số chân là hằng số
+ */
+constexpr uint8_t halPinPort(uint8_t pin) {
+    return pin < 8 ? PD : (pin < 14 ? PB : (pin < 20 ? PC : NOT_A_PORT));
+}
+
+/**
+ * Bit của chân trong thanh ghi PINx/PORTx của cổng đó (0 nếu không phải chân của Uno)
+ */
+constexpr uint8_t halPinMask(uint8_t pin) {
+    return pin < 8 ? (uint8_t)(1 << pin)
+                   : (pin < 14 ? (uint8_t)(1 << (pin - 8)) : (pin < 20 ? (uint8_t)(1 << (pin - 14)) : 0));
+}
+
+#endif
@@ -0,0 +1,142 @@
+/**
+ * @file Hx711Driver.h
+ * @brief Đọc một HX711 bằng thanh ghi cổng, thay cho thư viện bogde/HX711
+ * @author FTH Arduino Uno Project
+ * @date 2026
+ *
+ * Thư viện HX711 dịch bit bằng digitalWrite()/digitalRead() (mỗi lần gọi tra bảng chân
+ * trong PROGMEM, tắt PWM, lưu SREG...) và tắt ngắt trong suốt 25 xung SCK. Driver này
+ * tính cổng/bit của DOUT và SCK từ số chân (halPinPort/halPinMask, constexpr), lấy địa
+ * chỉ thanh ghi một lần trong begin(), mỗi xung SCK chỉ còn vài lệnh đọc/ghi thanh ghi.
+ *
+ * Giới hạn thời gian của HX711 chỉ áp dụng khi SCK ở mức cao (quá 60 µs thì HX711 vào
+ * chế độ power-down); SCK ở mức thấp bao lâu cũng được. Vì vậy read() chỉ tắt ngắt trong
+ * từng xung (khoảng 1 µs), ngắt đến giữa hai bit chỉ làm lần đọc dài thêm.
+ *
+ * Khi chân là hằng số (main.cpp), makeHx711Driver<DOUT, SCK>() gắn thêm hàm dịch bit
+ * sinh theo từng cặp chân (FastPin): mỗi xung chỉ còn sbi/sbis/cbi và chờ vài chu kỳ.
+ */
+
+#ifndef HX711_DRIVER_H
+#define HX711_DRIVER_H
+
+#include "Hal.h"
+#include "FastPin.h"
+
+// Số bit dữ liệu mỗi lần đọc HX711
+constexpr uint8_t HX711_DATA_BITS = 24;
+
+// Số xung SCK thêm sau 24 bit dữ liệu: 1 = kênh A, gain 128
+constexpr uint8_t HX711_GAIN_PULSES = 1;
+
+#if FAST_PIN_DIRECT
+// SCK cao tối thiểu 0.2 µs, DOUT đúng sau 0.1 µs: chờ 0.25 µs trước khi đọc bit
+constexpr unsigned long HX711_SCK_HIGH_CYCLES = F_CPU / 4000000UL;
+#endif
+
+// Hàm dịch 24 bit + xung gain của một cặp chân cố định (xem hx711ShiftInFixed)
+typedef int32_t (*Hx711ShiftInFn)(bool guardPulses);
+
+class Hx711Driver {
+private:
+    int doutPin;                      ///< Chân DATA OUT
+    int sckPin;                       ///< Chân SERIAL CLOCK
+    uint8_t doutMask;                 ///< Bit của DOUT trong PINx (tính lúc biên dịch nếu chân là hằng)
+    uint8_t sckMask;                  ///< Bit của SCK trong PORTx
+    HalPortRegister* doutPort;        ///< Thanh ghi PINx của DOUT (gán trong begin)
+    HalPortRegister* sckPort;         ///< Thanh ghi PORTx của SCK (gán trong begin)
+    Hx711ShiftInFn fixedShiftIn;      ///< Hàm dịch bit sinh cho chân cố định (nullptr: dùng thanh ghi ở trên)
+
+public:
+    /**
+     * @brief Constructor - tính bit của các chân, chưa chạm vào phần cứng
+     * @param doutPin Chân DATA OUT của HX711
+     * @param sckPin Chân SERIAL CLOCK của HX711
+     * @param fixedShiftIn Hàm dịch bit cho đúng cặp chân này (dùng makeHx711Driver)
+     */
+    Hx711Driver(int doutPin, int sckPin, Hx711ShiftInFn fixedShiftIn = nullptr);
+
+    /**
+     * @brief Chân DATA OUT (để gắn ngắt ngoài)
+     */
+    int getDoutPin() const;
+
+    /**
+     * @brief Cấu hình chân và lấy địa chỉ thanh ghi; SCK thấp để HX711 hoạt động
+     */
+    void begin();
+
+    /**
+     * @brief HX711 đã chuyển đổi xong (DOUT thấp) - một lần đọc thanh ghi
+     */
+    bool isReady() const;
+
+    /**
+     * @brief Chờ bận có giới hạn thời gian, chỉ dùng lúc khởi động/tare
+     * @param timeoutMs Thời gian chờ tối đa (ms)
+     * @return false nếu hết thời gian (HX711 mất nguồn hoặc đứt dây)
+     */
+    bool waitReady(unsigned long timeoutMs);
+
+    /**
+     * @brief Đọc một chuyển đổi (kênh A, gain 128), gọi khi isReady()
+     * @return Giá trị thô 24 bit đã mở rộng dấu (count)
+     * @details Ngắt chỉ bị tắt trong từng xung SCK, không phải cả lần đọc
+     */
+    int32_t read();
+
+    /**
+     * @brief Như read() nhưng không bật/tắt ngắt - gọi khi ngắt đã tắt sẵn (trong ISR)
+     */
+    int32_t readLocked();
+
+private:
+    /**
+     * @brief Dịch 24 bit (MSB trước) và các xung chọn gain
+     * @param guardPulses true: tắt ngắt trong từng xung SCK rồi bật lại
+     */
+    int32_t shiftIn(bool guardPulses);
+};
+
+/**
+ * @brief Dịch bit của HX711 trên cặp chân cố định lúc biên dịch
+ * @details Giống Hx711Driver::shiftIn nhưng mọi truy cập chân là một lệnh (FastPin), SCK
+ *          cao đúng HX711_SCK_HIGH_CYCLES thay cho delayMicroseconds(1)
+ */
+template <uint8_t DOUT, uint8_t SCK>
+int32_t hx711ShiftInFixed(bool guardPulses) {
+    uint32_t value = 0;
+    for (uint8_t i = 0; i < HX711_DATA_BITS + HX711_GAIN_PULSES; i++) {
+        if (guardPulses) {
+            noInterrupts();
+        }
+        FastPin<SCK>::high();
+#if FAST_PIN_DIRECT
+        __builtin_avr_delay_cycles(HX711_SCK_HIGH_CYCLES);
+#endif
+        bool level = FastPin<DOUT>::read();
+        FastPin<SCK>::low();
+        if (guardPulses) {
+            interrupts();
+        }
+        if (i < HX711_DATA_BITS) {
+            value = (value << 1) | (level ? 1 : 0);
+        }
+    }
+
+    // Mở rộng dấu từ 24 bit sang 32 bit
+    if (value & 0x800000UL) {
+        value |= 0xFF000000UL;
+    }
+    return (int32_t)value;
+}
+
+/**
+ * @brief Tạo Hx711Driver cho cặp chân là hằng số, dùng hx711ShiftInFixed<DOUT, SCK>
+ */
+template <uint8_t DOUT, uint8_t SCK>
+inline Hx711Driver makeHx711Driver() {
+    return Hx711Driver(DOUT, SCK, &hx711ShiftInFixed<DOUT, SCK>);
+}
+
+#endif
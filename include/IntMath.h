@@ -0,0 +1,21 @@
+/**
+ * @file IntMath.h
+ * @brief Hàm số học nguyên dùng chung, thay cho sqrt() float trên AVR
+ * @author FTH Arduino Uno Project
+ * @date 2026
+ */
+
+#ifndef INT_MATH_H
+#define INT_MATH_H
+
+#include "Hal.h"
+
+/**
+ * @brief Căn bậc hai nguyên, làm tròn xuống
+ * @details Từng bit: 16 vòng dịch, so sánh và trừ, không có phép chia
+ * @param value Số cần lấy căn
+ * @return floor(sqrt(value)), vừa uint16
+ */
+uint16_t isqrt32(uint32_t value);
+
+#endif
@@ -0,0 +1,103 @@
+/**
+ * @file IrSensor.h
+ * @brief Cảm biến IR đọc bằng ngắt đổi mức chân (PCINT), ghi thời điểm từng lần bị che
+ * @author FTH Arduino Uno Project
+ * @date 2026
+ *
+ * Đọc digitalRead() mỗi vòng lặp chỉ thấy sản phẩm nếu vòng lặp quay lại trong lúc nó
+ * còn che cảm biến, và thời điểm sai lệch cả một vòng lặp. Ở đây mọi chân IR dùng ngắt
+ * đổi mức: ISR đọc thanh ghi PINx, mỗi cạnh xuống (bị che, cảm biến kéo xuống thấp) ghi
+ * micros() vào hàng đợi của cảm biến đó. Vòng lặp chính lấy ra sau, thời điểm vẫn đúng
+ * tới vài µs dù vòng lặp bận bao lâu.
+ *
+ * ATmega328P chỉ có một vector PCINT cho mỗi cổng, nên một ISR chung duyệt mọi cảm biến
+ * đã đăng ký và so mức hiện tại với mức trước của từng chân. Hàng đợi một-ghi/một-đọc
+ * như SampleBuffer; đầy thì cạnh mới bị bỏ và được đếm.
+ */
+
+#ifndef IR_SENSOR_H
+#define IR_SENSOR_H
+
+#include "Hal.h"
+
+// Số cảm biến tối đa dùng ngắt đổi mức (2 cảm biến mỗi làn, MAX_LANES làn)
+constexpr uint8_t IR_MAX_SENSORS = 8;
+
+// Số cạnh chờ được của mỗi cảm biến (lũy thừa của 2)
+constexpr uint8_t IR_EDGE_QUEUE_SIZE = 4;
+
+// Cạnh xuống cách cạnh xuống trước ít hơn khoảng này là rung ở mép sản phẩm, bỏ qua (µs)
+constexpr uint32_t IR_DEBOUNCE_US = 10000;
+
+class IrSensor {
+private:
+    int pin;                                     ///< Chân cảm biến (-1: không lắp)
+    uint8_t mask;                                ///< Bit của chân trong PINx
+    HalPortRegister* inputPort;                  ///< Thanh ghi PINx (gán trong begin)
+    volatile uint32_t edges[IR_EDGE_QUEUE_SIZE]; ///< micros() của các lần bị che
+    volatile uint8_t head;                       ///< Vị trí ghi tiếp theo (chỉ ISR thay đổi)
+    volatile uint8_t tail;                       ///< Vị trí đọc tiếp theo (chỉ loop thay đổi)
+    volatile uint8_t overruns;                   ///< Số cạnh bị bỏ do hàng đợi đầy
+    volatile uint8_t lastLevel;                  ///< Mức của chân lần ISR trước (0 hoặc mask)
+    volatile uint32_t lastEdgeUs;                ///< Thời điểm cạnh xuống được ghi gần nhất
+
+    static IrSensor* instances[IR_MAX_SENSORS];  ///< Các cảm biến ISR cần kiểm tra
+    static uint8_t instanceCount;
+
+public:
+    /**
+     * @brief Constructor - chưa chạm vào phần cứng
+     * @param pin Chân cảm biến (-1 nếu không lắp)
+     */
+    explicit IrSensor(int pin);
+
+    /**
+     * @brief Cấu hình chân, đăng ký với ISR chung và bật ngắt đổi mức của chân
+     */
+    void begin();
+
+    /**
+     * @brief Có lắp cảm biến hay không
+     */
+    bool isConnected() const;
+
+    /**
+     * @brief Cảm biến đang bị che (đọc trực tiếp thanh ghi)
+     */
+    bool isBlocked() const;
+
+    /**
+     * @brief Có lần bị che chưa xử lý (không lấy ra)
+     */
+    bool hasEdge() const;
+
+    /**
+     * @brief Lấy lần bị che cũ nhất chưa xử lý
+     * @param timeUs Nhận micros() lúc bị che
+     * @return false nếu không còn cạnh nào
+     */
+    bool pop(uint32_t& timeUs);
+
+    /**
+     * @brief Bỏ mọi cạnh đang chờ
+     */
+    void clear();
+
+    /**
+     * @brief Số cạnh bị bỏ do vòng lặp không lấy kịp
+     */
+    uint8_t getOverruns() const;
+
+    /**
+     * @brief ISR đổi mức chân chung của mọi cảm biến
+     */
+    static void onPinChange();
+
+private:
+    /**
+     * @brief So mức của chân với lần trước, ghi cạnh xuống vào hàng đợi (trong ISR)
+     */
+    void sample(uint32_t nowUs);
+};
+
+#endif
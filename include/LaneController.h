@@ -0,0 +1,235 @@
+/**
+ * @file LaneController.h
+ * @brief Một làn phân loại: cân, servo đẩy, servo gạt và cảm biến IR của làn đó
+ * @author FTH Arduino Uno Project
+ * @date 2026
+ *
+ * Mỗi làn có máy trạng thái riêng (IDLE -> WEIGHING -> PUSHING -> CLEARING), bảng
+ * phân hạng riêng (GradeEngine), thống kê quá trình riêng (ProcessStats), hàng đợi sản
+ * phẩm tới servo gạt riêng và bộ đếm riêng.
+ * SystemController gọi run() của từng làn trong mỗi vòng lặp; các làn dùng chung
+ * màn hình, telemetry và (khi có nhiều làn) bộ đọc HX711 trên SCK chung.
+ */
+
+#ifndef LANE_CONTROLLER_H
+#define LANE_CONTROLLER_H
+
+#include "Hal.h"
+#include "LoadCellManager.h"
+#include "ServoController.h"
+#include "DisplayManager.h"
+#include "ProductQueue.h"
+#include "Telemetry.h"
+#include "Profiler.h"
+#include "PersistentStore.h"
+#include "IrSensor.h"
+#include "BeltSpeedEstimator.h"
+#include "GradeEngine.h"
+#include "ProcessStats.h"
+
+// Trạng thái của một làn
+enum SystemState {
+    STATE_IDLE,       // Chờ sản phẩm (cân ở chế độ chờ, không lọc)
+    STATE_WEIGHING,   // Đang cân (chờ trọng lượng ổn định)
+    STATE_PUSHING,    // Servo 1 đang đẩy sản phẩm lên băng chuyền
+    STATE_CLEARING    // Chờ sản phẩm rời khỏi cân
+};
+// Sản phẩm đang đi tới servo 2 được theo dõi trong ProductQueue,
+// servo 2 hoạt động độc lập với máy trạng thái cân (xem serviceEjector)
+
+// Thời gian của từng giai đoạn (ms) - tính bằng millis(), không dùng delay()
+constexpr unsigned long MAX_SETTLE_TIME_MS = 1000;  // Chờ trọng lượng ổn định tối đa, quá hạn thì dùng giá trị lọc
+constexpr unsigned long PUSH_DWELL_MS = 50;     // Servo 1 giữ ở góc đẩy trước khi chạy về
+constexpr unsigned long TRANSIT_TIME_MS = 1500;  // Sản phẩm đi từ cân tới servo 2 ở tốc độ băng thiết kế (nhân theo tốc độ đo được)
+constexpr unsigned long EJECT_DWELL_MS = 50;     // Servo 2 giữ ở góc gạt trước khi chạy về
+constexpr unsigned long CLEAR_TIME_MS = 200;     // Chờ sản phẩm rời khỏi cân hoàn toàn (sau khi servo 1 đã về)
+// Thời gian chạy đi/về của servo được tính từ giới hạn vận tốc/gia tốc (ServoController)
+
+// Góc làm việc của servo
+constexpr int PUSH_ANGLE = 180;   // Servo 1 gạt sản phẩm từ cân lên băng chuyền
+constexpr int EJECT_ANGLE = 145;  // Servo 2 gạt sản phẩm lỗi ra ngoài băng chuyền
+
+// Ngưỡng phát hiện có sản phẩm trên cân (gram) - dưới ngưỡng coi như nhiễu
+constexpr float PRESENCE_THRESHOLD = 10.0;
+
+class LaneController {
+private:
+    LoadCellManager* loadCell;          ///< Cân của làn
+    ServoController* servoController;   ///< Servo đẩy (SERVO_1) và servo gạt (SERVO_2) của làn
+    DisplayManager* display;            ///< Màn hình dùng chung
+    Telemetry* telemetry;               ///< Telemetry dùng chung
+
+    IrSensor arrivalSensor;             ///< Cảm biến IR phát hiện sản phẩm đến cân (có thể không lắp)
+    IrSensor countSensor;               ///< Cảm biến IR đếm sản phẩm đạt chuẩn cuối băng chuyền
+    BeltSpeedEstimator belt;            ///< Tốc độ băng đo từ cảm biến cuối, quyết định lúc servo 2 gạt
+    uint8_t laneId;                     ///< Số thứ tự làn (0 = làn đầu), gán trong init()
+
+    GradeEngine grades;                 ///< Bảng phân hạng (Flash), cận đã đổi sang count và bộ đếm từng hạng
+    ProcessStats stats;                 ///< Thống kê trọng lượng và cảnh báo trôi (SPC)
+    int32_t presenceRaw;                ///< Ngưỡng phát hiện sản phẩm đã đổi sang count
+
+    int passCount;                      ///< Số sản phẩm đạt chuẩn
+    int rejectCount;                    ///< Số sản phẩm bị loại
+
+    ProductQueue inFlight;              ///< Các sản phẩm đang trên băng chuyền chờ tới servo 2
+
+    SystemState currentState;           ///< Trạng thái hiện tại
+    unsigned long stateStartTime;       ///< Thời điểm (millis) bắt đầu trạng thái hiện tại
+    int32_t currentRaw;                 ///< Trọng lượng của sản phẩm đang xử lý (count)
+    uint8_t currentGrade;               ///< Hạng của sản phẩm đang xử lý
+    bool currentValid;                  ///< Sản phẩm đang xử lý đi hết băng chuyền (hạng không bị gạt)
+    uint8_t currentVerdict;             ///< Verdict của sản phẩm đang xử lý (cho telemetry)
+    uint8_t currentConfidence;          ///< Độ tin cậy trọng lượng của sản phẩm đang xử lý (%)
+    unsigned long decisionTime;         ///< Thời điểm ra quyết định (millis)
+    uint16_t settleMs;                  ///< Thời gian từ lúc phát hiện tới lúc ra quyết định (ms)
+    unsigned long arrivalTime;          ///< Thời điểm (millis) sản phẩm lên cân: cạnh IR nếu có, không thì lúc cân phát hiện
+    bool announcedOnly;                 ///< Lần cân được mở bởi cạnh IR khi cân chưa thấy vật
+    uint8_t laneEvents;                 ///< LaneEvent chưa được báo
+
+public:
+    /**
+     * @brief Constructor - Liên kết các module của làn
+     * @param loadCell Cân của làn
+     * @param servoController Servo đẩy và servo gạt của làn
+     * @param display Màn hình dùng chung
+     * @param telemetry Telemetry dùng chung
+     * @param irSensorPin Chân cảm biến IR phát hiện sản phẩm (-1 nếu không lắp)
+     * @param irCountPin Chân cảm biến IR đếm sản phẩm đạt chuẩn (-1 nếu không lắp)
+     * @param grades Bảng phân hạng của làn trong PROGMEM (xem GradeEngine.h)
+     * @param gradeCount Số hạng của bảng
+     */
+    LaneController(LoadCellManager* loadCell, ServoController* servoController, DisplayManager* display,
+                   Telemetry* telemetry, int irSensorPin, int irCountPin, const GradeBand* grades,
+                   uint8_t gradeCount);
+
+    /**
+     * @brief Khởi tạo cảm biến IR, cân (tare) và servo của làn
+     * @param id Số thứ tự làn (theo thứ tự trong SystemController)
+     * @param saved Trạng thái lưu trong EEPROM (nullptr: khởi động lạnh). Cùng hệ số hiệu
+     *              chuẩn thì dùng lại điểm 0 (không tare chặn); bộ đếm luôn được khôi phục
+     */
+    void init(uint8_t id, const LaneSnapshot* saved = nullptr);
+
+    /**
+     * @brief Trạng thái cần lưu của làn (điểm 0, hệ số hiệu chuẩn, bộ đếm)
+     */
+    void saveState(LaneSnapshot& snapshot) const;
+
+    /**
+     * @brief Tare lại cân của làn (chặn ~1 s, lệnh "z")
+     * @return false nếu làn đang xử lý sản phẩm (không tare)
+     */
+    bool tare();
+
+    /**
+     * @brief Thực thi một bước của làn
+     * @details Cảm biến đếm, servo gạt theo hàng đợi, bộ lập lịch servo và máy trạng
+     *          thái cân. Trả về ngay, mọi khoảng chờ đều tính bằng millis()
+     */
+    void run();
+
+    /**
+     * @brief Lấy số sản phẩm đạt chuẩn của làn
+     */
+    int getPassCount();
+
+    /**
+     * @brief Lấy số sản phẩm bị loại của làn
+     */
+    int getRejectCount();
+
+    /**
+     * @brief Bảng phân hạng và bộ đếm từng hạng của làn
+     */
+    const GradeEngine& getGrades() const;
+
+    /**
+     * @brief In bảng phân hạng của làn ra Serial (banner khởi động)
+     */
+    void printGrades() const;
+
+    /**
+     * @brief Gửi thống kê quá trình hoặc biểu đồ tần suất của làn qua Telemetry (lệnh "s")
+     * @param histogram true: biểu đồ tần suất, false: thống kê và cảnh báo trôi
+     * @return false nếu bộ đệm TX chưa đủ chỗ (gọi lại sau)
+     */
+    bool reportStats(bool histogram);
+
+    /**
+     * @brief Xóa thống kê quá trình, lấy lại trung bình gốc từ các sản phẩm tiếp theo (lệnh "b")
+     */
+    void resetStats();
+
+    /**
+     * @brief Bật/tắt ghi mẫu thô HX711 của làn (xem LoadCellManager::setCapture)
+     */
+    void setCapture(Telemetry* sink);
+
+    /**
+     * @brief Làn đang ghi mẫu thô hay không
+     */
+    bool isCapturing() const;
+
+private:
+    /**
+     * @brief Đổi các cận của bảng phân hạng và ngưỡng có vật sang count theo hệ số
+     *        hiệu chuẩn hiện tại
+     * @details Gọi lại nếu hệ số hiệu chuẩn của LoadCellManager thay đổi
+     */
+    void updateThresholds();
+
+    /**
+     * @brief Xử lý các lần cảm biến cuối băng chuyền bị che (ghi bằng ngắt)
+     * @details Mỗi lần được ghép với sản phẩm đạt chuẩn đã đẩy để cập nhật tốc độ băng
+     */
+    void checkPassCounter();
+
+    /**
+     * @brief Thời điểm sản phẩm đang xử lý lên cân
+     * @details Cạnh IR đến cân gần nhất nếu có (chính xác tới µs), không thì lúc cân
+     *          phát hiện trọng lượng (trễ tới một chu kỳ HX711)
+     */
+    unsigned long takeArrivalTime(unsigned long detectedAt);
+
+    /**
+     * @brief Chuyển sang trạng thái mới và ghi lại thời điểm bắt đầu
+     * @param state Trạng thái mới
+     */
+    void enterState(SystemState state);
+
+    /**
+     * @brief Phân loại, hiển thị và bắt đầu gạt servo 1
+     * @param settled true nếu trọng lượng đã ổn định, false nếu hết thời gian chờ
+     * @details Sản phẩm được đưa vào hàng đợi cùng thời điểm nó tới servo 2
+     */
+    void classifyProduct(bool settled);
+
+    /**
+     * @brief Điều khiển servo 2 theo hàng đợi sản phẩm đang di chuyển
+     * @details Khi sản phẩm đầu hàng tới vị trí servo 2: lên lịch gạt nếu hạng của nó
+     *          dùng servo 2, bỏ qua nếu không. Bộ lập lịch của ServoController tự đưa servo 2
+     *          về 0° sau EJECT_DWELL_MS
+     */
+    void serviceEjector();
+
+    /**
+     * @brief Gửi kết quả sản phẩm vừa xử lý xong qua Telemetry
+     * @param pushMs Thời gian servo 1 đẩy và quay về (ms)
+     * @details Kèm thống kê quá trình nếu sản phẩm này vừa bật một cảnh báo trôi
+     */
+    void reportProduct(uint16_t pushMs);
+
+    /**
+     * @brief Gửi một sự kiện điểm 0 đang chờ của LoadCellManager qua Telemetry
+     * @details Gọi từ run(), ngoài đường lấy mẫu; bộ đệm TX đầy thì cờ được giữ tới
+     *          vòng lặp sau
+     */
+    void reportZeroEvent();
+
+    /**
+     * @brief Gửi một sự kiện đang chờ của làn (LaneEvent) qua Telemetry
+     */
+    void reportLaneEvent();
+};
+
+#endif
@@ -11,20 +11,129 @@
 #ifndef LOADCELL_MANAGER_H
 #define LOADCELL_MANAGER_H
 
-#include <Arduino.h>
-#include "HX711.h"
+#include "Hal.h"
+#include "SampleBuffer.h"
+#include "WeightFilter.h"
+#include "SettleDetector.h"
+#include "Profiler.h"
+#include "Telemetry.h"
+#include "Hx711Driver.h"
+#include "MultiLoadCell.h"
+
+// Chế độ lấy mẫu HX711
+enum AcquisitionMode {
+    ACQ_POLLING,     // Vòng lặp đọc HX711 (Hx711Driver) khi đã có chuyển đổi mới
+    ACQ_INTERRUPT,   // ISR trên cạnh xuống của DOUT ghi mẫu vào SampleBuffer
+    ACQ_SHARED_CLOCK // MultiLoadCell đọc mọi HX711 trên SCK chung rồi ghi vào SampleBuffer
+};
+
+// Tare: số lần chuyển đổi lấy trung bình và thời gian chờ tối đa mỗi lần chuyển đổi
+constexpr uint8_t TARE_SAMPLES = 10;
+constexpr unsigned long HX711_READY_TIMEOUT_MS = 500;
+
+// Kiểm tra nền điểm 0 lấy từ EEPROM: khối ZERO_FALLBACK_SAMPLES mẫu ổn định đầu tiên khi
+// cân rỗng (trong ±ZERO_FALLBACK_BAND_G quanh mẫu đầu khối) là điểm 0 mới, như tare lúc
+// khởi động lạnh. Khối lệch quá ±ZERO_CHECK_BAND_G so với điểm 0 đã lưu (vụn được dọn lúc
+// tắt máy, trôi nhiệt) được báo bằng ZERO_EVENT_RESTORE_FALLBACK
+constexpr uint8_t ZERO_FALLBACK_SAMPLES = 4;
+constexpr float ZERO_FALLBACK_BAND_G = 2.0f;
+constexpr float ZERO_CHECK_BAND_G = 5.0f;
+
+// Tự bám điểm 0 khi cân rỗng (sau khi điểm 0 đã được đo/kiểm tra): khối ZERO_TRACK_SAMPLES
+// mẫu liên tiếp trong dải bắt ±ZERO_TRACK_BAND_G (khối ngắn để vừa khoảng trống giữa hai
+// sản phẩm); mỗi ZERO_TRACK_INTERVAL_MS chỉnh tối đa ZERO_TRACK_STEP_G.
+// Tổng độ trôi đã bám từ lần tare bị giới hạn ở ±ZERO_TRACK_LIMIT_G: chạm thì không bám
+// thêm về phía đó (vụn lớn trên cân), báo ZERO_EVENT_TRACK_LIMIT một lần và cần tare lại
+// (lệnh "z")
+constexpr uint8_t ZERO_TRACK_SAMPLES = 4;
+constexpr float ZERO_TRACK_BAND_G = 2.0f;
+constexpr float ZERO_TRACK_STEP_G = 0.1f;
+constexpr unsigned long ZERO_TRACK_INTERVAL_MS = 1000;
+constexpr float ZERO_TRACK_LIMIT_G = 20.0f;
+
+// Ngoài lúc cân, mẫu không qua median/EMA: cân có vật khi ngần này mẫu liên tiếp vượt
+// ngưỡng (một spike đơn lẻ không đủ, như median 3 mẫu nhưng không phải sắp xếp)
+constexpr uint8_t IDLE_PRESENCE_SAMPLES = 2;
+
+// Số bit phần thập phân của hệ số hiệu chuẩn dạng fixed-point (Q8: 1/256 count/gram)
+constexpr uint8_t SCALE_Q_BITS = 8;
+
+// Tham số mặc định của bộ lọc (gram được đổi sang count theo hệ số hiệu chuẩn)
+constexpr float FILTER_NOISE_FLOOR_G = 3.0f;       // |trọng lượng| nhỏ hơn ngưỡng này coi là 0
+constexpr float FILTER_SPIKE_THRESHOLD_G = 50.0f;  // Thay đổi lớn hơn ngưỡng này là bước nhảy thật
+constexpr uint8_t FILTER_ALPHA_Q8 = 64;            // Hệ số lọc mũ 0.25 dạng Q8
+constexpr float SETTLE_TOLERANCE_G = 0.5f;         // Biên độ tối đa của đoạn mẫu thô ổn định (ngoài nhiễu)
+constexpr uint8_t SETTLE_NOISE_SIGMAS = 4;         // Biên độ cho phép thêm theo nhiễu: 4 sigma,
+                                                   // tối đa 2 lần SETTLE_TOLERANCE_G
+constexpr unsigned long SETTLE_RUN_MS = 300;       // Độ dài đoạn ổn định: hơn một chu kỳ dao động của cân
+
+// Lấy mẫu thích nghi: chọn cửa sổ median nhỏ nhất (và 80 SPS nếu có chân RATE) sao cho
+// 2 lần độ lệch chuẩn của median không vượt SAMPLING_ACCURACY_G
+constexpr float SAMPLING_ACCURACY_G = 0.5f;
+constexpr uint8_t ADAPTIVE_MIN_WINDOW = 3;         // Cửa sổ median nhỏ nhất được chọn
+constexpr uint8_t NOISE_EWMA_SHIFT = 4;            // Phương sai nhiễu: trung bình mũ 1/16
+constexpr unsigned long NOISE_QUIET_MS = 500;      // Chỉ đo nhiễu khi cân đã yên chừng này
+constexpr uint8_t INTERVAL_EWMA_SHIFT = 2;         // Khoảng cách sản phẩm: trung bình mũ 1/4
+constexpr uint32_t NOISE_VARIANCE_MAX = 4000000UL; // Giới hạn phương sai (count^2) để nhân không tràn
+constexpr unsigned long FAST_RATE_INTERVAL_MS = 2500;  // Sản phẩm đến dày hơn: dùng 80 SPS nếu đủ chính xác
+constexpr unsigned long SLOW_RATE_INTERVAL_MS = 3500;  // Thưa hơn: quay về 10 SPS (trễ để không bật/tắt liên tục)
+constexpr uint8_t RATE_NOISE_RATIO_Q4 = 52;        // Phương sai 80 SPS / 10 SPS ~ (90 nV / 50 nV)^2 = 3.25 (Q4)
+constexpr uint8_t RATE_SWITCH_DISCARD = 4;         // Số mẫu bỏ sau khi đổi tốc độ (HX711 chưa ổn định)
 
 class LoadCellManager {
 private:
-    HX711 hx711;              ///< Đối tượng HX711 để giao tiếp với cảm biến cân
+    Hx711Driver hx711;        ///< Đọc HX711 qua thanh ghi cổng (không dùng ở ACQ_SHARED_CLOCK)
     int doutPin;              ///< Chân DATA OUT của HX711
-    int sckPin;               ///< Chân SERIAL CLOCK của HX711
-    float calibrationFactor;  ///< Hệ số hiệu chuẩn để chuyển đổi giá trị đọc sang trọng lượng
-    float filteredWeight;     ///< Giá trị sau khi đã lọc
-    bool hasFilteredWeight;   ///< Đã có giá trị lọc lần đầu hay chưa
-    float noiseFloor;         ///< Ngưỡng triệt nhiễu nhỏ (gần 0g)
-    float spikeThreshold;     ///< Biên độ tối đa của nhiễu được chấp nhận
-    float alpha;              ///< Hệ số lọc mũ (0..1)
+    int32_t countsPerGramQ8;  ///< Độ lớn hệ số hiệu chuẩn (count/gram) dạng fixed-point Q8
+    int8_t countSign;         ///< Dấu của hệ số hiệu chuẩn (-1 khi load cell đấu ngược)
+    int32_t tareOffset;       ///< Giá trị thô khi cân rỗng (điểm 0)
+    int32_t noiseFloor;       ///< Ngưỡng triệt nhiễu nhỏ gần 0g (count)
+    
+    AcquisitionMode mode;                  ///< Chế độ lấy mẫu hiện tại
+    SampleBuffer rawSamples;               ///< Mẫu thô do ISR ghi vào
+    WeightFilter filter;                   ///< Median trượt + phát hiện bước nhảy + EMA
+    uint16_t sampleCount;                  ///< Số mẫu đã xử lý, kể cả ở chế độ chờ (tràn vòng)
+    SettleDetector settling;               ///< Phát hiện trọng lượng đã ổn định trong lúc cân
+    int32_t settleTolerance;               ///< SETTLE_TOLERANCE_G tính bằng count
+    int32_t settledMedian;                 ///< Median mới nhất của lần cân (trọng lượng khi đã ổn định)
+    bool settlingActive;                   ///< Đang trong một lần cân (bộ phát hiện ổn định được cập nhật)
+    bool tracking;                         ///< Chế độ chờ: mẫu không qua bộ lọc (pollIdle)
+    bool expectEmpty;                      ///< Làn cho biết cân đang rỗng (pollIdle) - cho phép kiểm tra và tự bám điểm 0
+    int32_t presenceLevel;                 ///< Ngưỡng có vật của chế độ chờ (count)
+    uint8_t presenceRun;                   ///< Số mẫu liên tiếp vượt presenceLevel (bão hòa)
+    bool loadSeen;                         ///< Lần cân này đã có mẫu (median) vượt presenceLevel
+    Telemetry* capture;                    ///< Nơi ghi mẫu thô (nullptr = không ghi)
+    MultiLoadCell* sharedClock;            ///< Bộ đọc SCK chung (chỉ ở ACQ_SHARED_CLOCK)
+    
+    int ratePin;                           ///< Chân RATE của HX711 (-1: không nối, cố định 10 SPS)
+    bool fastRate;                         ///< Đang chạy 80 SPS
+    bool autoWindow;                       ///< Cửa sổ median được chọn tự động
+    uint8_t discardSamples;                ///< Số mẫu còn phải bỏ sau khi đổi tốc độ
+    int32_t lastNet;                       ///< Mẫu trước (đã trừ điểm 0) để ước lượng nhiễu
+    bool hasLastNet;                       ///< lastNet hợp lệ
+    uint32_t noiseVariance;                ///< Phương sai nhiễu ở tốc độ hiện tại (count^2)
+    uint8_t noiseSamples;                  ///< Số cặp mẫu đã dùng để ước lượng nhiễu (bão hòa)
+    unsigned long lastDisturbance;         ///< Lần cuối cân bị xáo trộn (ms) - chưa đo nhiễu
+    uint32_t accuracyLimit;                ///< (SAMPLING_ACCURACY_G / 2)^2 tính bằng count^2
+    unsigned long lastArrival;             ///< Thời điểm sản phẩm trước lên cân (0 = chưa có)
+    unsigned long arrivalInterval;         ///< Khoảng cách trung bình giữa hai sản phẩm (ms, 0 = chưa biết)
+    
+    bool zeroUnverified;                   ///< Điểm 0 lấy từ EEPROM, chưa kiểm tra lại
+    int32_t zeroBand;                      ///< ZERO_CHECK_BAND_G tính bằng count
+    int32_t zeroFallbackBand;              ///< ZERO_FALLBACK_BAND_G tính bằng count
+    int32_t zeroSum;                       ///< Tổng các mẫu cân rỗng đang gom
+    uint8_t zeroSamples;                   ///< Số mẫu cân rỗng đã gom
+    int32_t zeroAnchor;                    ///< Mẫu đầu của khối đang gom
+    int32_t zeroRestoreError;              ///< Độ chỉnh khi tare nền lệch quá dải kiểm tra (count)
+    uint8_t zeroEvents;                    ///< ZeroEvent chưa được báo
+    int32_t zeroTrackBand;                 ///< ZERO_TRACK_BAND_G tính bằng count
+    int32_t zeroTrackStep;                 ///< ZERO_TRACK_STEP_G tính bằng count (>= 1)
+    int32_t zeroTrackLimit;                ///< ZERO_TRACK_LIMIT_G tính bằng count
+    int32_t zeroDrift;                     ///< Tổng độ chỉnh của tự bám điểm 0 từ lần tare (count)
+    bool zeroLimitLatched;                 ///< Đã báo chạm ZERO_TRACK_LIMIT_G từ lần tare
+    unsigned long lastZeroTrack;           ///< Lần chỉnh điểm 0 gần nhất (millis)
+    
+    static LoadCellManager* isrInstance;   ///< Đối tượng nhận mẫu từ ISR (chỉ một HX711 dùng ngắt)
 
 public:
     /**
@@ -32,33 +141,310 @@ public:
      * @param doutPin Chân kết nối DATA OUT của HX711
      * @param sckPin Chân kết nối SERIAL CLOCK của HX711
      * @param calibrationFactor Hệ số hiệu chuẩn để chuyển đổi giá trị thô sang gram
+     * @param mode Chế độ lấy mẫu (ACQ_INTERRUPT cần doutPin là chân ngắt ngoài: 2 hoặc 3)
+     * @param ratePin Chân nối RATE của HX711 để tự chọn 10/80 SPS (-1: RATE nối cứng GND)
+     */
+    LoadCellManager(int doutPin, int sckPin, float calibrationFactor,
+                    AcquisitionMode mode = ACQ_POLLING, int ratePin = -1);
+    
+    /**
+     * @brief Constructor với driver HX711 tạo sẵn, thường là makeHx711Driver<DOUT, SCK>()
+     *        khi chân là hằng số (dịch bit bằng lệnh sbi/cbi/sbis)
+     * @param hx711 Driver HX711 (chưa begin)
+     * @details Các tham số còn lại như constructor theo số chân
+     */
+    LoadCellManager(const Hx711Driver& hx711, float calibrationFactor,
+                    AcquisitionMode mode = ACQ_POLLING, int ratePin = -1);
+    
+    /**
+     * @brief Constructor cho một làn dùng SCK chung với các làn khác (ACQ_SHARED_CLOCK)
+     * @param doutPin Chân DATA OUT của HX711 (cùng cổng với DOUT của các làn khác)
+     * @param sharedClock Bộ đọc chung, kênh được gắn trong init()
+     * @param calibrationFactor Hệ số hiệu chuẩn của cân này
+     * @details Mọi HX711 phải cùng tốc độ nên không tự chọn 10/80 SPS (không có ratePin)
      */
-    LoadCellManager(int doutPin, int sckPin, float calibrationFactor);
+    LoadCellManager(int doutPin, MultiLoadCell* sharedClock, float calibrationFactor);
     
     /**
      * @brief Khởi tạo và cấu hình cảm biến HX711
-     * @details Thiết lập giao tiếp với HX711, áp dụng hệ số hiệu chuẩn và tare về 0
+     * @details Thiết lập giao tiếp với HX711, áp dụng hệ số hiệu chuẩn, tare về 0
+     *          và bật chế độ lấy mẫu đã chọn
      */
     void init();
     
+    /**
+     * @brief Đọc trọng lượng dạng số nguyên (count đã trừ điểm 0)
+     * @param samples Kích thước cửa sổ median (giới hạn 3..7), 0 = tự chọn theo nhiễu
+     * @return Giá trị đã lọc tính bằng count của HX711 - toàn bộ đường xử lý là int32
+     * @details Không chờ ADC: chỉ đưa các mẫu mới (từ ISR hoặc HX711 đã sẵn sàng)
+     *          vào bộ lọc rồi trả về ước lượng mới nhất
+     */
+    int32_t getRawWeight(int samples = 0);
+    
+    /**
+     * @brief Lấy mẫu ở chế độ chờ (ngoài lúc cân): mẫu chỉ dùng để theo dõi nhiễu, kiểm
+     *        tra điểm 0 và phát hiện vật trên cân, không qua median/EMA
+     * @param presence Ngưỡng có vật (count đã trừ điểm 0)
+     * @param empty Làn biết cân đang rỗng (chờ sản phẩm, IR chưa báo): chỉ khi đó điểm 0
+     *              mới được kiểm tra hoặc tự bám (sản phẩm nằm yên trên cân cũng ổn định)
+     * @return true nếu IDLE_PRESENCE_SAMPLES mẫu mới nhất liên tiếp vượt ngưỡng
+     * @details getRawWeight() hoặc beginSettling() đưa cân về đường lọc đầy đủ
+     */
+    bool pollIdle(int32_t presence, bool empty);
+    
+    /**
+     * @brief Đưa một mẫu thô vào bộ lọc trượt
+     * @param raw Giá trị thô 24 bit đã mở rộng dấu (chưa trừ điểm 0)
+     * @details Median trượt -> phân biệt spike/bước nhảy -> lọc mũ (EMA)
+     */
+    void addSample(int32_t raw);
+    
+    /**
+     * @brief Ghi một mẫu thô vào bộ đệm, xử lý ở lần lấy mẫu sau (gọi từ MultiLoadCell)
+     * @param raw Giá trị thô 24 bit đã mở rộng dấu
+     * @param stamp 16 bit thấp của millis() lúc đọc
+     */
+    void queueSample(int32_t raw, uint16_t stamp);
+    
+    /**
+     * @brief Số mẫu đã đưa vào bộ lọc, dùng để biết ước lượng đã được cập nhật chưa
+     */
+    uint16_t getSampleCount() const;
+    
+    /**
+     * @brief Bắt đầu một lần cân: bộ phát hiện ổn định theo dõi quá trình quá độ
+     * @details Rời chế độ chờ: bộ lọc bắt đầu lại từ mẫu đầu tiên của lần cân
+     */
+    void beginSettling();
+    
+    /**
+     * @brief Kết thúc lần cân, ngừng cập nhật bộ phát hiện ổn định
+     */
+    void endSettling();
+    
+    /**
+     * @brief Mẫu thô đã nằm trong SETTLE_TOLERANCE_G (cộng nhiễu) suốt SETTLE_RUN_MS chưa
+     */
+    bool isSettled();
+    
+    /**
+     * @brief Tải đã tới cân trong lần cân này (median vượt ngưỡng của pollIdle)
+     * @details Bộ phát hiện ổn định chỉ nhận mẫu từ lúc này: lần cân mở bởi cảm biến IR bắt đầu
+     *          trước khi sản phẩm đè lên load cell, các mẫu rỗng trước đó không thuộc
+     *          quá trình quá độ
+     */
+    bool hasLoad() const;
+    
+    /**
+     * @brief Trọng lượng đã ổn định: median của bộ lọc lúc isSettled() (count)
+     */
+    int32_t getSettledWeight() const;
+    
+    /**
+     * @brief Độ tin cậy của trọng lượng đã ổn định (0..100%, theo biên độ của đoạn)
+     */
+    uint8_t getSettleConfidence() const;
+    
     /**
      * @brief Đọc trọng lượng từ cảm biến
-     * @param samples Số lần đọc để lấy giá trị trung bình (mặc định: 10)
+     * @param samples Số mẫu dùng cho median filter (giới hạn 3..7), 0 = tự chọn theo nhiễu
      * @return Trọng lượng đo được tính bằng gram
+     * @details Chỉ dùng ở biên hiển thị/Serial; logic điều khiển dùng getRawWeight()
+     */
+    float getWeight(int samples = 0);
+    
+    /**
+     * @brief Đổi trọng lượng từ gram sang count (dùng khi khởi tạo ngưỡng)
+     * @param grams Trọng lượng (gram)
      */
-    float getWeight(int samples = 10);
+    int32_t gramsToCounts(float grams) const;
+    
+    /**
+     * @brief Đổi trọng lượng từ count sang gram (dùng khi hiển thị)
+     * @param counts Trọng lượng (count)
+     */
+    float countsToGrams(int32_t counts) const;
+    
+    /**
+     * @brief Chuyển chế độ lấy mẫu
+     * @param mode ACQ_POLLING hoặc ACQ_INTERRUPT
+     * @details Nếu doutPin không hỗ trợ ngắt ngoài thì giữ chế độ ACQ_POLLING.
+     *          ACQ_SHARED_CLOCK do cách đấu dây quyết định nên không đổi được
+     */
+    void setAcquisitionMode(AcquisitionMode mode);
+    
+    /**
+     * @brief Lấy chế độ lấy mẫu hiện tại
+     */
+    AcquisitionMode getAcquisitionMode() const;
+    
+    /**
+     * @brief Số mẫu bị mất do vòng lặp chính không lấy kịp (chế độ ngắt)
+     */
+    uint8_t getSampleOverruns() const;
     
     /**
      * @brief Tare (cân bằng) cảm biến về 0
-     * @details Đặt giá trị hiện tại làm mốc 0, loại bỏ trọng lượng khay chứa
+     * @details Đặt giá trị hiện tại làm mốc 0, loại bỏ trọng lượng khay chứa. Chặn
+     *          ~1 s nên chỉ dùng lúc khởi động và lệnh "z"; trong lúc chạy điểm 0 được
+     *          tự bám khi cân rỗng (trackZero)
      */
     void tare();
     
+    /**
+     * @brief Dùng điểm 0 đã lưu (EEPROM) thay cho tare - gọi trước init()
+     * @param offset Giá trị thô khi cân rỗng lần trước
+     * @details init() bỏ qua tare chặn (~1 s ở 10 SPS); điểm 0 được kiểm tra và chỉnh
+     *          nền trên khối mẫu cân rỗng ổn định đầu tiên (ZERO_FALLBACK_SAMPLES). Lệch
+     *          quá ±ZERO_CHECK_BAND_G được báo bằng ZERO_EVENT_RESTORE_FALLBACK
+     */
+    void restoreZero(int32_t offset);
+    
+    /**
+     * @brief Điểm 0 hiện tại (giá trị thô)
+     */
+    int32_t getTareOffset() const;
+    
+    /**
+     * @brief Điểm 0 đã được đo (tare) hoặc kiểm tra xong
+     * @details Chưa xong thì làn chưa nhận sản phẩm: điểm 0 lệch >= 10 g làm cân rỗng
+     *          trông như có vật
+     */
+    bool isZeroVerified() const;
+    
+    /**
+     * @brief Các ZeroEvent chưa được báo (cờ giữ tới clearZeroEvent)
+     */
+    uint8_t getZeroEvents() const;
+    
+    /**
+     * @brief Xóa một ZeroEvent sau khi đã gửi telemetry
+     */
+    void clearZeroEvent(uint8_t event);
+    
+    /**
+     * @brief Độ chỉnh của lần tare nền thay cho điểm 0 đã lưu (count)
+     */
+    int32_t getRestoreError() const;
+    
+    /**
+     * @brief Độ trôi điểm 0 đã được tự bám từ lần tare (count, dương: cân đọc nặng dần)
+     * @details Không vượt ±ZERO_TRACK_LIMIT_G; lần đầu chạm được báo bằng ZERO_EVENT_TRACK_LIMIT
+     */
+    int32_t getZeroDrift() const;
+    
+    /**
+     * @brief Hệ số hiệu chuẩn Q8 có dấu (để lưu và so khi khởi động lại)
+     */
+    int32_t getScaleQ8() const;
+    
     /**
      * @brief Thay đổi hệ số hiệu chuẩn của cảm biến
      * @param factor Hệ số hiệu chuẩn mới
      */
     void setCalibrationFactor(float factor);
+    
+    /**
+     * @brief Độ lệch chuẩn nhiễu ước lượng ở tốc độ hiện tại (count)
+     */
+    uint16_t getNoiseCounts() const;
+    
+    /**
+     * @brief Kích thước cửa sổ median đang dùng
+     */
+    uint8_t getMedianWindow() const;
+    
+    /**
+     * @brief Tốc độ lấy mẫu hiện tại của HX711 (10 hoặc 80 SPS)
+     */
+    uint8_t getSampleRate() const;
+    
+    /**
+     * @brief Khoảng cách trung bình giữa hai sản phẩm (ms, 0 = chưa biết)
+     */
+    unsigned long getArrivalInterval() const;
+    
+    /**
+     * @brief Bật/tắt ghi mẫu thô HX711 để phát lại trên máy tính (sim, bench)
+     * @param sink Telemetry nhận mẫu, nullptr để tắt
+     * @details Mỗi mẫu được gắn thời điểm HX711 chuyển đổi xong (ms), kể cả khi nó
+     *          nằm trong bộ đệm lâu (lúc servo đang đẩy). Điểm 0 và hệ số hiệu chuẩn
+     *          được gửi lúc bật và sau mỗi lần tare.
+     */
+    void setCapture(Telemetry* sink);
+    
+    /**
+     * @brief Đang ghi mẫu thô hay không
+     */
+    bool isCapturing() const;
+    
+private:
+    /**
+     * @brief ISR khi DOUT xuống mức thấp (HX711 có dữ liệu mới)
+     * @details Dịch ra 24 bit + xung chọn gain rồi ghi vào rawSamples
+     */
+    static void onDataReady();
+    
+    /**
+     * @brief Gắn ngắt ngoài cho chân DOUT
+     */
+    void attachDataReadyInterrupt();
+    
+    /**
+     * @brief Gỡ ngắt ngoài của chân DOUT
+     */
+    void detachDataReadyInterrupt();
+    
+    /**
+     * @brief Lấy hết mẫu mới (ISR hoặc HX711 đã sẵn sàng) đưa vào bộ lọc
+     *        (hoặc đường rút gọn của chế độ chờ)
+     */
+    void pollSamples();
+    
+    /**
+     * @brief Cập nhật phương sai nhiễu từ hiệu hai mẫu liên tiếp (chỉ khi không cân)
+     */
+    void trackNoise(int32_t net);
+    
+    /**
+     * @brief Chọn cửa sổ median và tốc độ lấy mẫu theo nhiễu và nhịp sản phẩm
+     */
+    void adaptSampling();
+    
+    /**
+     * @brief Sai số 2 sigma của median cửa sổ window có đạt độ chính xác yêu cầu không
+     * @param variance Phương sai nhiễu của mẫu (count^2)
+     */
+    bool meetsAccuracy(uint32_t variance, uint8_t window) const;
+    
+    /**
+     * @brief Đổi tốc độ HX711 qua chân RATE
+     */
+    void setFastRate(bool fast);
+    
+    /**
+     * @brief Trung bình các lần chuyển đổi tiếp theo (tare), qua Hx711Driver hoặc SCK chung
+     * @param average Biến nhận giá trị thô trung bình
+     * @return false nếu HX711 không có dữ liệu trong thời gian chờ
+     */
+    bool averageReadings(uint8_t times, int32_t& average);
+    
+    /**
+     * @brief Xóa trạng thái bộ lọc (sau khi tare)
+     */
+    void resetFilter();
+    
+    /**
+     * @brief Gom một mẫu cân rỗng để kiểm tra điểm 0 lấy từ EEPROM, hoặc (khi đã kiểm
+     *        tra) bám điểm 0 theo trôi nhiệt và vụn bám trên cân
+     * @param net Mẫu đã trừ điểm 0 (count)
+     */
+    void trackZero(int32_t net);
+    
+    /**
+     * @brief Đặt điểm 0 mới: xóa bộ lọc, báo cho đoạn ghi mẫu thô
+     */
+    void applyTare(int32_t offset);
 };
 
 #endif
@@ -0,0 +1,56 @@
+/**
+ * @file MemoryMonitor.h
+ * @brief Đo RAM lúc chạy: vùng tĩnh, heap, stack sâu nhất và khoảng trống còn lại
+ * @author FTH Arduino Uno Project
+ * @date 2026
+ *
+ * ATmega328P có 2048 byte SRAM: .data/.bss (biến toàn cục, các đối tượng trong main.cpp)
+ * ở đầu, heap mọc lên từ __heap_start, stack mọc xuống từ RAMEND. Tràn stack không báo
+ * lỗi mà ghi đè biến toàn cục, nên cần biết stack đã xuống sâu nhất tới đâu.
+ *
+ * paintStack() (gọi đầu tiên trong SystemController::init) tô vùng trống giữa heap và
+ * stack bằng MEMORY_CANARY. snapshot() đếm số byte còn nguyên màu tô phía trên heap:
+ * đó là khoảng trống nhỏ nhất từng có kể từ lúc tô (free_min), phần còn lại là stack sâu
+ * nhất. Lần quét tối đa ~1.5 KB chỉ chạy khi có lệnh "m", vòng lặp không tốn gì thêm.
+ *
+ * Ngoài board (bộ mô phỏng) không có bố cục RAM của AVR: mọi giá trị bằng 0.
+ * Kích thước tĩnh lúc build: tools/ram_report.py (env:uno chạy sau khi link).
+ */
+
+#ifndef MEMORY_MONITOR_H
+#define MEMORY_MONITOR_H
+
+#include "Hal.h"
+
+// Byte dùng để tô vùng trống
+constexpr uint8_t MEMORY_CANARY = 0xC5;
+
+// Số byte ngay dưới SP không tô (khung của chính paintStack và ngắt đến lúc tô)
+constexpr uint8_t MEMORY_PAINT_GUARD = 32;
+
+/**
+ * @brief Ảnh chụp RAM (payload của FRAME_MEMORY, 10 byte)
+ */
+struct MemoryStats {
+    uint16_t staticBytes;    ///< .data + .bss (byte)
+    uint16_t heapBytes;      ///< Heap đã cấp (byte, 0 nếu không dùng malloc/String)
+    uint16_t freeBytes;      ///< Khoảng trống hiện tại giữa heap và stack
+    uint16_t minFreeBytes;   ///< Khoảng trống nhỏ nhất kể từ paintStack()
+    uint16_t stackMaxBytes;  ///< Stack sâu nhất kể từ paintStack()
+};
+
+class MemoryMonitor {
+public:
+    /**
+     * @brief Tô vùng trống giữa heap và stack - gọi một lần, càng sớm càng tốt
+     */
+    static void paintStack();
+
+    /**
+     * @brief Đo RAM hiện tại và stack sâu nhất
+     * @param stats Nhận kết quả
+     */
+    static void snapshot(MemoryStats& stats);
+};
+
+#endif
@@ -0,0 +1,144 @@
+/**
+ * @file Messages.h
+ * @brief Danh mục thông báo (Serial, LCD) nằm trong Flash, truy cập theo ID
+ * @author FTH Arduino Uno Project
+ * @date 2026
+ *
+ * Trên AVR mọi chuỗi hằng "..." được chép vào RAM lúc khởi động. Các thông báo của
+ * firmware (~780 byte) vì vậy được gom vào MESSAGE_CATALOG: mỗi chuỗi là một mảng
+ * PROGMEM, bảng con trỏ cũng nằm trong PROGMEM. message(id) trả về
+ * const __FlashStringHelper* nên dùng thẳng với Serial.print()/println() và
+ * DisplayManager::print(); Print đọc từng byte bằng pgm_read_byte.
+ *
+ * Thêm thông báo: thêm một dòng X(ID, "chuỗi") vào MESSAGE_CATALOG, enum và bảng được
+ * sinh từ cùng danh sách nên không thể lệch nhau.
+ */
+
+#ifndef MESSAGES_H
+#define MESSAGES_H
+
+#include "Hal.h"
+
+#define MESSAGE_CATALOG(X) \
+    X(MSG_UNKNOWN, "?") \
+    /* Khởi động */ \
+    X(MSG_SERIAL_READY, "Serial Initialized") \
+    X(MSG_IR_READY, "IR Sensors Initialized") \
+    X(MSG_LOADCELL_READY, "LoadCell Initialized") \
+    X(MSG_SERVO_READY, "Servos Initialized") \
+    X(MSG_LOADCELL_SHARED_FAIL, "LoadCell: khong gan duoc kenh SCK chung (DOUT khac cong?)") \
+    X(MSG_LOADCELL_NO_INTERRUPT, "LoadCell: DOUT khong ho tro ngat, dung polling") \
+    X(MSG_WARM_START, "LoadCell: diem 0 tu EEPROM, kiem tra nen") \
+    X(MSG_BANNER_RULE, "=================================") \
+    X(MSG_BANNER_TITLE, "HE THONG PHAN LOAI SAN PHAM") \
+    X(MSG_BANNER_GRADES, "Phan hang lan ") \
+    X(MSG_BANNER_GRADE_NAME, ": ") \
+    X(MSG_BANNER_GRADE_FROM, " | >= ") \
+    X(MSG_BANNER_LANES, "So lan: ") \
+    X(MSG_SETUP_DONE, "Setup Complete - Ready!") \
+    /* Telemetry chế độ chữ */ \
+    X(MSG_ARRIVAL_PREFIX, "\n>>> [Lan ") \
+    X(MSG_ARRIVAL_SUFFIX, "] San pham tren can!") \
+    X(MSG_PRODUCT_PREFIX, "[Lan ") \
+    X(MSG_PRODUCT_WEIGHT, "] Trong luong: ") \
+    X(MSG_PRODUCT_CONFIDENCE, " g (tin cay ") \
+    X(MSG_PRODUCT_VERDICT, "%) -> ") \
+    X(MSG_VERDICT_PASS, "DAT CHUAN!") \
+    X(MSG_VERDICT_LIGHT, "LOAI - Qua nhe!") \
+    X(MSG_VERDICT_HEAVY, "LOAI - Qua nang!") \
+    /* Tên hạng của bảng phân hạng (GradeEngine) */ \
+    X(MSG_GRADE_1, "DAT CHUAN - Hang 1!") \
+    X(MSG_GRADE_2, "DAT CHUAN - Hang 2!") \
+    X(MSG_GRADE_3, "DAT CHUAN - Hang 3!") \
+    X(MSG_GRADES_PREFIX, "] Theo hang: ") \
+    X(MSG_GRADES_SEPARATOR, " | ") \
+    /* Thống kê quá trình (ProcessStats) */ \
+    X(MSG_SPC_PREFIX, "] SPC n=") \
+    X(MSG_SPC_MEAN, " tb=") \
+    X(MSG_SPC_SD, " g sd=") \
+    X(MSG_SPC_RATE, " g | ") \
+    X(MSG_SPC_RATE_UNIT, " sp/phut") \
+    X(MSG_SPC_NO_BASELINE, " | dang lay goc") \
+    X(MSG_SPC_BASELINE, " | goc ") \
+    X(MSG_SPC_PLUS_MINUS, " +/- ") \
+    X(MSG_SPC_EWMA, " g | EWMA ") \
+    X(MSG_SPC_CUSUM, " g | CUSUM +") \
+    X(MSG_SPC_CUSUM_MINUS, "% -") \
+    X(MSG_SPC_ALARMS, "% | canh bao ") \
+    X(MSG_SPC_DRIFT, " | TROI:") \
+    X(MSG_SPC_FLAG_CUSUM_HIGH, " CUSUM+") \
+    X(MSG_SPC_FLAG_CUSUM_LOW, " CUSUM-") \
+    X(MSG_SPC_FLAG_EWMA_HIGH, " EWMA+") \
+    X(MSG_SPC_FLAG_EWMA_LOW, " EWMA-") \
+    X(MSG_SPC_HIST_PREFIX, "] Bieu do tu ") \
+    X(MSG_SPC_HIST_WIDTH, " g, moi o ") \
+    X(MSG_SPC_HIST_BINS, " g:") \
+    X(MSG_STATS_PASS, "Thong ke: PASS=") \
+    X(MSG_STATS_REJECT, " | REJECT=") \
+    X(MSG_SAMPLING_MEDIAN, "Lay mau: median ") \
+    X(MSG_LIST_SEPARATOR, ", ") \
+    X(MSG_SAMPLING_SPS, " SPS, nhieu ") \
+    X(MSG_SAMPLING_ZERO_DRIFT, " count, diem 0 troi ") \
+    X(MSG_SAMPLING_COUNT, " count") \
+    X(MSG_PASS_PREFIX, ">>> [Lan ") \
+    X(MSG_PASS_SUFFIX, "] San pham di qua cuoi bang chuyen!") \
+    X(MSG_PASS_EXIT, " (day -> cuoi ") \
+    X(MSG_PASS_TRANSIT, " ms, toi servo 2 ") \
+    X(MSG_PASS_END, " ms)") \
+    X(MSG_CAPTURE_TARE, "# tare=") \
+    X(MSG_CAPTURE_SCALE, ",cpg_q8=") \
+    X(MSG_CAPTURE_ZERO, "# zero=") \
+    /* Sự kiện điểm 0 (LoadCellManager) */ \
+    X(MSG_ZERO_RESTORE_FALLBACK, "] LoadCell: diem 0 EEPROM khong qua kiem tra, tare nen, lech ") \
+    X(MSG_ZERO_TRACK_LIMIT, "] LoadCell: diem 0 troi toi gioi han tu bam, can tare (lenh z), troi ") \
+    X(MSG_ZERO_GRAMS, " g") \
+    X(MSG_ZERO_TARE_NO_DATA, "] LoadCell: HX711 khong co du lieu, giu diem 0 cu") \
+    /* Sự kiện của làn (LaneController) */ \
+    X(MSG_EVENT_GRADE_UNSORTED, "] Bang phan hang: can duoi phai tang dan") \
+    /* Profiler */ \
+    X(MSG_PROF_PREFIX, "PROF ") \
+    X(MSG_PROF_COUNT, " n=") \
+    X(MSG_PROF_MIN, " min=") \
+    X(MSG_PROF_MEAN, " mean=") \
+    X(MSG_PROF_MAX, " max=") \
+    X(MSG_PROF_US, " us") \
+    X(MSG_PROF_RATE, " rate=") \
+    X(MSG_PROF_JITTER, "Hz jitter=") \
+    X(MSG_PROF_JITTER_UNIT, "us") \
+    X(MSG_PROF_HIST, " hist=") \
+    X(MSG_STAGE_LOOP, "loop") \
+    X(MSG_STAGE_HX711, "hx711") \
+    X(MSG_STAGE_FILTER, "filter") \
+    X(MSG_STAGE_CLASSIFY, "classify") \
+    X(MSG_STAGE_SERVO, "servo") \
+    X(MSG_STAGE_DISPLAY, "display") \
+    X(MSG_STAGE_SERIAL, "serial") \
+    /* Bộ nhớ (MemoryMonitor) */ \
+    X(MSG_MEM_PREFIX, "MEM static=") \
+    X(MSG_MEM_HEAP, " heap=") \
+    X(MSG_MEM_FREE, " free=") \
+    X(MSG_MEM_FREE_MIN, " free_min=") \
+    X(MSG_MEM_STACK_MAX, " stack_max=") \
+    /* LCD */ \
+    X(MSG_LCD_WEIGHT, "Weight:") \
+    X(MSG_LCD_GRAM, " g") \
+    X(MSG_LCD_READY, "SYSTEM READY...")
+
+#define MESSAGE_ENUM_ENTRY(id, text) id,
+
+// ID của thông báo (thứ tự trong MESSAGE_CATALOG)
+enum MessageId : uint8_t {
+    MESSAGE_CATALOG(MESSAGE_ENUM_ENTRY)
+    MSG_COUNT
+};
+
+#undef MESSAGE_ENUM_ENTRY
+
+/**
+ * @brief Chuỗi của thông báo, nằm trong Flash
+ * @param id ID thông báo
+ * @return Con trỏ Flash dùng được với Print::print() và DisplayManager::print()
+ */
+const __FlashStringHelper* message(MessageId id);
+
+#endif
@@ -0,0 +1,74 @@
+/**
+ * @file MotionProfile.h
+ * @brief Bảng quỹ đạo chuẩn hóa (trapezoid / S-curve) sinh lúc biên dịch, lưu trong Flash
+ * @author FTH Arduino Uno Project
+ * @date 2026
+ * 
+ * Mỗi bảng có MOTION_TABLE_STEPS + 1 điểm, cho vị trí chuẩn hóa s(u) (0..65535)
+ * theo thời gian chuẩn hóa u (0..1). Giá trị được tính bằng hàm constexpr nên
+ * không tốn thời gian chạy; bảng nằm trong PROGMEM nên không tốn RAM.
+ * 
+ * Với quãng đường D và thời gian T:
+ * - S-curve (smoothstep 3u^2 - 2u^3): vận tốc đỉnh 1.5 D/T, gia tốc đỉnh 6 D/T^2
+ * - Trapezoid (1/3 tăng tốc, 1/3 đều, 1/3 giảm tốc): vận tốc đỉnh 1.5 D/T, gia tốc 4.5 D/T^2
+ */
+
+#ifndef MOTION_PROFILE_H
+#define MOTION_PROFILE_H
+
+#include "Hal.h"
+
+// Số đoạn của bảng quỹ đạo (giữa hai điểm dùng nội suy tuyến tính)
+constexpr uint8_t MOTION_TABLE_STEPS = 32;
+
+// Dạng quỹ đạo
+enum MotionProfileType {
+    PROFILE_TRAPEZOID,  // Gia tốc không đổi - nhanh nhất với cùng gia tốc cực đại
+    PROFILE_SCURVE      // Gia tốc thay đổi liên tục - ít rung, ít vọt lố
+};
+
+/**
+ * @brief Vị trí chuẩn hóa của S-curve tại bước i (0..65535)
+ * @details s = 3u^2 - 2u^3 với u = i/N, tính bằng số nguyên: (3 i^2 N - 2 i^3) / N^3
+ */
+constexpr uint16_t sCurvePoint(uint32_t i, uint32_t n = MOTION_TABLE_STEPS) {
+    return (uint16_t)((3 * i * i * n - 2 * i * i * i) * 65535UL / (n * n * n));
+}
+
+/**
+ * @brief Vị trí chuẩn hóa của trapezoid tại bước i (0..65535)
+ * @details u <= 1/3: 9u^2/4;  1/3 < u <= 2/3: (6u - 1)/4;  u > 2/3: 1 - 9(1-u)^2/4
+ */
+constexpr uint16_t trapezoidPoint(uint32_t i, uint32_t n = MOTION_TABLE_STEPS) {
+    return (3 * i <= n)
+        ? (uint16_t)(9 * i * i * 65535UL / (4 * n * n))
+        : (3 * i <= 2 * n)
+            ? (uint16_t)((6 * i - n) * 65535UL / (4 * n))
+            : (uint16_t)(65535UL - 9 * (n - i) * (n - i) * 65535UL / (4 * n * n));
+}
+
+/**
+ * @brief Hệ số gia tốc đỉnh x10 (a_max = k/10 * D / T^2) của từng dạng quỹ đạo
+ */
+constexpr uint32_t profileAccelFactorX10(MotionProfileType type) {
+    return (type == PROFILE_SCURVE) ? 60 : 45;
+}
+
+/**
+ * @brief Tính thời gian ngắn nhất (ms) cho quãng đường D với giới hạn vận tốc và gia tốc
+ * @param degrees Quãng đường (độ)
+ * @param maxSpeed Vận tốc tối đa (độ/giây)
+ * @param maxAccel Gia tốc tối đa (độ/giây^2)
+ * @param type Dạng quỹ đạo
+ */
+uint16_t motionDurationMs(uint16_t degrees, uint16_t maxSpeed, uint16_t maxAccel, MotionProfileType type);
+
+/**
+ * @brief Vị trí chuẩn hóa (0..65535) tại thời điểm elapsed của chuyển động dài duration
+ * @param type Dạng quỹ đạo
+ * @param elapsed Thời gian đã trôi qua (ms)
+ * @param duration Tổng thời gian chuyển động (ms)
+ */
+uint16_t motionPosition(MotionProfileType type, unsigned long elapsed, unsigned long duration);
+
+#endif
@@ -0,0 +1,92 @@
+/**
+ * @file MultiLoadCell.h
+ * @brief Đọc nhiều HX711 cùng lúc trên một chân SCK chung
+ * @author FTH Arduino Uno Project
+ * @date 2026
+ *
+ * Mỗi làn cân có một HX711 riêng, các chân DOUT nằm trên cùng một cổng (ví dụ A0..A3
+ * là PORTC) và mọi HX711 dùng chung một chân SCK. Mỗi xung SCK dịch ra một bit của tất
+ * cả các kênh; một lần đọc thanh ghi PINx lấy bit đó của mọi kênh. Nhờ vậy thời gian
+ * đọc (25 xung SCK, ngắt chỉ tắt trong từng xung như Hx711Driver) không phụ thuộc số
+ * kênh; việc tách bit từng kênh chạy sau.
+ *
+ * Các HX711 chuyển đổi độc lập (dao động nội lệch nhau vài phần nghìn), nên chỉ đọc khi
+ * mọi DOUT đều thấp. Tốc độ lấy mẫu chung là tốc độ của kênh chậm nhất, mọi kênh phải
+ * cùng 10 hoặc 80 SPS (chân RATE nối chung hoặc nối cứng).
+ *
+ * Không dùng ngắt: poll() chỉ đọc một thanh ghi khi chưa có dữ liệu. Mẫu được ghi vào
+ * SampleBuffer của từng LoadCellManager (chế độ ACQ_SHARED_CLOCK).
+ */
+
+#ifndef MULTI_LOAD_CELL_H
+#define MULTI_LOAD_CELL_H
+
+#include "Hal.h"
+#include "Hx711Driver.h"
+
+class LoadCellManager;
+
+// Số kênh HX711 tối đa trên một SCK chung
+constexpr uint8_t MULTI_LOADCELL_MAX_CHANNELS = 4;
+
+class MultiLoadCell {
+private:
+    int sckPin;                       ///< Chân SCK chung
+    HalPortRegister* sckPort;         ///< Thanh ghi PORTx của SCK
+    uint8_t sckMask;                  ///< Bit của SCK trong PORTx
+    HalPortRegister* doutPort;        ///< Thanh ghi PINx chứa mọi DOUT
+    uint8_t doutPortId;               ///< Cổng của các DOUT (để kiểm tra khi gắn kênh)
+    uint8_t readyMask;                ///< Các bit DOUT đang dùng (tất cả thấp = có dữ liệu)
+    uint8_t doutMasks[MULTI_LOADCELL_MAX_CHANNELS];         ///< Bit DOUT của từng kênh
+    LoadCellManager* lanes[MULTI_LOADCELL_MAX_CHANNELS];    ///< Nơi nhận mẫu của từng kênh
+    uint8_t channels;                 ///< Số kênh đã gắn
+
+public:
+    /**
+     * @brief Constructor - chỉ lưu chân SCK, cấu hình chân khi gắn kênh đầu tiên
+     * @param sckPin Chân SCK nối chung tới mọi HX711
+     */
+    explicit MultiLoadCell(int sckPin);
+
+    /**
+     * @brief Gắn một kênh (gọi từ LoadCellManager::init)
+     * @param lane LoadCellManager nhận mẫu của kênh
+     * @param doutPin Chân DOUT của HX711 của kênh
+     * @return false nếu đã đủ kênh hoặc DOUT không cùng cổng với các kênh trước
+     */
+    bool attach(LoadCellManager* lane, int doutPin);
+
+    /**
+     * @brief Mọi HX711 đã có dữ liệu mới (mọi DOUT thấp)
+     */
+    bool isReady() const;
+
+    /**
+     * @brief Đọc tất cả các kênh nếu đã sẵn sàng và chuyển mẫu tới từng làn
+     * @return true nếu đã đọc một lượt
+     * @details Không chờ ADC; gọi thường xuyên (mỗi LoadCellManager gọi khi lấy mẫu)
+     */
+    bool poll();
+
+    /**
+     * @brief Chờ tới khi mọi HX711 có dữ liệu (dùng khi tare lúc khởi động)
+     * @param timeoutMs Thời gian chờ tối đa (ms)
+     * @return false nếu hết thời gian (HX711 mất nguồn hoặc đứt dây)
+     */
+    bool waitReady(unsigned long timeoutMs);
+
+    /**
+     * @brief Số kênh đã gắn
+     */
+    uint8_t getChannelCount() const;
+
+private:
+    /**
+     * @brief Dịch 24 bit + xung gain của mọi kênh, mở rộng dấu
+     * @param values Mảng nhận giá trị thô của từng kênh
+     * @return Các bit DOUT còn thấp sau xung cuối (kênh đã chuyển đổi lại trong lúc đọc)
+     */
+    uint8_t readAll(int32_t values[]);
+};
+
+#endif
@@ -0,0 +1,113 @@
+/**
+ * @file PersistentStore.h
+ * @brief Lưu điểm 0, hệ số hiệu chuẩn và bộ đếm của từng làn trong EEPROM
+ * @author FTH Arduino Uno Project
+ * @date 2026
+ *
+ * EEPROM 1 KB được chia đều cho PERSIST_CHANNELS làn (256 byte mỗi làn, cố định để
+ * thêm/bớt làn không làm lệch dữ liệu của làn khác). Mỗi vùng là một vòng 16 bản ghi
+ * 16 byte:
+ *   [định dạng][seq: 2][tare: 4][hệ số Q8 có dấu: 4][pass: 2][reject: 2][crc8]
+ * Bản ghi mới luôn ghi vào ô sau ô mới nhất, nên mỗi ô chỉ bị ghi 1/16 số lần lưu, và
+ * mất điện giữa chừng chỉ làm hỏng (sai CRC) ô đang ghi, ô trước đó vẫn đọc được.
+ * Lúc khởi động, ô hợp lệ có seq lớn nhất (so sánh theo hiệu, an toàn khi tràn) là
+ * trạng thái mới nhất.
+ *
+ * Ghi EEPROM mất ~3.3 ms mỗi byte. save() chỉ chép bản ghi vào bộ đệm, service() (gọi
+ * mỗi vòng lặp) ghi một byte khi EEPROM rảnh, nên vòng lặp không bao giờ chờ EEPROM.
+ * Byte không đổi không bị ghi lại (eeprom_update_byte).
+ */
+
+#ifndef PERSISTENT_STORE_H
+#define PERSISTENT_STORE_H
+
+#include "Hal.h"
+
+// Số vùng (làn) cố định trong EEPROM
+constexpr uint8_t PERSIST_CHANNELS = 4;
+
+// Kích thước một bản ghi và số ô của mỗi vùng
+constexpr uint8_t PERSIST_RECORD_BYTES = 16;
+constexpr uint16_t PERSIST_REGION_BYTES = (E2END + 1) / PERSIST_CHANNELS;
+constexpr uint8_t PERSIST_SLOTS = PERSIST_REGION_BYTES / PERSIST_RECORD_BYTES;
+
+// Phiên bản bố cục bản ghi - đổi khi đổi bố cục, bản ghi cũ bị bỏ qua (khởi động lạnh)
+constexpr uint8_t PERSIST_FORMAT = 1;
+
+// Chu kỳ lưu bộ đếm (ms): mất điện thì mất tối đa chừng này sản phẩm trong bộ đếm.
+// 16 ô, mỗi phút một lần: mỗi ô bị ghi 16 phút/lần, 100 000 lần ghi ~ 3 năm chạy liên tục
+constexpr unsigned long PERSIST_INTERVAL_MS = 60000;
+
+/**
+ * @brief Trạng thái của một làn được lưu lại
+ */
+struct LaneSnapshot {
+    int32_t tareOffset;   ///< Giá trị thô khi cân rỗng
+    int32_t scaleQ8;      ///< Hệ số hiệu chuẩn Q8 có dấu lúc lưu
+    uint16_t passCount;   ///< Số sản phẩm đạt chuẩn
+    uint16_t rejectCount; ///< Số sản phẩm bị loại
+};
+
+class PersistentStore {
+private:
+    uint8_t newestSlot[PERSIST_CHANNELS];   ///< Ô mới nhất của mỗi vùng (PERSIST_SLOTS: chưa có)
+    uint16_t sequence[PERSIST_CHANNELS];    ///< seq của ô mới nhất
+    uint8_t pending[PERSIST_RECORD_BYTES];  ///< Bản ghi đang ghi dần
+    uint16_t pendingAddress;                ///< Địa chỉ EEPROM của bản ghi đang ghi
+    uint8_t pendingIndex;                   ///< Byte tiếp theo cần ghi (PERSIST_RECORD_BYTES: rảnh)
+
+public:
+    /**
+     * @brief Constructor - chưa đọc EEPROM
+     */
+    PersistentStore();
+
+    /**
+     * @brief Tìm bản ghi mới nhất của mọi vùng (đọc toàn bộ EEPROM một lần, ~1 KB)
+     */
+    void begin();
+
+    /**
+     * @brief Đọc trạng thái mới nhất của một làn
+     * @param channel Số thứ tự làn
+     * @param snapshot Nhận trạng thái
+     * @return false nếu làn chưa có bản ghi hợp lệ (khởi động lạnh)
+     */
+    bool load(uint8_t channel, LaneSnapshot& snapshot) const;
+
+    /**
+     * @brief Bắt đầu lưu trạng thái của một làn vào ô tiếp theo
+     * @return false nếu đang ghi bản ghi khác (gọi lại sau)
+     * @details Trạng thái giống bản ghi mới nhất thì không ghi gì (không tốn lần ghi)
+     */
+    bool save(uint8_t channel, const LaneSnapshot& snapshot);
+
+    /**
+     * @brief Ghi byte tiếp theo của bản ghi đang chờ nếu EEPROM rảnh - gọi mỗi vòng lặp
+     */
+    void service();
+
+    /**
+     * @brief Đang ghi dở một bản ghi
+     */
+    bool isBusy() const;
+
+private:
+    /**
+     * @brief Địa chỉ EEPROM của một ô
+     */
+    static uint16_t slotAddress(uint8_t channel, uint8_t slot);
+
+    /**
+     * @brief Đọc một ô, kiểm tra định dạng và CRC
+     * @param record Nhận PERSIST_RECORD_BYTES byte của ô
+     */
+    static bool readSlot(uint8_t channel, uint8_t slot, uint8_t* record);
+
+    /**
+     * @brief Dựng bản ghi (trừ seq và CRC) từ trạng thái
+     */
+    static void encode(const LaneSnapshot& snapshot, uint8_t* record);
+};
+
+#endif
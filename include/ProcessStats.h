@@ -0,0 +1,201 @@
+/**
+ * @file ProcessStats.h
+ * @brief Thống kê quá trình (SPC) trực tuyến trên dòng trọng lượng của một làn
+ * @author FTH Arduino Uno Project
+ * @date 2026
+ *
+ * Mỗi sản phẩm đã phân loại được đưa vào add() một lần, với chi phí và RAM cố định:
+ * - Trung bình và phương sai theo Welford trên số nguyên: trung bình Q32 (int64), tổng
+ *   bình phương độ lệch uint64 (count²). Phần lẻ 32 bit để bước delta/n không bị làm tròn
+ *   về 0 khi n lớn (với Q8, σ = 30 count, trung bình đứng yên sau ~15 000 sản phẩm)
+ * - Biểu đồ tần suất SPC_HIST_BINS ô cố định trên dải của bảng phân hạng: ô đầu là dưới
+ *   dải, ô cuối là trên dải, mỗi sản phẩm một phép chia int32
+ * - Nhịp sản phẩm: trung bình trượt của khoảng cách giữa hai sản phẩm (như BeltSpeedEstimator)
+ * - Cảnh báo trôi: SPC_BASELINE_ITEMS sản phẩm đầu cho trung bình gốc μ0 và độ lệch
+ *   chuẩn gốc σ0. Sau đó CUSUM hai phía (K = σ0/2, H = SPC_CUSUM_H_SIGMA σ0) và EWMA
+ *   (λ = 1/SPC_EWMA_SMOOTHING, giới hạn L σ0 √(λ/(2−λ))) chạy trên số nguyên (count).
+ *   Cả hai bắt được trung bình trôi chậm (máy chiết rót lệch dần) khi sản phẩm vẫn còn
+ *   trong hạng đạt, trước khi chúng bị gạt.
+ *
+ * Mọi giá trị tính bằng count (đã trừ điểm 0), chỉ đổi sang gram ở biên Serial.
+ */
+
+#ifndef PROCESS_STATS_H
+#define PROCESS_STATS_H
+
+#include "Hal.h"
+
+// Số bit phần lẻ của trung bình Welford (Q32)
+constexpr uint8_t SPC_MEAN_SHIFT = 32;
+
+// Trọng lượng đưa vào Welford bị chặn ở ±(2^23 - 1) count (dải HX711) để độ lệch Q32 vừa int64
+constexpr int32_t SPC_WEIGHT_LIMIT = 8388607L;
+
+// Số ô của biểu đồ tần suất (kể cả ô dưới dải và ô trên dải)
+constexpr uint8_t SPC_HIST_BINS = 12;
+
+// Số sản phẩm đầu tiên dùng để lấy trung bình và độ lệch chuẩn gốc
+constexpr uint16_t SPC_BASELINE_ITEMS = 50;
+
+// Ngưỡng quyết định của CUSUM (số lần σ0); độ trượt cho phép K = σ0/2
+constexpr int32_t SPC_CUSUM_H_SIGMA = 5;
+
+// Trọng số của sản phẩm mới trong EWMA: λ = 1 / SPC_EWMA_SMOOTHING
+constexpr int32_t SPC_EWMA_SMOOTHING = 5;
+
+// Độ rộng giới hạn kiểm soát của EWMA (L); λ = 0.2, L = 3 cho giới hạn đúng bằng σ0
+constexpr int32_t SPC_EWMA_L = 3;
+
+// Trọng số của khoảng cách mới trong nhịp sản phẩm: 1 / SPC_RATE_SMOOTHING
+constexpr int32_t SPC_RATE_SMOOTHING = 8;
+
+// Cờ trạng thái (getFlags)
+enum SpcFlag : uint8_t {
+    SPC_BASELINE = 0x01,    // Đã có trung bình và độ lệch chuẩn gốc
+    SPC_CUSUM_HIGH = 0x02,  // CUSUM phía trên vượt H: trung bình trôi lên (tắt khi tổng về 0)
+    SPC_CUSUM_LOW = 0x04,   // CUSUM phía dưới vượt H: trung bình trôi xuống
+    SPC_EWMA_HIGH = 0x08,   // EWMA trên giới hạn trên (tắt khi EWMA về lại μ0)
+    SPC_EWMA_LOW = 0x10     // EWMA dưới giới hạn dưới
+};
+
+// Các cờ cảnh báo trôi
+constexpr uint8_t SPC_ALARMS = SPC_CUSUM_HIGH | SPC_CUSUM_LOW | SPC_EWMA_HIGH | SPC_EWMA_LOW;
+
+class ProcessStats {
+private:
+    uint32_t count;                 ///< Số sản phẩm từ lần reset
+    int64_t meanQ32;                ///< Trung bình Welford (count, Q32)
+    uint64_t m2;                    ///< Tổng bình phương độ lệch Welford (count²)
+    int32_t histLow;                ///< Cận dưới của ô 1 (count)
+    int32_t histWidth;              ///< Độ rộng một ô (count, >= 1)
+    uint16_t histogram[SPC_HIST_BINS];  ///< Số sản phẩm mỗi ô (bão hòa ở 65535)
+    unsigned long lastItemMs;       ///< Thời điểm (millis) sản phẩm trước
+    int32_t intervalMs;             ///< Khoảng cách trung bình giữa hai sản phẩm (ms, 0: chưa có)
+    int32_t refMean;                ///< Trung bình gốc μ0 (count)
+    int32_t refSigma;               ///< Độ lệch chuẩn gốc σ0 (count, >= 1)
+    int32_t cusumHigh;              ///< Tổng CUSUM phía trên (count)
+    int32_t cusumLow;               ///< Tổng CUSUM phía dưới (count)
+    int32_t ewma;                   ///< EWMA của trọng lượng (count)
+    int32_t ewmaLimit;              ///< Nửa độ rộng giới hạn EWMA quanh μ0 (count)
+    uint8_t flags;                  ///< SpcFlag đang bật
+    uint8_t raised;                 ///< Cờ cảnh báo vừa bật, chưa được lấy (takeRaised)
+    uint16_t alarmCount;            ///< Số lần một cảnh báo chuyển từ tắt sang bật
+
+public:
+    /**
+     * @brief Constructor - chưa có sản phẩm, biểu đồ một count mỗi ô từ 0
+     */
+    ProcessStats();
+
+    /**
+     * @brief Xóa mọi thống kê và lấy lại trung bình gốc từ các sản phẩm tiếp theo
+     * @details Dùng khi đổi sản phẩm hoặc chỉnh máy chiết rót (lệnh "b")
+     */
+    void reset();
+
+    /**
+     * @brief Đặt dải của biểu đồ: SPC_HIST_BINS - 2 ô đều nhau phủ [low, high)
+     * @details Dải thay đổi (đổi hệ số hiệu chuẩn) thì xóa biểu đồ; high <= low cho ô
+     *          rộng 1 count (chỉ còn ô dưới/trên dải có nghĩa)
+     */
+    void setRange(int32_t low, int32_t high);
+
+    /**
+     * @brief Thêm một sản phẩm đã phân loại
+     * @param rawWeight Trọng lượng (count)
+     * @param now Thời điểm ra quyết định (millis)
+     */
+    void add(int32_t rawWeight, unsigned long now);
+
+    /**
+     * @brief Các cờ cảnh báo vừa bật từ lần gọi trước (và xóa chúng)
+     */
+    uint8_t takeRaised();
+
+    /**
+     * @brief Số sản phẩm từ lần reset
+     */
+    uint32_t getCount() const;
+
+    /**
+     * @brief Trung bình (count, làm tròn)
+     */
+    int32_t getMean() const;
+
+    /**
+     * @brief Độ lệch chuẩn mẫu (count, 0 nếu chưa đủ 2 sản phẩm, bão hòa ở 65535)
+     */
+    uint16_t getStdDev() const;
+
+    /**
+     * @brief Số sản phẩm mỗi phút
+     * @param now millis() hiện tại: dây chuyền dừng thì nhịp giảm dần về 0
+     */
+    uint16_t getRatePerMinute(unsigned long now) const;
+
+    /**
+     * @brief Trung bình gốc μ0 (count, có nghĩa khi có SPC_BASELINE)
+     */
+    int32_t getRefMean() const;
+
+    /**
+     * @brief Độ lệch chuẩn gốc σ0 (count)
+     */
+    int32_t getRefSigma() const;
+
+    /**
+     * @brief EWMA của trọng lượng (count)
+     */
+    int32_t getEwma() const;
+
+    /**
+     * @brief Tổng CUSUM so với ngưỡng H (%, bão hòa ở 255)
+     * @param high true: phía trên, false: phía dưới
+     */
+    uint8_t getCusumPercent(bool high) const;
+
+    /**
+     * @brief Các SpcFlag đang bật
+     */
+    uint8_t getFlags() const;
+
+    /**
+     * @brief Số lần cảnh báo từ lần reset
+     */
+    uint16_t getAlarmCount() const;
+
+    /**
+     * @brief Cận dưới của ô 1 (count)
+     */
+    int32_t getHistLow() const;
+
+    /**
+     * @brief Độ rộng một ô (count)
+     */
+    int32_t getHistWidth() const;
+
+    /**
+     * @brief Số sản phẩm của một ô biểu đồ
+     */
+    uint16_t getBin(uint8_t bin) const;
+
+    /**
+     * @brief Ký hiệu xu hướng cho LCD: '^' trôi lên, 'v' trôi xuống, ' ' bình thường
+     */
+    char getTrend() const;
+
+private:
+    /**
+     * @brief Chốt trung bình, độ lệch chuẩn gốc và giới hạn EWMA sau SPC_BASELINE_ITEMS sản phẩm
+     */
+    void freezeBaseline();
+
+    /**
+     * @brief Cập nhật một cờ cảnh báo, ghi nhận lần chuyển từ tắt sang bật
+     * @param trip Thống kê vượt giới hạn: bật cờ
+     * @param clear Thống kê đã về tâm: tắt cờ (giữa hai mức thì giữ nguyên)
+     */
+    void updateAlarm(uint8_t flag, bool trip, bool clear);
+};
+
+#endif
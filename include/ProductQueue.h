@@ -0,0 +1,77 @@
+/**
+ * @file ProductQueue.h
+ * @brief Hàng đợi vòng (ring buffer) các sản phẩm đang di chuyển trên băng chuyền
+ * @author FTH Arduino Uno Project
+ * @date 2026
+ * 
+ * Mỗi sản phẩm sau khi cân được đưa vào hàng đợi cùng với kết quả phân loại và
+ * thời điểm nó tới vị trí servo 2. Nhờ vậy sản phẩm tiếp theo có thể được cân
+ * trong khi các sản phẩm trước vẫn đang trên băng chuyền.
+ * Dung lượng cố định, không dùng cấp phát động.
+ */
+
+#ifndef PRODUCT_QUEUE_H
+#define PRODUCT_QUEUE_H
+
+#include "Hal.h"
+#include "GradeEngine.h"
+
+// Số sản phẩm tối đa có thể cùng lúc nằm trên băng chuyền
+constexpr uint8_t PRODUCT_QUEUE_CAPACITY = 8;
+
+/**
+ * @brief Thông tin một sản phẩm đang di chuyển
+ */
+struct TrackedProduct {
+    int32_t rawWeight;        ///< Trọng lượng đo được (count của HX711)
+    uint8_t action;           ///< Cơ cấu xử lý khi tới servo 2 (EjectAction của hạng)
+    unsigned long ejectTime;  ///< Thời điểm (millis) sản phẩm tới vị trí servo 2
+};
+
+class ProductQueue {
+private:
+    TrackedProduct items[PRODUCT_QUEUE_CAPACITY];  ///< Bộ nhớ vòng chứa sản phẩm
+    uint8_t head;                                  ///< Vị trí sản phẩm cũ nhất
+    uint8_t count;                                 ///< Số sản phẩm hiện có
+
+public:
+    /**
+     * @brief Constructor - Khởi tạo hàng đợi rỗng
+     */
+    ProductQueue();
+    
+    /**
+     * @brief Thêm sản phẩm vào cuối hàng đợi
+     * @param product Thông tin sản phẩm
+     * @return false nếu hàng đợi đã đầy
+     */
+    bool push(const TrackedProduct& product);
+    
+    /**
+     * @brief Lấy sản phẩm cũ nhất (đầu hàng đợi) mà không xóa
+     * @note Chỉ gọi khi hàng đợi không rỗng
+     */
+    const TrackedProduct& peek() const;
+    
+    /**
+     * @brief Xóa sản phẩm cũ nhất khỏi hàng đợi
+     */
+    void pop();
+    
+    /**
+     * @brief Kiểm tra hàng đợi rỗng
+     */
+    bool isEmpty() const;
+    
+    /**
+     * @brief Kiểm tra hàng đợi đầy
+     */
+    bool isFull() const;
+    
+    /**
+     * @brief Số sản phẩm đang nằm trên băng chuyền
+     */
+    uint8_t size() const;
+};
+
+#endif
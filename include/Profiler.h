@@ -0,0 +1,151 @@
+/**
+ * @file Profiler.h
+ * @brief Đo thời gian từng giai đoạn của vòng lặp điều khiển bằng micros()
+ * @author FTH Arduino Uno Project
+ * @date 2026
+ * 
+ * Bật bằng cờ biên dịch PROFILER_ENABLED (build_flags = -DPROFILER_ENABLED trong
+ * platformio.ini). Khi tắt, các macro PROFILE_* không sinh ra lệnh nào và class
+ * Profiler không được biên dịch.
+ * 
+ * Mỗi giai đoạn giữ số lần, tổng, min, max (µs) và histogram log2 với bộ nhớ cố định.
+ * Bucket i đếm các lần đo trong [2^i, 2^(i+1)) µs, bucket 0 gồm cả 0 µs, bucket cuối
+ * gồm mọi giá trị lớn hơn. Giai đoạn PROF_LOOP đo khoảng cách giữa hai lần gọi run():
+ * tần số vòng lặp = 1e6 / mean, độ rung (jitter) = max - min.
+ * 
+ * Chi phí mỗi điểm đo: 2 lần micros() (~4 µs mỗi lần) + cập nhật thống kê (~60 chu kỳ).
+ * Gửi "p" qua Serial để xuất kết quả, "r" để xóa.
+ */
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include "Hal.h"
+
+// Các giai đoạn được đo
+enum ProfileStage {
+    PROF_LOOP,       // Chu kỳ vòng lặp (khoảng cách giữa hai lần run())
+    PROF_HX711,      // Đọc HX711: ISR, Hx711Driver ở chế độ polling hoặc MultiLoadCell
+    PROF_FILTER,     // Median, EMA và bộ phát hiện ổn định cho mỗi mẫu
+    PROF_CLASSIFY,   // Phân loại và lên lịch servo cho một sản phẩm
+    PROF_SERVO,      // Bộ lập lịch servo và hàng đợi servo 2
+    PROF_DISPLAY,    // Gửi các ô LCD thay đổi qua I2C
+    PROF_SERIAL,     // Ghi telemetry vào bộ đệm Serial
+    PROF_STAGE_COUNT
+};
+
+// Số bucket của histogram log2 (bucket cuối: >= 2^15 µs)
+constexpr uint8_t PROFILER_BUCKETS = 16;
+
+/**
+ * @brief Thống kê của một giai đoạn
+ */
+struct ProfileStats {
+    uint32_t count;                       ///< Số lần đo (giảm một nửa cùng total khi total sắp tràn)
+    uint32_t total;                       ///< Tổng thời gian (µs)
+    uint16_t minUs;                       ///< Nhỏ nhất (µs, bão hòa ở 65535)
+    uint16_t maxUs;                       ///< Lớn nhất (µs, bão hòa ở 65535)
+    uint8_t histogram[PROFILER_BUCKETS];  ///< Số lần đo theo bucket log2 (chia đôi khi đầy)
+};
+
+#ifdef PROFILER_ENABLED
+
+class Profiler {
+private:
+    ProfileStats stats[PROF_STAGE_COUNT];  ///< Thống kê từng giai đoạn
+    unsigned long lastLoopStart;           ///< Thời điểm lần gọi run() trước (µs)
+    bool loopStarted;                      ///< Đã có lần gọi run() trước hay chưa
+    uint8_t dumpStage;                     ///< Giai đoạn xuất tiếp theo (PROF_STAGE_COUNT = không xuất)
+
+public:
+    /**
+     * @brief Constructor - Khởi tạo thống kê rỗng
+     */
+    Profiler();
+    
+    /**
+     * @brief Ghi một lần đo
+     * @param stage Giai đoạn
+     * @param us Thời gian (µs)
+     * @details An toàn khi gọi từ ISR cho giai đoạn chỉ ISR ghi (PROF_HX711)
+     */
+    void record(ProfileStage stage, unsigned long us);
+    
+    /**
+     * @brief Đánh dấu đầu vòng lặp để đo chu kỳ và độ rung
+     */
+    void markLoop();
+    
+    /**
+     * @brief Sao chép thống kê của một giai đoạn (tắt ngắt trong lúc chép)
+     */
+    void snapshot(ProfileStage stage, ProfileStats& out) const;
+    
+    /**
+     * @brief Xóa toàn bộ thống kê
+     */
+    void reset();
+    
+    /**
+     * @brief Yêu cầu xuất thống kê - mỗi lần gọi nextDump() trả về một giai đoạn
+     */
+    void requestDump();
+    
+    /**
+     * @brief Giai đoạn cần xuất tiếp theo
+     * @param stage Giai đoạn (ra)
+     * @return false nếu không còn giai đoạn nào cần xuất
+     */
+    bool nextDump(ProfileStage& stage);
+    
+    /**
+     * @brief Xuất giai đoạn vừa lấy bị bỏ (Serial bận) - thử lại ở lần sau
+     */
+    void retryDump();
+    
+    /**
+     * @brief Giá trị trung bình (µs)
+     */
+    static uint16_t mean(const ProfileStats& stats);
+    
+    /**
+     * @brief Tên ngắn của giai đoạn (cho chế độ chữ), nằm trong Flash (Messages.h)
+     */
+    static const __FlashStringHelper* stageName(ProfileStage stage);
+
+private:
+    /**
+     * @brief Đặt lại thống kê (không tắt ngắt - dùng trong constructor)
+     */
+    void clearStats();
+};
+
+// Đối tượng profiler dùng chung bởi các macro
+extern Profiler profiler;
+
+/**
+ * @brief Đo thời gian từ lúc tạo tới lúc ra khỏi phạm vi
+ */
+class ProfileScope {
+private:
+    ProfileStage stage;
+    unsigned long start;
+
+public:
+    explicit ProfileScope(ProfileStage stage) : stage(stage), start(micros()) {}
+    ~ProfileScope() { profiler.record(stage, micros() - start); }
+};
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_SCOPE(stage) ProfileScope PROFILE_CONCAT(profileScope_, __LINE__)(stage)
+#define PROFILE_LOOP() profiler.markLoop()
+
+#else
+
+#define PROFILE_SCOPE(stage) do { } while (0)
+#define PROFILE_LOOP() do { } while (0)
+
+#endif
+
+#endif
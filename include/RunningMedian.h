@@ -0,0 +1,76 @@
+/**
+ * @file RunningMedian.h
+ * @brief Median trượt (sliding window) cập nhật tăng dần cho mẫu HX711
+ * @author FTH Arduino Uno Project
+ * @date 2026
+ * 
+ * Giữ N mẫu gần nhất ở hai dạng: theo thứ tự thời gian (để biết mẫu nào cũ nhất)
+ * và đã sắp xếp (để lấy median). Mỗi mẫu mới chỉ cần xóa mẫu cũ nhất và chèn mẫu
+ * mới vào mảng đã sắp xếp (tìm vị trí bằng binary search), không phải sắp xếp lại
+ * cả cửa sổ. Với N <= 7 chi phí mỗi mẫu là hằng số nhỏ.
+ */
+
+#ifndef RUNNING_MEDIAN_H
+#define RUNNING_MEDIAN_H
+
+#include "Hal.h"
+
+// Kích thước cửa sổ tối đa
+constexpr uint8_t MEDIAN_MAX_WINDOW = 7;
+
+class RunningMedian {
+private:
+    int32_t ring[MEDIAN_MAX_WINDOW];    ///< Mẫu theo thứ tự thời gian (vòng)
+    int32_t sorted[MEDIAN_MAX_WINDOW];  ///< Cùng các mẫu đó, sắp xếp tăng dần
+    uint8_t window;                     ///< Kích thước cửa sổ hiện tại
+    uint8_t next;                       ///< Vị trí ghi tiếp theo trong ring
+    uint8_t count;                      ///< Số mẫu hợp lệ (<= window)
+
+public:
+    /**
+     * @brief Constructor
+     * @param window Kích thước cửa sổ (1..MEDIAN_MAX_WINDOW)
+     */
+    explicit RunningMedian(uint8_t window = 5);
+    
+    /**
+     * @brief Thêm một mẫu mới, bỏ mẫu cũ nhất nếu cửa sổ đã đầy
+     * @param sample Giá trị mới
+     * @return Median của cửa sổ sau khi thêm
+     */
+    int32_t add(int32_t sample);
+    
+    /**
+     * @brief Median hiện tại (0 nếu chưa có mẫu)
+     */
+    int32_t median() const;
+    
+    /**
+     * @brief Đổi kích thước cửa sổ, giữ lại các mẫu mới nhất
+     * @param newWindow Kích thước mới (1..MEDIAN_MAX_WINDOW)
+     */
+    void setWindow(uint8_t newWindow);
+    
+    /**
+     * @brief Kích thước cửa sổ hiện tại
+     */
+    uint8_t getWindow() const;
+    
+    /**
+     * @brief Số mẫu đang có trong cửa sổ
+     */
+    uint8_t size() const;
+    
+    /**
+     * @brief Xóa toàn bộ mẫu
+     */
+    void reset();
+
+private:
+    /**
+     * @brief Vị trí đầu tiên trong sorted có giá trị >= value (binary search)
+     */
+    uint8_t lowerBound(int32_t value) const;
+};
+
+#endif
@@ -0,0 +1,56 @@
+/**
+ * @file SampleBuffer.h
+ * @brief Bộ đệm vòng một-ghi/một-đọc (SPSC) không khóa cho mẫu thô của HX711
+ * @author FTH Arduino Uno Project
+ * @date 2026
+ * 
+ * ISR là bên ghi duy nhất (chỉ thay đổi head), vòng lặp chính là bên đọc duy nhất
+ * (chỉ thay đổi tail). Chỉ số 8 bit được đọc/ghi nguyên tử trên AVR nên không cần
+ * tắt ngắt khi truy cập. Khi đầy, mẫu mới bị bỏ và được đếm là overrun.
+ */
+
+#ifndef SAMPLE_BUFFER_H
+#define SAMPLE_BUFFER_H
+
+#include "Hal.h"
+
+// Dung lượng bộ đệm (lũy thừa của 2 để phép chia lấy dư thành phép AND)
+constexpr uint8_t SAMPLE_BUFFER_SIZE = 8;
+
+class SampleBuffer {
+private:
+    volatile int32_t data[SAMPLE_BUFFER_SIZE];  ///< Các mẫu thô 24 bit đã mở rộng dấu
+    volatile uint16_t stamps[SAMPLE_BUFFER_SIZE];  ///< 16 bit thấp của millis() lúc ghi mẫu
+    volatile uint8_t head;                      ///< Vị trí ghi tiếp theo (chỉ ISR thay đổi)
+    volatile uint8_t tail;                      ///< Vị trí đọc tiếp theo (chỉ loop thay đổi)
+    volatile uint8_t overruns;                  ///< Số mẫu bị bỏ do bộ đệm đầy
+
+public:
+    /**
+     * @brief Constructor - Khởi tạo bộ đệm rỗng
+     */
+    SampleBuffer();
+    
+    /**
+     * @brief Ghi một mẫu (gọi từ ISR)
+     * @param sample Giá trị thô
+     * @param stamp 16 bit thấp của millis() lúc chuyển đổi xong
+     * @return false nếu bộ đệm đầy và mẫu bị bỏ
+     */
+    bool push(int32_t sample, uint16_t stamp);
+    
+    /**
+     * @brief Đọc mẫu cũ nhất (gọi từ vòng lặp chính)
+     * @param sample Biến nhận giá trị
+     * @param stamp Biến nhận thời điểm ghi (16 bit thấp của millis())
+     * @return false nếu bộ đệm rỗng
+     */
+    bool pop(int32_t& sample, uint16_t& stamp);
+    
+    /**
+     * @brief Số mẫu bị bỏ do bên đọc không kịp lấy
+     */
+    uint8_t getOverruns() const;
+};
+
+#endif
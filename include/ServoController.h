@@ -11,15 +11,63 @@
 #ifndef SERVO_CONTROLLER_H
 #define SERVO_CONTROLLER_H
 
-#include <Arduino.h>
-#include "Servo.h"
+#include "Hal.h"
+#include "MotionProfile.h"
+
+// Định danh servo cho bộ lập lịch
+enum ServoId {
+    SERVO_1 = 0,    // Servo đẩy sản phẩm từ cân lên băng chuyền
+    SERVO_2 = 1,    // Servo gạt sản phẩm lỗi ra khỏi băng chuyền
+    SERVO_COUNT
+};
+
+// Giới hạn chuyển động mặc định (chỉnh theo servo thực tế để không vọt lố/rung)
+constexpr uint16_t SERVO_DEFAULT_MAX_SPEED = 600;    // độ/giây
+constexpr uint16_t SERVO_DEFAULT_MAX_ACCEL = 6000;   // độ/giây^2
+
+// Góc của servo ngay sau attach() (thư viện Servo phát xung 1500us = 90°)
+constexpr int SERVO_ATTACH_ANGLE = 90;
+
+// Trạng thái lệnh của một servo
+enum ServoPhase {
+    SERVO_IDLE,         // Không có lệnh, servo ở vị trí nghỉ
+    SERVO_PENDING,      // Đã lên lịch, chưa tới thời điểm bắt đầu
+    SERVO_MOVING_OUT,   // Đang chạy theo quỹ đạo tới góc đích
+    SERVO_HOLDING,      // Đang ở góc đích, chờ tới thời điểm quay về
+    SERVO_MOVING_BACK   // Đang chạy theo quỹ đạo về góc nghỉ
+};
+
+/**
+ * @brief Giới hạn chuyển động của một servo
+ */
+struct ServoLimits {
+    uint16_t maxSpeed;          ///< Vận tốc tối đa (độ/giây)
+    uint16_t maxAccel;          ///< Gia tốc tối đa (độ/giây^2)
+    MotionProfileType profile;  ///< Dạng quỹ đạo
+};
+
+/**
+ * @brief Lệnh "tới góc A tại thời điểm T, giữ d ms rồi quay về"
+ */
+struct ServoCommand {
+    ServoPhase phase;          ///< Trạng thái lệnh
+    int fromAngle;             ///< Góc bắt đầu của đoạn chuyển động hiện tại
+    int targetAngle;           ///< Góc đích
+    int returnAngle;           ///< Góc quay về khi kết thúc
+    unsigned long startTime;   ///< Thời điểm (millis) bắt đầu giai đoạn hiện tại
+    unsigned long holdTime;    ///< Thời gian giữ ở góc đích (ms)
+    uint16_t moveTime;         ///< Thời gian của đoạn chuyển động hiện tại (ms)
+};
 
 class ServoController {
 private:
-    Servo servo1;   ///< Servo motor thứ nhất để phân loại
-    Servo servo2;   ///< Servo motor thứ hai để phân loại
+    HalServo servo1;   ///< Servo motor thứ nhất để phân loại
+    HalServo servo2;   ///< Servo motor thứ hai để phân loại
     int servo1Pin;  ///< Chân điều khiển PWM cho servo 1
     int servo2Pin;  ///< Chân điều khiển PWM cho servo 2
+    ServoCommand commands[SERVO_COUNT];  ///< Lệnh đang chờ/đang chạy của từng servo
+    ServoLimits limits[SERVO_COUNT];     ///< Giới hạn vận tốc/gia tốc của từng servo
+    int currentAngle[SERVO_COUNT];       ///< Góc đã ghi gần nhất của từng servo
 
 public:
     /**
@@ -31,19 +79,70 @@ public:
     
     /**
      * @brief Khởi tạo và kiểm tra hoạt động của các servo
-     * @details Attach servo vào chân PWM, thực hiện test chuyển động để kiểm tra
+     * @details Attach servo vào chân PWM, lên lịch test chuyển động (90° rồi về 0°)
+     *          và trả về ngay, không chờ servo
      */
     void init();
     
+    /**
+     * @brief Lên lịch một chuyển động: tới góc angle tại startTime, giữ holdMs rồi quay về
+     * @param id Servo cần điều khiển
+     * @param angle Góc đích (0-180 độ)
+     * @param startTime Thời điểm bắt đầu (millis), có thể ở tương lai
+     * @param holdMs Thời gian giữ ở góc đích sau khi tới nơi, trước khi quay về
+     * @param returnAngle Góc quay về (mặc định 0°)
+     * @return false nếu servo đang bận với lệnh khác
+     * @details Cả chiều đi và chiều về chạy theo quỹ đạo với giới hạn của servo
+     */
+    bool scheduleMove(ServoId id, int angle, unsigned long startTime, unsigned long holdMs,
+                      int returnAngle = 0);
+    
+    /**
+     * @brief Thực thi các lệnh đã tới hạn - gọi ở mỗi vòng lặp
+     */
+    void update();
+    
+    /**
+     * @brief Servo còn lệnh chưa hoàn thành hay không (kể cả chiều về)
+     * @param id Servo cần kiểm tra
+     */
+    bool isBusy(ServoId id) const;
+    
+    /**
+     * @brief Đặt giới hạn chuyển động cho servo
+     * @param id Servo cần cấu hình
+     * @param maxSpeed Vận tốc tối đa (độ/giây)
+     * @param maxAccel Gia tốc tối đa (độ/giây^2)
+     * @param profile Dạng quỹ đạo (trapezoid hoặc S-curve)
+     */
+    void setMotionLimits(ServoId id, uint16_t maxSpeed, uint16_t maxAccel,
+                         MotionProfileType profile = PROFILE_SCURVE);
+    
+    /**
+     * @brief Thời gian (ms) để servo đi giữa hai góc theo giới hạn hiện tại
+     * @param id Servo cần tính
+     * @param fromAngle Góc bắt đầu
+     * @param toAngle Góc đích
+     */
+    uint16_t getMoveTime(ServoId id, int fromAngle, int toAngle) const;
+    
+    /**
+     * @brief Hủy lệnh đang chờ/đang chạy của servo (không thay đổi góc hiện tại)
+     * @param id Servo cần hủy
+     */
+    void cancel(ServoId id);
+    
     /**
      * @brief Điều khiển góc xoay của servo 1
      * @param angle Góc xoay mong muốn (0-180 độ)
+     * @details Ghi ngay lập tức và hủy lệnh đã lên lịch của servo 1
      */
     void setServo1Angle(int angle);
     
     /**
      * @brief Điều khiển góc xoay của servo 2
      * @param angle Góc xoay mong muốn (0-180 độ)
+     * @details Ghi ngay lập tức và hủy lệnh đã lên lịch của servo 2
      */
     void setServo2Angle(int angle);
     
@@ -56,8 +155,26 @@ public:
     
     /**
      * @brief Đưa tất cả servo về vị trí ban đầu (0 độ)
+     * @details Hủy mọi lệnh đã lên lịch
      */
     void resetPosition();
+
+private:
+    /**
+     * @brief Ghi góc cho servo theo định danh (bỏ qua nếu góc không đổi)
+     */
+    void writeAngle(ServoId id, int angle);
+    
+    /**
+     * @brief Bắt đầu một đoạn chuyển động từ góc hiện tại tới toAngle
+     */
+    void beginMove(ServoId id, ServoPhase phase, int toAngle, unsigned long startTime);
+    
+    /**
+     * @brief Cập nhật góc theo quỹ đạo của đoạn chuyển động hiện tại
+     * @return true khi đoạn chuyển động đã kết thúc
+     */
+    bool stepMove(ServoId id, int toAngle, unsigned long now);
 };
 
 #endif
@@ -0,0 +1,68 @@
+/**
+ * @file SettleDetector.h
+ * @brief Phát hiện trọng lượng đã ổn định sau khi đặt sản phẩm lên cân
+ * @author FTH Arduino Uno Project
+ * @date 2026
+ *
+ * Khi sản phẩm rơi lên cân, tín hiệu dao động tắt dần quanh giá trị cuối W. Median
+ * trượt của WeightFilter về gần W sớm (dao động đối xứng quanh W) nhưng tự nó không
+ * cho biết lúc nào đã tới: ở 10 SPS cửa sổ 5 mẫu dài hơn một chu kỳ dao động, median
+ * có thể giữ nguyên một mẫu lệch vài gram suốt 3 lần cập nhật.
+ * Bộ phát hiện vì vậy xét mẫu thô: đoạn mẫu liên tiếp gần nhất có biên độ (max - min)
+ * không quá dung sai. Đoạn đủ dài thì dao động đã tắt và median của bộ lọc (trọng
+ * lượng được dùng để phân loại) nằm trong dải của đoạn. Chỉ dùng int32, hai phép so
+ * sánh mỗi mẫu.
+ *
+ * Trước đây là SettlingPredictor: khớp mô hình bậc hai tắt dần bằng float rồi ngoại
+ * suy W. Bench (docs/PERFORMANCE.md mục 7) cho sai số ~1 g ở 10 SPS và 1.7-2.8 g ở
+ * 80 SPS, tức lớn hơn dung sai, với ~25 000 chu kỳ mỗi mẫu.
+ */
+
+#ifndef SETTLE_DETECTOR_H
+#define SETTLE_DETECTOR_H
+
+#include "Hal.h"
+
+// Số mẫu tối thiểu của đoạn ổn định
+constexpr uint8_t SETTLE_MIN_RUN = 3;
+
+class SettleDetector {
+private:
+    int32_t tolerance;   ///< Biên độ tối đa của đoạn ổn định (count)
+    uint8_t runLength;   ///< Số mẫu cần có của đoạn ổn định
+    int32_t lo;          ///< Mẫu nhỏ nhất của đoạn
+    int32_t hi;          ///< Mẫu lớn nhất của đoạn
+    uint8_t run;         ///< Số mẫu của đoạn (bão hòa ở runLength)
+
+public:
+    /**
+     * @brief Constructor
+     * @param tolerance Biên độ tối đa của đoạn ổn định (count)
+     */
+    explicit SettleDetector(int32_t tolerance = 0);
+
+    /**
+     * @brief Bắt đầu theo dõi một lần cân mới
+     * @param samples Số mẫu của đoạn ổn định (ít nhất SETTLE_MIN_RUN)
+     * @param tolerance Biên độ tối đa của đoạn (count)
+     */
+    void reset(uint8_t samples, int32_t tolerance);
+
+    /**
+     * @brief Thêm một mẫu thô (đã trừ điểm 0)
+     * @param sample Trọng lượng (count)
+     */
+    void update(int32_t sample);
+
+    /**
+     * @brief Đã có đoạn ổn định đủ dài chưa
+     */
+    bool isSettled() const;
+
+    /**
+     * @brief Độ tin cậy (0..100%): 100 khi đoạn phẳng, 50 khi biên độ bằng dung sai
+     */
+    uint8_t getConfidence() const;
+};
+
+#endif
@@ -5,97 +5,92 @@
  * @date 2026
  * 
  * Đây là class chính điều phối tất cả các module trong hệ thống phân loại sản phẩm.
- * Nó tích hợp LoadCellManager, ServoController và DisplayManager để thực hiện
- * quy trình: Đo trọng lượng -> Phân loại -> Hiển thị kết quả
+ * Mỗi làn (LaneController) tự thực hiện quy trình: Đo trọng lượng -> Phân loại -> Gạt;
+ * SystemController khởi tạo các làn, gọi chúng lần lượt trong mỗi vòng lặp và quản lý
+ * phần dùng chung: màn hình, telemetry và lệnh từ Serial
  */
 
 #ifndef SYSTEM_CONTROLLER_H
 #define SYSTEM_CONTROLLER_H
 
-#include <Arduino.h>
-#include "LoadCellManager.h"
-#include "ServoController.h"
+#include "Hal.h"
+#include "LaneController.h"
 #include "DisplayManager.h"
+#include "Telemetry.h"
+#include "Profiler.h"
+#include "MemoryMonitor.h"
+#include "PersistentStore.h"
 
-// Trạng thái hệ thống
-enum SystemState {
-    STATE_IDLE,       // Chờ sản phẩm
-    STATE_WEIGHING,   // Đang cân
-    STATE_SORTING     // Đang phân loại
-};
+// Số làn tối đa - giới hạn bởi số kênh trên SCK chung (MultiLoadCell)
+constexpr uint8_t MAX_LANES = MULTI_LOADCELL_MAX_CHANNELS;
+static_assert(MAX_LANES <= PERSIST_CHANNELS, "EEPROM can mot vung cho moi lan");
 
 class SystemController {
 private:
-    LoadCellManager* loadCell;          ///< Con trỏ đến module quản lý cân điện tử
-    ServoController* servoController;   ///< Con trỏ đến module điều khiển servo
+    LaneController* lanes[MAX_LANES];   ///< Các làn phân loại
+    uint8_t laneCount;                  ///< Số làn đang dùng
     DisplayManager* display;            ///< Con trỏ đến module quản lý màn hình
-    
-    int irSensorPin;                    ///< Cảm biến IR phát hiện sản phẩm đến cân
-    int irCountPin;                     ///< Cảm biến IR đếm sản phẩm đạt chuẩn
-    
-    float weightMin;                    ///< Ngưỡng trọng lượng tối thiểu (gram)
-    float weightMax;                    ///< Ngưỡng trọng lượng tối đa (gram)
-    
-    int passCount;                      ///< Số sản phẩm đạt chuẩn
-    int rejectCount;                    ///< Số sản phẩm bị loại
-    
-    SystemState currentState;           ///< Trạng thái hiện tại
-    bool lastIRCountState;              ///< Trạng thái trước của cảm biến đếm (để phát hiện cạnh)
+    Telemetry* telemetry;               ///< Con trỏ đến module xuất dữ liệu qua Serial
+    uint8_t captureLane;                ///< Làn đang ghi mẫu thô (laneCount: không ghi)
+    uint8_t gradeLane;                  ///< Làn xuất bộ đếm từng hạng tiếp theo (laneCount: không xuất)
+    uint8_t statsStep;                  ///< Khung thống kê tiếp theo: làn * 2 + (0: thống kê, 1: biểu đồ)
+    MultiLoadCell* sharedClock;         ///< Bộ đọc HX711 trên SCK chung (nullptr: mỗi làn tự đọc)
+    PersistentStore* store;             ///< Trạng thái các làn trong EEPROM (nullptr: không lưu)
+    uint8_t persistLane;                ///< Làn lưu tiếp theo trong lượt lưu (laneCount: xong lượt)
+    unsigned long lastPersist;          ///< Thời điểm (millis) bắt đầu lượt lưu trước
 
 public:
     /**
-     * @brief Constructor - Khởi tạo SystemController với các module con
-     * @param loadCell Con trỏ đến đối tượng LoadCellManager
-     * @param servoController Con trỏ đến đối tượng ServoController
+     * @brief Constructor - Khởi tạo SystemController với các làn và module dùng chung
+     * @param lanes Mảng con trỏ tới các làn (lanes[0] là làn 1 trên màn hình)
+     * @param laneCount Số làn (1..MAX_LANES, phần thừa bị bỏ qua)
      * @param display Con trỏ đến đối tượng DisplayManager
-     * @param irSensorPin Chân cảm biến IR phát hiện sản phẩm
-     * @param irCountPin Chân cảm biến IR đếm sản phẩm đạt chuẩn
-     * @param weightMin Ngưỡng trọng lượng tối thiểu
-     * @param weightMax Ngưỡng trọng lượng tối đa
+     * @param telemetry Con trỏ đến đối tượng Telemetry (chữ hoặc nhị phân)
+     * @param sharedClock Bộ đọc HX711 trên SCK chung, được gọi ở mỗi vòng lặp để mẫu
+     *                    vẫn được lấy khi không làn nào đang đọc cân (đẩy, chờ rời cân)
+     * @param store Nơi lưu điểm 0, hệ số hiệu chuẩn và bộ đếm của các làn (EEPROM)
      */
-    SystemController(LoadCellManager* loadCell, ServoController* servoController, DisplayManager* display,
-                     int irSensorPin, int irCountPin, float weightMin, float weightMax);
+    SystemController(LaneController* const lanes[], uint8_t laneCount, DisplayManager* display,
+                     Telemetry* telemetry, MultiLoadCell* sharedClock = nullptr,
+                     PersistentStore* store = nullptr);
     
     /**
      * @brief Khởi tạo tất cả các module của hệ thống
-     * @details Khởi động Serial, LoadCell, Servo và Display theo thứ tự
+     * @details Khởi động Telemetry (Serial), từng làn (IR, LoadCell, Servo) và Display.
+     *          Làn có trạng thái trong EEPROM khởi động nhanh (không tare chặn)
      */
     void init();
     
     /**
-     * @brief Thực thi chu trình chính của hệ thống
-     * @details Đo trọng lượng -> Hiển thị -> Phân loại sản phẩm
+     * @brief Thực thi một bước của hệ thống
+     * @details Xử lý lệnh Serial, đọc HX711 trên SCK chung (nếu có), chạy một bước máy
+     *          trạng thái của từng làn, lưu dần trạng thái vào EEPROM rồi cập nhật
+     *          màn hình. Hàm trả về ngay sau mỗi lần gọi, mọi khoảng chờ đều tính bằng millis()
      */
     void run();
     
     /**
-     * @brief Lấy số sản phẩm đạt chuẩn
+     * @brief Lấy tổng số sản phẩm đạt chuẩn của mọi làn
      */
     int getPassCount();
     
     /**
-     * @brief Lấy số sản phẩm bị loại
+     * @brief Lấy tổng số sản phẩm bị loại của mọi làn
      */
     int getRejectCount();
     
 private:
     /**
-     * @brief Kiểm tra sản phẩm có đạt chuẩn không
-     * @param weight Trọng lượng sản phẩm (gram)
-     * @return true nếu đạt chuẩn [50-200g], false nếu loại
-     */
-    bool isProductValid(float weight);
-    
-    /**
-     * @brief Xử lý logic phân loại dựa trên trọng lượng
-     * @param weight Trọng lượng cần xử lý (gram)
+     * @brief Xử lý lệnh từ Serial (ghi mẫu thô, RAM, tare, hạng, SPC, profiler) và xuất dần
+     *        các kết quả nhiều khung
      */
-    void processWeight(float weight);
+    void serviceCommands();
     
     /**
-     * @brief Kiểm tra và đếm sản phẩm đạt chuẩn từ cảm biến IR cuối băng chuyền
+     * @brief Lưu dần trạng thái các làn vào EEPROM, mỗi PERSIST_INTERVAL_MS một lượt
+     * @details Mỗi vòng lặp ghi tối đa một byte EEPROM, mỗi lần chỉ chuẩn bị một làn
      */
-    void checkPassCounter();
+    void persistState();
 };
 
 #endif
@@ -0,0 +1,320 @@
+/**
+ * @file Telemetry.h
+ * @brief Xuất dữ liệu vận hành qua Serial: dạng chữ (debug) hoặc khung nhị phân gọn
+ * @author FTH Arduino Uno Project
+ * @date 2026
+ * 
+ * Khung nhị phân:  [0xA5][type][len][payload (len byte)][crc8]
+ * - CRC-8 (đa thức 0x07, giá trị đầu 0x00) tính trên type, len và payload
+ * - Số nhiều byte ghi theo little-endian
+ * Khung chỉ được gửi khi bộ đệm TX còn đủ chỗ; nếu không thì bỏ khung và đếm lại,
+ * để Serial không bao giờ chặn vòng lặp điều khiển.
+ * Giải mã trên máy tính: tools/telemetry_decode.py (xuất CSV).
+ *
+ * Ghi mẫu thô HX711 (FRAME_SAMPLES), mỗi khung giải mã được độc lập:
+ *   [seq][t0: 4 byte][raw0: 3 byte, int24] rồi mỗi mẫu tiếp theo
+ *   [varint: dt ms][varint zigzag: raw - raw trước]
+ * Nhiễu vài chục count và chu kỳ 12..100 ms nên mỗi mẫu thường chỉ tốn 2 byte.
+ * seq tăng cả khi khung bị bỏ, để máy tính biết đoạn nào bị mất.
+ */
+
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include "Hal.h"
+#include "Profiler.h"
+#include "MemoryMonitor.h"
+#include "Messages.h"
+#include "GradeEngine.h"
+#include "ProcessStats.h"
+
+// Byte đồng bộ đầu khung
+constexpr uint8_t TELEMETRY_SYNC = 0xA5;
+
+// Kích thước payload tối đa của một khung
+constexpr uint8_t TELEMETRY_MAX_PAYLOAD = 32;
+
+// Chế độ xuất dữ liệu
+enum TelemetryMode {
+    TELEMETRY_TEXT,    // Các dòng chữ dễ đọc (debug trên bàn thử)
+    TELEMETRY_BINARY   // Khung nhị phân cố định kích thước (vận hành)
+};
+
+// Loại khung
+enum TelemetryFrameType {
+    FRAME_PRODUCT = 0x01,     // Kết quả một sản phẩm
+    FRAME_PASS_COUNT = 0x02,  // Cảm biến cuối băng chuyền phát hiện sản phẩm (kèm tốc độ băng)
+    FRAME_PROFILE = 0x03,     // Thống kê thời gian một giai đoạn (Profiler)
+    FRAME_CAPTURE_START = 0x04,  // Bắt đầu ghi mẫu thô: điểm 0 và hệ số hiệu chuẩn
+    FRAME_SAMPLES = 0x05,     // Một khối mẫu thô HX711 mã hóa delta
+    FRAME_MEMORY = 0x06,      // Ảnh chụp RAM (MemoryMonitor)
+    FRAME_ZERO = 0x07,        // Sự kiện điểm 0 của một làn (ZeroEvent)
+    FRAME_GRADES = 0x08,      // Bộ đếm từng hạng của một làn (GradeEngine)
+    FRAME_STATS = 0x09,       // Thống kê quá trình và cảnh báo trôi của một làn (ProcessStats)
+    FRAME_HISTOGRAM = 0x0A,   // Biểu đồ tần suất trọng lượng của một làn (ProcessStats)
+    FRAME_EVENT = 0x0B,       // Sự kiện của một làn (LaneEvent)
+    FRAME_CAPTURE_ZERO = 0x0C // Điểm 0 đổi giữa đoạn ghi mẫu thô (tự bám điểm 0)
+};
+
+// Phần đầu của FRAME_SAMPLES: seq (1), t0 (4), raw0 (3)
+constexpr uint8_t CAPTURE_HEADER_BYTES = 8;
+
+// Một mẫu mã hóa delta dài nhất: dt (5 byte varint) + delta raw 25 bit (4 byte varint)
+constexpr uint8_t CAPTURE_MAX_SAMPLE_BYTES = 9;
+
+// Sự kiện điểm 0 (cờ giữ trong LoadCellManager, làn gửi ngoài đường lấy mẫu)
+enum ZeroEvent : uint8_t {
+    ZERO_EVENT_RESTORE_FALLBACK = 0x01, // Điểm 0 đã lưu lệch quá dải kiểm tra, tare nền thay thế
+    ZERO_EVENT_TRACK_LIMIT = 0x02,      // Tự bám điểm 0 chạm ±ZERO_TRACK_LIMIT_G, cần tare lại
+    ZERO_EVENT_TARE_NO_DATA = 0x04      // Tare không đọc được HX711, giữ điểm 0 cũ
+};
+
+// Sự kiện của làn (cờ giữ trong LaneController, gửi từ run())
+enum LaneEvent : uint8_t {
+    LANE_EVENT_GRADE_UNSORTED = 0x01    // Cận dưới của bảng phân hạng không tăng dần
+};
+
+// Kết quả phân loại (suy ra từ hạng, xem GradeEngine::getVerdict)
+enum Verdict {
+    VERDICT_PASS = 0,    // Đạt chuẩn
+    VERDICT_LIGHT = 1,   // Loại - quá nhẹ
+    VERDICT_HEAVY = 2    // Loại - quá nặng
+};
+
+/**
+ * @brief Bản ghi kết quả một sản phẩm (payload của FRAME_PRODUCT, 28 byte)
+ */
+struct ProductRecord {
+    uint32_t timestamp;    ///< Thời điểm ra quyết định (millis)
+    int32_t rawWeight;     ///< Trọng lượng (count)
+    uint8_t verdict;       ///< Verdict
+    uint8_t confidence;    ///< Độ tin cậy của trọng lượng (%)
+    uint16_t passCount;    ///< Tổng số sản phẩm đạt chuẩn
+    uint16_t rejectCount;  ///< Tổng số sản phẩm bị loại
+    uint16_t settleMs;     ///< Thời gian từ lúc phát hiện tới lúc ra quyết định (ms)
+    uint16_t pushMs;       ///< Thời gian servo 1 đẩy và quay về (ms)
+    uint16_t inFlight;     ///< Số sản phẩm đang trên băng chuyền
+    uint8_t medianWindow;  ///< Cửa sổ median lúc cân (chọn theo nhiễu)
+    uint8_t sampleRate;    ///< Tốc độ lấy mẫu HX711 lúc cân (10/80 SPS)
+    uint16_t noiseCounts;  ///< Độ lệch chuẩn nhiễu ước lượng (count)
+    uint8_t lane;          ///< Làn của sản phẩm (0 = làn đầu)
+    uint8_t grade;         ///< Hạng trong bảng phân hạng của làn
+    int16_t zeroDrift;     ///< Độ trôi điểm 0 đã tự bám từ lần tare (count, bão hòa)
+};
+
+class Telemetry {
+private:
+    HardwareSerial& port;    ///< Cổng Serial dùng để xuất
+    unsigned long baud;      ///< Tốc độ baud
+    TelemetryMode mode;      ///< Chế độ xuất
+    uint8_t frame[TELEMETRY_MAX_PAYLOAD + 4];  ///< Bộ đệm dựng khung
+    uint8_t length;          ///< Số byte payload đã ghi vào khung hiện tại
+    uint16_t droppedFrames;  ///< Số khung bị bỏ do bộ đệm TX đầy
+    
+    uint8_t capture[TELEMETRY_MAX_PAYLOAD];  ///< Khối mẫu thô đang gom (payload FRAME_SAMPLES)
+    uint8_t captureLength;   ///< Số byte đã gom, 0 = khối rỗng
+    uint8_t captureSeq;      ///< Số thứ tự khối tiếp theo
+    uint32_t captureTime;    ///< Thời điểm của mẫu trước (ms)
+    int32_t captureRaw;      ///< Giá trị của mẫu trước
+    int32_t captureTare;     ///< Điểm 0 của đoạn ghi hiện tại
+    int32_t captureScaleQ8;  ///< Hệ số hiệu chuẩn Q8 của đoạn ghi hiện tại
+    bool captureStartPending;///< FRAME_CAPTURE_START chưa gửi được (bộ đệm TX đầy)
+    bool captureZeroPending; ///< FRAME_CAPTURE_ZERO chưa gửi được (bộ đệm TX đầy)
+
+public:
+    /**
+     * @brief Constructor
+     * @param port Cổng Serial (thường là Serial)
+     * @param baud Tốc độ baud (chế độ nhị phân nên dùng 115200 trở lên)
+     * @param mode Chế độ xuất
+     */
+    Telemetry(HardwareSerial& port, unsigned long baud, TelemetryMode mode);
+    
+    /**
+     * @brief Mở cổng Serial
+     */
+    void begin();
+    
+    /**
+     * @brief Chế độ xuất hiện tại
+     */
+    TelemetryMode getMode() const;
+    
+    /**
+     * @brief Đổi chế độ xuất
+     */
+    void setMode(TelemetryMode mode);
+    
+    /**
+     * @brief Thông báo có sản phẩm trên cân (chỉ ở chế độ chữ)
+     * @param lane Làn có sản phẩm
+     */
+    void logArrival(uint8_t lane = 0);
+    
+    /**
+     * @brief Ghi kết quả một sản phẩm
+     * @param record Bản ghi
+     * @param grams Trọng lượng đã đổi sang gram (chỉ dùng ở chế độ chữ)
+     * @param gradeName Tên hạng (chỉ dùng ở chế độ chữ)
+     */
+    void logProduct(const ProductRecord& record, float grams, MessageId gradeName);
+    
+    /**
+     * @brief Ghi sự kiện cảm biến cuối băng chuyền
+     * @param timestamp Thời điểm phát hiện (millis)
+     * @param lane Làn của cảm biến
+     * @param exitMs Thời gian đẩy -> cảm biến cuối đo được (0: không ghép được sản phẩm)
+     * @param transitMs Thời gian tới servo 2 theo tốc độ băng đo được (BeltSpeedEstimator)
+     */
+    void logPassCount(uint32_t timestamp, uint8_t lane = 0, uint16_t exitMs = 0, uint16_t transitMs = 0);
+    
+    /**
+     * @brief Ghi một sự kiện điểm 0
+     * @param timestamp Thời điểm (millis)
+     * @param lane Làn
+     * @param event ZeroEvent
+     * @param counts Giá trị kèm sự kiện (count): độ chỉnh của tare nền, độ trôi đã bám,
+     *               hoặc 0 khi tare không có dữ liệu
+     * @param grams counts đã đổi sang gram (chỉ dùng ở chế độ chữ)
+     * @return false nếu bộ đệm TX chưa đủ chỗ (gọi lại sau), không tính là khung bị bỏ
+     */
+    bool logZero(uint32_t timestamp, uint8_t lane, uint8_t event, int32_t counts, float grams);
+    
+    /**
+     * @brief Ghi một sự kiện của làn
+     * @param timestamp Thời điểm (millis)
+     * @param lane Làn
+     * @param event LaneEvent
+     * @return false nếu bộ đệm TX chưa đủ chỗ (gọi lại sau), không tính là khung bị bỏ
+     */
+    bool logEvent(uint32_t timestamp, uint8_t lane, uint8_t event);
+    
+    /**
+     * @brief Ghi thống kê thời gian của một giai đoạn
+     * @param stage Giai đoạn
+     * @param stats Thống kê
+     * @return false nếu bộ đệm TX chưa đủ chỗ (gọi lại sau), không tính là khung bị bỏ
+     */
+    bool logProfile(ProfileStage stage, const ProfileStats& stats);
+    
+    /**
+     * @brief Ghi ảnh chụp RAM (lệnh "m")
+     * @param stats Kết quả MemoryMonitor::snapshot
+     */
+    void logMemory(const MemoryStats& stats);
+    
+    /**
+     * @brief Ghi bộ đếm từng hạng của một làn (lệnh "g")
+     * @param lane Làn
+     * @param grades Bảng phân hạng của làn
+     * @return false nếu bộ đệm TX chưa đủ chỗ (gọi lại sau), không tính là khung bị bỏ
+     */
+    bool logGrades(uint8_t lane, const GradeEngine& grades);
+    
+    /**
+     * @brief Ghi thống kê quá trình của một làn (lệnh "s", hoặc khi có cảnh báo trôi)
+     * @param lane Làn
+     * @param stats Thống kê của làn
+     * @param gramsPerCount Hệ số đổi count -> gram (chỉ dùng ở chế độ chữ)
+     * @param now millis() hiện tại (nhịp sản phẩm)
+     * @return false nếu bộ đệm TX chưa đủ chỗ (gọi lại sau), không tính là khung bị bỏ
+     */
+    bool logStats(uint8_t lane, const ProcessStats& stats, float gramsPerCount, unsigned long now);
+    
+    /**
+     * @brief Ghi biểu đồ tần suất trọng lượng của một làn (lệnh "s")
+     * @param lane Làn
+     * @param stats Thống kê của làn
+     * @param gramsPerCount Hệ số đổi count -> gram (chỉ dùng ở chế độ chữ)
+     * @return false nếu bộ đệm TX chưa đủ chỗ (gọi lại sau), không tính là khung bị bỏ
+     */
+    bool logHistogram(uint8_t lane, const ProcessStats& stats, float gramsPerCount);
+    
+    /**
+     * @brief Bắt đầu (hoặc bắt đầu lại sau khi tare) một đoạn ghi mẫu thô
+     * @param timestamp Thời điểm (millis)
+     * @param tareOffset Giá trị thô khi cân rỗng
+     * @param countsPerGramQ8 Hệ số hiệu chuẩn Q8 có dấu
+     */
+    void beginCapture(uint32_t timestamp, int32_t tareOffset, int32_t countsPerGramQ8);
+    
+    /**
+     * @brief Ghi điểm 0 mới giữa đoạn ghi mẫu thô (tự bám điểm 0, không xóa bộ lọc)
+     * @details Mẫu trước đó được gửi trước, nên điểm 0 mới áp dụng từ mẫu kế tiếp
+     * @param timestamp Thời điểm (millis)
+     * @param tareOffset Giá trị thô khi cân rỗng
+     */
+    void logCaptureZero(uint32_t timestamp, int32_t tareOffset);
+    
+    /**
+     * @brief Ghi một mẫu thô HX711
+     * @details Chế độ chữ in dòng "t_ms,raw"; chế độ nhị phân gom vào khối và gửi
+     *          FRAME_SAMPLES khi khối đầy
+     * @param timestamp Thời điểm (millis)
+     * @param raw Giá trị thô 24 bit đã mở rộng dấu
+     */
+    void logSample(uint32_t timestamp, int32_t raw);
+    
+    /**
+     * @brief Gửi khối mẫu đang gom (kể cả chưa đầy)
+     */
+    void flushCapture();
+    
+    /**
+     * @brief Đọc một ký tự lệnh từ Serial (không chờ)
+     * @return Ký tự, hoặc -1 nếu chưa có
+     */
+    int readCommand();
+    
+    /**
+     * @brief Số khung bị bỏ do bộ đệm TX đầy
+     */
+    uint16_t getDroppedFrames() const;
+    
+    /**
+     * @brief Bắt đầu dựng một khung mới
+     * @param type Loại khung
+     */
+    void beginFrame(uint8_t type);
+    
+    /**
+     * @brief Ghi 1/2/4 byte vào payload (little-endian)
+     */
+    void put8(uint8_t value);
+    void put16(uint16_t value);
+    void put32(uint32_t value);
+    
+    /**
+     * @brief Tính CRC và gửi khung nếu bộ đệm TX còn đủ chỗ
+     * @return false nếu khung bị bỏ
+     */
+    bool endFrame();
+    
+    /**
+     * @brief CRC-8 (đa thức 0x07)
+     * @param data Dữ liệu
+     * @param length Số byte
+     */
+    static uint8_t crc8(const uint8_t* data, uint8_t length);
+
+private:
+    /**
+     * @brief Ghi số không dấu dạng varint (7 bit mỗi byte, bit cao = còn byte sau)
+     * @return Số byte đã ghi
+     */
+    static uint8_t putVarint(uint8_t* out, uint32_t value);
+    
+    /**
+     * @brief Gửi FRAME_CAPTURE_START nếu bộ đệm TX đủ chỗ
+     * @details Khung này cần cho việc phát lại nên không bỏ như khung thường mà
+     *          thử lại trước mỗi khối mẫu
+     */
+    void sendCaptureStart();
+    
+    /**
+     * @brief Gửi FRAME_CAPTURE_ZERO nếu bộ đệm TX đủ chỗ, như sendCaptureStart()
+     */
+    void sendCaptureZero();
+};
+
+#endif
@@ -0,0 +1,77 @@
+/**
+ * @file WeightFilter.h
+ * @brief Bộ lọc trọng lượng dạng luồng: median trượt -> phát hiện bước nhảy -> EMA
+ * @author FTH Arduino Uno Project
+ * @date 2026
+ * 
+ * Tách khỏi LoadCellManager để dùng chung giữa firmware và bench/ (đo hiệu năng
+ * các biến thể bộ lọc trên máy tính). Chỉ dùng int32, không phụ thuộc phần cứng.
+ */
+
+#ifndef WEIGHT_FILTER_H
+#define WEIGHT_FILTER_H
+
+#include "Hal.h"
+#include "RunningMedian.h"
+
+class WeightFilter {
+private:
+    RunningMedian median;     ///< Median trượt của các mẫu gần nhất
+    int32_t value;            ///< Giá trị sau khi đã lọc (count)
+    bool valid;               ///< Đã có giá trị lọc lần đầu hay chưa
+    int32_t spikeThreshold;   ///< Thay đổi lớn hơn ngưỡng này là bước nhảy thật (count)
+    uint8_t alpha;            ///< Hệ số lọc mũ dạng Q8 (1..256 tương ứng 1/256..1)
+
+public:
+    /**
+     * @brief Constructor
+     * @param window Kích thước cửa sổ median (1..MEDIAN_MAX_WINDOW)
+     * @param alpha Hệ số lọc mũ dạng Q8 (256 = không làm mượt)
+     * @param spikeThreshold Ngưỡng bước nhảy (count)
+     */
+    WeightFilter(uint8_t window, uint16_t alpha, int32_t spikeThreshold);
+    
+    /**
+     * @brief Đưa một mẫu mới vào bộ lọc
+     * @param sample Mẫu đã trừ điểm 0 (count)
+     * @return Median của cửa sổ sau khi thêm (đầu vào của bộ phát hiện ổn định)
+     */
+    int32_t add(int32_t sample);
+    
+    /**
+     * @brief Giá trị đã lọc (0 nếu chưa có mẫu)
+     */
+    int32_t getValue() const;
+    
+    /**
+     * @brief Đã có ít nhất một mẫu hay chưa
+     */
+    bool hasValue() const;
+    
+    /**
+     * @brief Đổi kích thước cửa sổ median, giữ lại các mẫu mới nhất
+     */
+    void setWindow(uint8_t window);
+    
+    /**
+     * @brief Kích thước cửa sổ median hiện tại
+     */
+    uint8_t getWindow() const;
+    
+    /**
+     * @brief Đặt ngưỡng bước nhảy (count)
+     */
+    void setSpikeThreshold(int32_t threshold);
+    
+    /**
+     * @brief Đặt hệ số lọc mũ dạng Q8 (giới hạn trong 1..256)
+     */
+    void setAlpha(uint16_t alpha);
+    
+    /**
+     * @brief Xóa toàn bộ mẫu và giá trị lọc
+     */
+    void reset();
+};
+
+#endif
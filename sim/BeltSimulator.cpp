@@ -0,0 +1,723 @@
+/**
+ * @file BeltSimulator.cpp
+ * @brief Implementation của BeltSimulator
+ */
+
+#include "BeltSimulator.h"
+#include <stdio.h>
+#include <math.h>
+
+// Mức logic (không dùng macro HIGH/LOW của HAL để file này độc lập)
+static const int LOW_LEVEL = 0;
+static const int HIGH_LEVEL = 1;
+
+// Thời gian I/O theo phần cứng thật
+static const double SERIAL_TX_BUFFER = 63.0;        // Bộ đệm TX của HardwareSerial (byte trống tối đa)
+
+// Hình học dây chuyền
+static const double PUSH_OFF_ANGLE = 170.0;         // Servo 1 qua góc này thì sản phẩm rời cân
+static const double PUSHER_HOME_ANGLE = 10.0;       // Servo 1 dưới góc này thì sản phẩm mới lên được cân
+static const double EJECT_CONTACT_ANGLE = 100.0;    // Servo 2 qua góc này thì gạt trúng sản phẩm
+static const uint64_t ARRIVAL_IR_US = 100000;       // Thời gian sản phẩm che cảm biến IR đầu cân
+static const uint64_t END_SENSOR_US = 50000;        // Thời gian sản phẩm che cảm biến cuối băng chuyền
+static const uint64_t SCALE_STEP_US = 500;          // Bước tích phân mô hình cân
+static const double RATE_NOISE_RATIO = 1.8;         // Nhiễu 80 SPS / 10 SPS (datasheet: 90 nV / 50 nV)
+static const double HX711_SKEW_PER_LANE = 0.003;    // Lệch chu kỳ dao động nội giữa các HX711 (0.3%)
+
+BeltSimulator* BeltSimulator::current = nullptr;
+
+SimConfig::SimConfig()
+    : durationS(600),
+      arrivalRate(30),
+      poissonArrivals(true),
+      weightDist(WEIGHT_NORMAL),
+      weightA(125),
+      weightB(50),
+      weightDrift(0),
+      weightMin(50),
+      weightMax(200),
+      sps(10),
+      countsPerGram(340),
+      zeroCounts(84000),
+      zeroDrift(0),
+      zeroOffset(0),
+      noiseCounts(30),
+      naturalHz(4),
+      damping(0.3),
+      servoSpeed(600),
+      transitMs(1500),
+      ejectWindowMs(400),
+      exitMs(500),
+      beltSpeed(1.0),
+      infeedCapacity(2),
+      stallMs(5000),
+      loopUs(200),
+      seed(1),
+      echoSerial(false),
+      lanes(1),
+      sckPin(3),
+      ratePin(6) {
+    for (uint8_t i = 0; i < SIM_MAX_LANES; i++) {
+        doutPin[i] = servo1Pin[i] = servo2Pin[i] = irArrivalPin[i] = irCountPin[i] = SIM_NO_PIN;
+    }
+    doutPin[0] = 2;
+    servo1Pin[0] = 8;
+    servo2Pin[0] = 9;
+    irArrivalPin[0] = 4;
+    irCountPin[0] = 5;
+}
+
+SimStats::SimStats()
+    : arrived(0), weighed(0), passed(0), rejected(0), goodRejected(0), badPassed(0),
+      missedOverflow(0), missedStall(0), emptyPushes(0), resolvedInWindow(0), cycleSumMs(0), cycleMaxMs(0),
+      loops(0), serialBlockedUs(0) {
+}
+
+BeltSimulator::BeltSimulator(const SimConfig& config)
+    : cfg(config), rng(config.seed), now(0), seq(0), inEvent(false), arrivalsOpen(false),
+      hxSck(LOW_LEVEL), hxSps(config.sps),
+      replayNext(0), replayLoaded(false), replayStarted(false), replayZero(0),
+      interruptsEnabled(true),
+      serialBaud(0), serialQueued(0), serialUs(0) {
+    if (cfg.lanes < 1) cfg.lanes = 1;
+    if (cfg.lanes > SIM_MAX_LANES) cfg.lanes = SIM_MAX_LANES;
+    for (uint8_t num = 0; num < SIM_VECTORS; num++) {
+        isr[num] = nullptr;
+        isrPending[num] = false;
+    }
+    for (uint8_t port = 0; port < SIM_VECTORS - SIM_INT_VECTORS; port++) {
+        pinChangeMask[port] = 0;
+    }
+    current = this;
+    for (uint8_t i = 0; i < cfg.lanes; i++) {
+        Lane& lane = lanes[i];
+        lane.onScale = -1;
+        lane.arrivalIrBlocked = 0;
+        lane.endSensorBlocked = 0;
+        lane.pusherOut = false;
+        lane.scaleTarget = lane.scalePos = lane.scaleVel = 0;
+        lane.scaleUs = 0;
+        lane.hxWord = 0;
+        lane.hxReady = false;
+        lane.hxClocked = 0;
+        lane.hxPending = false;
+        lane.hxDout = HIGH_LEVEL;
+        lane.hxNoise = cfg.noiseCounts;
+        lane.hxSkew = 1.0 + HX711_SKEW_PER_LANE * i;
+        for (int k = 0; k < 2; k++) {
+            lane.servos[k].attached = false;
+            lane.servos[k].angle = lane.servos[k].target = 0;
+            lane.servos[k].lastUs = 0;
+        }
+        schedule((uint64_t)(1e6 / hxSps * lane.hxSkew), EVENT_CONVERSION, i);
+    }
+}
+
+BeltSimulator::~BeltSimulator() {
+    if (current == this) {
+        current = nullptr;
+    }
+}
+
+BeltSimulator& BeltSimulator::active() {
+    return *current;
+}
+
+void BeltSimulator::startArrivals() {
+    arrivalsOpen = true;
+    for (uint8_t i = 0; i < cfg.lanes; i++) {
+        schedule(now, EVENT_ARRIVAL, i);
+    }
+}
+
+void BeltSimulator::loadReplay(const std::vector<ReplaySample>& trace, long zero) {
+    replay = trace;
+    replayNext = 0;
+    replayLoaded = true;
+    replayStarted = false;
+    replayZero = zero;
+}
+
+void BeltSimulator::startReplay() {
+    replayStarted = true;
+}
+
+uint64_t BeltSimulator::nowUs() const {
+    return now;
+}
+
+const SimStats& BeltSimulator::stats() const {
+    return st;
+}
+
+const SimConfig& BeltSimulator::config() const {
+    return cfg;
+}
+
+bool BeltSimulator::finished() const {
+    if (arrivalsOpen) {
+        return false;
+    }
+    if (replayLoaded && (!replayStarted || replayNext < replay.size())) {
+        return false;
+    }
+    for (size_t i = 0; i < products.size(); i++) {
+        if (products[i].stage != STAGE_DONE) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void BeltSimulator::schedule(uint64_t time, EventType type, uint8_t lane, int product) {
+    Event event;
+    event.time = time;
+    event.seq = seq++;
+    event.type = type;
+    event.lane = lane;
+    event.product = product;
+    events.push(event);
+}
+
+/**
+ * Tiến đồng hồ: xử lý lần lượt các sự kiện tới hạn, sau đó cập nhật các tương tác
+ * cơ khí (servo gạt sản phẩm) tại thời điểm cuối
+ */
+void BeltSimulator::advance(uint64_t us) {
+    uint64_t target = now + us;
+    inEvent = true;
+    while (!events.empty() && events.top().time <= target) {
+        Event event = events.top();
+        events.pop();
+        if (event.time > now) {
+            now = event.time;
+        }
+        process(event);
+        pollPhysics();
+    }
+    if (target > now) {
+        now = target;
+    }
+    pollPhysics();
+    inEvent = false;
+}
+
+void BeltSimulator::spend(uint64_t us) {
+    if (inEvent) {
+        now += us;  // Trong ISR: chỉ cộng thời gian
+    } else {
+        advance(us);
+    }
+}
+
+void BeltSimulator::process(const Event& event) {
+    Lane& lane = lanes[event.lane];
+    switch (event.type) {
+        case EVENT_ARRIVAL:
+            onArrival(event.lane);
+            break;
+        case EVENT_CONVERSION:
+            onConversion(event.lane);
+            break;
+        case EVENT_ARRIVAL_IR_CLEAR:
+            if (--lane.arrivalIrBlocked == 0) {
+                pinChanged(cfg.irArrivalPin[event.lane]);
+            }
+            break;
+        case EVENT_END_SENSOR_ON:
+            if (lane.endSensorBlocked++ == 0) {
+                pinChanged(cfg.irCountPin[event.lane]);
+            }
+            schedule(now + (uint64_t)(END_SENSOR_US / cfg.beltSpeed), EVENT_END_SENSOR_OFF, event.lane,
+                     event.product);
+            resolve(event.product, false);
+            break;
+        case EVENT_END_SENSOR_OFF:
+            if (--lane.endSensorBlocked == 0) {
+                pinChanged(cfg.irCountPin[event.lane]);
+            }
+            break;
+    }
+}
+
+/**
+ * Sản phẩm mới đến đầu cân của một làn: vào hàng chờ hoặc bị bỏ sót nếu hàng chờ đầy
+ */
+void BeltSimulator::onArrival(uint8_t laneIndex) {
+    if (!arrivalsOpen) {
+        return;
+    }
+    if (now >= (uint64_t)(cfg.durationS * 1e6)) {
+        arrivalsOpen = false;
+        return;
+    }
+    Lane& lane = lanes[laneIndex];
+
+    Product product;
+    double drift = cfg.weightDrift * now / 60e6;
+    if (cfg.weightDist == WEIGHT_NORMAL) {
+        std::normal_distribution<double> dist(cfg.weightA + drift, cfg.weightB);
+        product.weight = dist(rng);
+    } else {
+        std::uniform_real_distribution<double> dist(cfg.weightA + drift, cfg.weightB + drift);
+        product.weight = dist(rng);
+    }
+    if (product.weight < 1.0) {
+        product.weight = 1.0;
+    }
+    product.good = (product.weight >= cfg.weightMin && product.weight < cfg.weightMax);
+    product.stage = STAGE_INFEED;
+    product.loadUs = product.windowStart = product.windowEnd = 0;
+    st.arrived++;
+
+    if (lane.infeed.size() < cfg.infeedCapacity) {
+        products.push_back(product);
+        lane.infeed.push_back((int)products.size() - 1);
+    } else {
+        st.missedOverflow++;
+    }
+
+    double meanUs = 60e6 / cfg.arrivalRate;
+    uint64_t gap = (uint64_t)meanUs;
+    if (cfg.poissonArrivals) {
+        std::exponential_distribution<double> dist(1.0 / meanUs);
+        gap = (uint64_t)dist(rng);
+    }
+    schedule(now + gap, EVENT_ARRIVAL, laneIndex);
+}
+
+/**
+ * HX711 của một làn chuyển đổi xong: chốt giá trị mới (ghi đè giá trị chưa đọc),
+ * kéo DOUT xuống, báo ngắt nếu có
+ * Khi phát lại, giá trị và khoảng cách tới lần chuyển đổi sau lấy từ chuỗi đã ghi
+ */
+void BeltSimulator::onConversion(uint8_t laneIndex) {
+    Lane& lane = lanes[laneIndex];
+    long raw;
+    uint64_t nextUs = (uint64_t)(1e6 / hxSps * lane.hxSkew);
+    if (replayLoaded && laneIndex == 0) {
+        raw = replayZero;
+        if (replayStarted && replayNext < replay.size()) {
+            raw = replay[replayNext].raw;
+            replayNext++;
+            if (replayNext == replay.size()) {
+                nextUs = 0;  // Hết chuỗi: HX711 không chuyển đổi nữa
+            } else {
+                uint32_t dt = replay[replayNext].timeMs - replay[replayNext - 1].timeMs;
+                nextUs = (uint64_t)(dt ? dt : 1) * 1000;
+            }
+        }
+    } else {
+        integrateScale(lane);
+        std::normal_distribution<double> noise(0.0, lane.hxNoise);
+        double zero = cfg.zeroCounts + (cfg.zeroOffset + cfg.zeroDrift * now / 60e6) * cfg.countsPerGram;
+        raw = lround(zero + lane.scalePos * cfg.countsPerGram + noise(rng));
+    }
+    if (raw > 0x7FFFFF) raw = 0x7FFFFF;
+    if (raw < -0x800000) raw = -0x800000;
+    if (nextUs > 0) {
+        schedule(now + nextUs, EVENT_CONVERSION, laneIndex);
+    }
+    lane.hxWord = (uint32_t)raw & 0xFFFFFFUL;
+    if (lane.hxReady && lane.hxClocked > 0) {
+        // Đang bị đọc (SCK chung chờ kênh chậm hơn): các bit còn lại lấy từ giá trị mới,
+        // DOUT thấp ngay sau xung cuối
+        lane.hxPending = true;
+        return;
+    }
+    lane.hxReady = true;
+    lane.hxClocked = 0;
+    bool falling = (lane.hxDout == HIGH_LEVEL);
+    lane.hxDout = LOW_LEVEL;
+
+    if (falling) {
+        uint8_t dout = cfg.doutPin[laneIndex];
+        int num = (dout == 2) ? 0 : (dout == 3 ? 1 : -1);
+        if (num >= 0) {
+            raiseInterrupt((uint8_t)num);
+        }
+    }
+}
+
+/**
+ * Cảm biến đổi mức: gọi ISR PCINT của cổng nếu firmware đã bật ngắt cho chân này
+ * (chân 0..7 = PORTD/PCINT2, 8..13 = PORTB/PCINT0, A0..A5 = PORTC/PCINT1)
+ */
+void BeltSimulator::pinChanged(uint8_t pin) {
+    if (pin == SIM_NO_PIN || pin >= 20) {
+        return;
+    }
+    uint8_t port = pin < 8 ? 2 : (pin < 14 ? 0 : 1);
+    uint8_t bit = pin < 8 ? pin : (pin < 14 ? pin - 8 : pin - 14);
+    if (pinChangeMask[port] & (1 << bit)) {
+        raiseInterrupt(SIM_INT_VECTORS + port);
+    }
+}
+
+void BeltSimulator::raiseInterrupt(uint8_t num) {
+    if (isr[num] == nullptr) {
+        return;
+    }
+    if (!interruptsEnabled) {
+        isrPending[num] = true;
+        return;
+    }
+    bool saved = inEvent;
+    inEvent = true;
+    interruptsEnabled = false;
+    isr[num]();
+    interruptsEnabled = true;
+    inEvent = saved;
+}
+
+/**
+ * Tương tác cơ khí của mọi làn, kiểm tra ở mỗi bước thời gian
+ */
+void BeltSimulator::pollPhysics() {
+    for (uint8_t i = 0; i < cfg.lanes; i++) {
+        pollLane(i);
+    }
+}
+
+/**
+ * Tương tác cơ khí của một làn:
+ * - servo 1 gạt sản phẩm khỏi cân, sản phẩm chờ lên cân khi servo 1 đã về
+ * - servo 2 gạt sản phẩm đang đi qua, sản phẩm qua khỏi servo 2 đi tới cuối băng chuyền
+ */
+void BeltSimulator::pollLane(uint8_t laneIndex) {
+    Lane& lane = lanes[laneIndex];
+    bool pusher = lane.servos[0].attached;
+    bool ejector = lane.servos[1].attached;
+    bool out = pusher && servoAngle(lane, 0) >= PUSH_OFF_ANGLE;
+    if (out && !lane.pusherOut && lane.onScale < 0) {
+        st.emptyPushes++;
+    }
+    lane.pusherOut = out;
+
+    if (lane.onScale >= 0) {
+        Product& product = products[lane.onScale];
+        if (out) {
+            double cycleMs = (now - product.loadUs) / 1000.0;
+            st.weighed++;
+            st.cycleSumMs += cycleMs;
+            if (cycleMs > st.cycleMaxMs) {
+                st.cycleMaxMs = cycleMs;
+            }
+            product.windowStart = now + beltUs(cfg.transitMs);
+            product.windowEnd = product.windowStart + beltUs(cfg.ejectWindowMs);
+            product.stage = STAGE_BELT;
+            lane.belt.push_back(lane.onScale);
+            lane.onScale = -1;
+            setScaleTarget(lane, 0);
+        } else if (now - product.loadUs > cfg.stallMs * 1000ULL) {
+            st.missedStall++;
+            product.stage = STAGE_DONE;
+            lane.onScale = -1;
+            setScaleTarget(lane, 0);
+        }
+    }
+
+    if (lane.onScale < 0 && !lane.infeed.empty() && (!pusher || servoAngle(lane, 0) <= PUSHER_HOME_ANGLE)) {
+        lane.onScale = lane.infeed.front();
+        lane.infeed.pop_front();
+        Product& product = products[lane.onScale];
+        product.stage = STAGE_SCALE;
+        product.loadUs = now;
+        setScaleTarget(lane, product.weight);
+        if (lane.arrivalIrBlocked++ == 0) {
+            pinChanged(cfg.irArrivalPin[laneIndex]);
+        }
+        schedule(now + ARRIVAL_IR_US, EVENT_ARRIVAL_IR_CLEAR, laneIndex);
+    }
+
+    for (size_t i = 0; i < lane.belt.size();) {
+        Product& product = products[lane.belt[i]];
+        if (now >= product.windowStart && ejector && servoAngle(lane, 1) >= EJECT_CONTACT_ANGLE) {
+            resolve(lane.belt[i], true);
+            lane.belt.erase(lane.belt.begin() + i);
+        } else if (now > product.windowEnd) {
+            product.stage = STAGE_EXIT;
+            schedule(product.windowEnd + beltUs(cfg.exitMs), EVENT_END_SENSOR_ON, laneIndex, lane.belt[i]);
+            lane.belt.erase(lane.belt.begin() + i);
+        } else {
+            i++;
+        }
+    }
+}
+
+/**
+ * Thời gian trên băng chuyền (danh định, ms) ở tốc độ băng hiện tại (µs)
+ */
+uint64_t BeltSimulator::beltUs(unsigned long ms) const {
+    return (uint64_t)(ms * 1000.0 / cfg.beltSpeed);
+}
+
+void BeltSimulator::resolve(int id, bool ejected) {
+    Product& product = products[id];
+    product.stage = STAGE_DONE;
+    if (ejected) {
+        st.rejected++;
+        if (product.good) st.goodRejected++;
+    } else {
+        st.passed++;
+        if (!product.good) st.badPassed++;
+    }
+    if (now <= (uint64_t)(cfg.durationS * 1e6)) {
+        st.resolvedInWindow++;
+    }
+}
+
+/**
+ * Hệ bậc hai x'' = w^2 (target - x) - 2 zeta w x', tích phân bán ẩn với bước 0.5 ms
+ */
+void BeltSimulator::integrateScale(Lane& lane) {
+    double w = 2.0 * M_PI * cfg.naturalHz;
+    while (lane.scaleUs + SCALE_STEP_US <= now) {
+        double dt = SCALE_STEP_US / 1e6;
+        double accel = w * w * (lane.scaleTarget - lane.scalePos) - 2.0 * cfg.damping * w * lane.scaleVel;
+        lane.scaleVel += accel * dt;
+        lane.scalePos += lane.scaleVel * dt;
+        lane.scaleUs += SCALE_STEP_US;
+    }
+}
+
+void BeltSimulator::setScaleTarget(Lane& lane, double grams) {
+    integrateScale(lane);
+    lane.scaleTarget = grams;
+}
+
+/**
+ * Góc hiện tại của servo: chạy thẳng về góc đích với tốc độ tối đa
+ */
+double BeltSimulator::servoAngle(Lane& lane, int index) {
+    ServoModel& servo = lane.servos[index];
+    double step = cfg.servoSpeed * (now - servo.lastUs) / 1e6;
+    double diff = servo.target - servo.angle;
+    if (fabs(diff) <= step) {
+        servo.angle = servo.target;
+    } else {
+        servo.angle += (diff > 0) ? step : -step;
+    }
+    servo.lastUs = now;
+    return servo.angle;
+}
+
+// ==================== Giao diện cho HAL native ====================
+
+void BeltSimulator::pinMode(uint8_t, uint8_t) {
+}
+
+/**
+ * Làn có chân DOUT này, -1 nếu không có
+ */
+int BeltSimulator::laneOfDout(uint8_t pin) const {
+    for (uint8_t i = 0; i < cfg.lanes; i++) {
+        if (cfg.doutPin[i] == pin) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+int BeltSimulator::digitalRead(uint8_t pin) {
+    for (uint8_t i = 0; i < cfg.lanes; i++) {
+        const Lane& lane = lanes[i];
+        if (pin == cfg.doutPin[i]) {
+            return lane.hxDout;
+        }
+        if (pin == cfg.irArrivalPin[i]) {
+            return lane.arrivalIrBlocked > 0 ? LOW_LEVEL : HIGH_LEVEL;
+        }
+        if (pin == cfg.irCountPin[i]) {
+            return lane.endSensorBlocked > 0 ? LOW_LEVEL : HIGH_LEVEL;
+        }
+    }
+    return HIGH_LEVEL;
+}
+
+/**
+ * SCK của HX711: mỗi cạnh lên dịch ra một bit (MSB trước), sau 24 bit dữ liệu
+ * xung thứ 25 chọn gain 128 và DOUT trở lại mức cao tới lần chuyển đổi sau
+ * SCK nối chung: mọi HX711 đang có dữ liệu cùng dịch bit; HX711 chưa có dữ liệu
+ * bỏ qua xung (MultiLoadCell chỉ đọc khi mọi DOUT đều thấp)
+ */
+void BeltSimulator::digitalWrite(uint8_t pin, uint8_t value) {
+    if (pin == cfg.ratePin) {
+        // RATE cao = 80 SPS (nối chung mọi HX711); chu kỳ mới áp dụng từ lần chuyển đổi sau
+        unsigned int sps = (value == HIGH_LEVEL) ? 80 : 10;
+        if (sps != hxSps) {
+            for (uint8_t i = 0; i < cfg.lanes; i++) {
+                double& noise = lanes[i].hxNoise;
+                noise = (sps > hxSps) ? noise * RATE_NOISE_RATIO : noise / RATE_NOISE_RATIO;
+            }
+            hxSps = sps;
+        }
+        return;
+    }
+    if (pin != cfg.sckPin) {
+        return;
+    }
+    if (value == HIGH_LEVEL && hxSck == LOW_LEVEL) {
+        for (uint8_t i = 0; i < cfg.lanes; i++) {
+            Lane& lane = lanes[i];
+            if (!lane.hxReady) {
+                continue;
+            }
+            lane.hxClocked++;
+            if (lane.hxClocked <= 24) {
+                lane.hxDout = (lane.hxWord >> (24 - lane.hxClocked)) & 1 ? HIGH_LEVEL : LOW_LEVEL;
+            } else if (lane.hxPending) {
+                lane.hxPending = false;
+                lane.hxClocked = 0;
+                lane.hxDout = LOW_LEVEL;
+            } else {
+                lane.hxReady = false;
+                lane.hxDout = HIGH_LEVEL;
+            }
+        }
+    }
+    hxSck = value;
+}
+
+void BeltSimulator::attachInterrupt(uint8_t num, void (*handler)(), int) {
+    if (num < SIM_INT_VECTORS) {
+        isr[num] = handler;
+        isrPending[num] = false;
+    }
+}
+
+void BeltSimulator::detachInterrupt(uint8_t num) {
+    if (num < SIM_INT_VECTORS) {
+        isr[num] = nullptr;
+        isrPending[num] = false;
+    }
+}
+
+/**
+ * Như bật bit PCMSKx và PCICR: mọi chân đã bật của một cổng dùng chung một ISR
+ */
+void BeltSimulator::attachPinChange(uint8_t pin, void (*handler)()) {
+    if (pin >= 20) {
+        return;
+    }
+    uint8_t port = pin < 8 ? 2 : (pin < 14 ? 0 : 1);
+    uint8_t bit = pin < 8 ? pin : (pin < 14 ? pin - 8 : pin - 14);
+    isr[SIM_INT_VECTORS + port] = handler;
+    pinChangeMask[port] |= (uint8_t)(1 << bit);
+}
+
+void BeltSimulator::setInterruptsEnabled(bool enabled) {
+    interruptsEnabled = enabled;
+    if (enabled) {
+        for (uint8_t num = 0; num < SIM_VECTORS; num++) {
+            if (isrPending[num]) {
+                isrPending[num] = false;
+                raiseInterrupt(num);
+            }
+        }
+    }
+}
+
+/**
+ * Servo được nhận theo chân: kênh = làn * 2 + (0: servo đẩy, 1: servo gạt)
+ */
+int BeltSimulator::attachServo(int pin) {
+    for (uint8_t i = 0; i < cfg.lanes; i++) {
+        for (int k = 0; k < 2; k++) {
+            uint8_t servoPin = (k == 0) ? cfg.servo1Pin[i] : cfg.servo2Pin[i];
+            if (servoPin != pin) {
+                continue;
+            }
+            ServoModel& servo = lanes[i].servos[k];
+            servo.attached = true;
+            servo.angle = 90;   // Thư viện Servo phát xung 1500us ngay khi attach
+            servo.target = 90;
+            servo.lastUs = now;
+            return i * 2 + k;
+        }
+    }
+    return -1;
+}
+
+void BeltSimulator::writeServo(int channel, int angle) {
+    if (channel < 0 || channel >= cfg.lanes * 2) {
+        return;
+    }
+    Lane& lane = lanes[channel / 2];
+    servoAngle(lane, channel % 2);
+    lane.servos[channel % 2].target = angle;
+}
+
+int BeltSimulator::readServo(int channel) const {
+    if (channel < 0 || channel >= cfg.lanes * 2) {
+        return 0;
+    }
+    return (int)lanes[channel / 2].servos[channel % 2].target;
+}
+
+void BeltSimulator::serialBegin(unsigned long baud) {
+    serialBaud = baud;
+    serialQueued = 0;
+    serialUs = now;
+}
+
+/**
+ * Bộ đệm TX được truyền đi với tốc độ baud/10 byte/giây
+ */
+void BeltSimulator::drainSerial() {
+    if (serialBaud > 0) {
+        serialQueued -= (now - serialUs) * (serialBaud / 10.0) / 1e6;
+        if (serialQueued < 0) {
+            serialQueued = 0;
+        }
+    }
+    serialUs = now;
+}
+
+int BeltSimulator::serialAvailableForWrite() {
+    drainSerial();
+    return (int)(SERIAL_TX_BUFFER - ceil(serialQueued));
+}
+
+/**
+ * Ghi một byte: nếu bộ đệm TX đầy thì chờ như HardwareSerial::write
+ */
+void BeltSimulator::serialWrite(uint8_t c) {
+    if (cfg.echoSerial) {
+        fputc(c, stdout);
+    }
+    if (serialBaud == 0) {
+        return;
+    }
+    drainSerial();
+    if (serialQueued + 1 > SERIAL_TX_BUFFER) {
+        uint64_t wait = (uint64_t)ceil((serialQueued + 1 - SERIAL_TX_BUFFER) * 10e6 / serialBaud);
+        st.serialBlockedUs += wait;
+        spend(wait);
+        drainSerial();
+    }
+    serialQueued += 1;
+}
+
+int BeltSimulator::serialAvailable() const {
+    return (int)serialRx.size();
+}
+
+int BeltSimulator::serialRead() {
+    if (serialRx.empty()) {
+        return -1;
+    }
+    int c = serialRx.front();
+    serialRx.pop_front();
+    return c;
+}
+
+void BeltSimulator::serialInject(const char* text) {
+    while (*text) {
+        serialRx.push_back((uint8_t)*text++);
+    }
+}
+
+void BeltSimulator::setEchoSerial(bool echo) {
+    cfg.echoSerial = echo;
+}
@@ -0,0 +1,330 @@
+/**
+ * @file BeltSimulator.h
+ * @brief Mô phỏng sự kiện rời rạc của băng chuyền, cân, servo và cảm biến IR
+ * @author FTH Arduino Uno Project
+ * @date 2026
+ *
+ * Firmware thật (SystemController và các module) chạy trên máy tính qua HAL native.
+ * Bộ mô phỏng giữ đồng hồ ảo (µs) và một hàng đợi sự kiện:
+ * - Sản phẩm đến theo phân bố Poisson hoặc đều, trọng lượng theo phân bố chuẩn/đều
+ * - HX711 chuyển đổi theo chu kỳ (10/80 SPS), DOUT/SCK được mô phỏng đúng giao thức
+ *   nên cả chế độ polling lẫn ISR bit-bang đều chạy
+ * - Cân là hệ bậc hai tắt dần (tần số riêng, hệ số cản) cộng nhiễu Gauss
+ * - Servo chạy về góc được ghi với tốc độ giới hạn
+ * - Sản phẩm rời cân khi servo 1 gạt qua PUSH_OFF_ANGLE, đi TRANSIT tới servo 2, bị gạt
+ *   nếu servo 2 ở góc gạt trong cửa sổ đi qua, còn lại đi tới cảm biến cuối băng chuyền;
+ *   mọi thời gian trên băng chuyền chia cho beltSpeed (tốc độ băng so với danh định)
+ * - Cảm biến IR đổi mức gọi ISR đổi mức chân (PCINT) nếu firmware đã bật cho chân đó
+ * Thời gian của LCD (I2C) và Serial (bộ đệm TX 64 byte theo baud) được tính vào đồng hồ.
+ *
+ * Nhiều làn: mỗi làn có hàng chờ, cân, HX711, hai servo và cảm biến IR riêng, sản phẩm
+ * đến mỗi làn độc lập với cùng tốc độ. Các HX711 dùng chung SCK (MultiLoadCell) và
+ * chân RATE; dao động nội của mỗi HX711 lệch nhau một chút như linh kiện thật.
+ *
+ * Chế độ phát lại: HX711 trả về đúng các mẫu thô đã ghi từ dây chuyền thật (lệnh "c")
+ * theo khoảng cách thời gian đã ghi, không có sản phẩm mô phỏng nào được đưa vào.
+ * Chỉ làn đầu được phát lại.
+ */
+
+#ifndef BELT_SIMULATOR_H
+#define BELT_SIMULATOR_H
+
+#include <stdint.h>
+#include <deque>
+#include <queue>
+#include <random>
+#include <vector>
+
+// Số làn mô phỏng tối đa (bằng số kênh của MultiLoadCell)
+static const uint8_t SIM_MAX_LANES = 4;
+
+// Chân không nối
+static const uint8_t SIM_NO_PIN = 0xFF;
+
+// Vector ngắt mô phỏng: INT0, INT1 rồi PCINT0..2 (đổi mức chân của PORTB, PORTC, PORTD)
+static const uint8_t SIM_INT_VECTORS = 2;
+static const uint8_t SIM_VECTORS = SIM_INT_VECTORS + 3;
+
+// Phân bố trọng lượng sản phẩm
+enum WeightDistribution {
+    WEIGHT_NORMAL,   // Chuẩn: tham số a = trung bình, b = độ lệch chuẩn (gram)
+    WEIGHT_UNIFORM   // Đều: tham số a = nhỏ nhất, b = lớn nhất (gram)
+};
+
+/**
+ * @brief Cấu hình một lần mô phỏng
+ */
+struct SimConfig {
+    double durationS;           ///< Thời gian sản phẩm được đưa vào (giây mô phỏng)
+    double arrivalRate;         ///< Tốc độ sản phẩm đến mỗi làn (sản phẩm/phút)
+    bool poissonArrivals;       ///< true: khoảng cách ngẫu nhiên (mũ), false: đều
+    WeightDistribution weightDist;
+    double weightA;             ///< Tham số 1 của phân bố trọng lượng
+    double weightB;             ///< Tham số 2 của phân bố trọng lượng
+    double weightDrift;         ///< Phân bố trượt theo thời gian (gram/phút, máy chiết rót lệch dần)
+    double weightMin;           ///< Ngưỡng đạt chuẩn thật (để tính phân loại sai)
+    double weightMax;
+
+    unsigned int sps;           ///< Tốc độ lấy mẫu HX711 lúc bắt đầu (10 hoặc 80)
+    double countsPerGram;       ///< Hệ số hiệu chuẩn thật của cân
+    long zeroCounts;            ///< Giá trị thô khi cân rỗng
+    double zeroDrift;           ///< Điểm 0 trôi theo thời gian (gram/phút, nhiệt độ, vụn bám)
+    double zeroOffset;          ///< Điểm 0 lệch ngay từ đầu (gram), so với điểm 0 trong EEPROM
+    double noiseCounts;         ///< Độ lệch chuẩn nhiễu ở tốc độ sps (count)
+    double naturalHz;           ///< Tần số riêng của cân khi có sản phẩm
+    double damping;             ///< Hệ số cản (0..1)
+
+    double servoSpeed;          ///< Tốc độ tối đa của servo thật (độ/giây)
+    unsigned long transitMs;    ///< Thời gian thật từ lúc rời cân tới lúc tới trước servo 2
+    unsigned long ejectWindowMs;///< Thời gian sản phẩm nằm trước servo 2 (chiều dài / tốc độ băng)
+    unsigned long exitMs;       ///< Thời gian từ servo 2 tới cảm biến cuối băng chuyền
+    double beltSpeed;           ///< Tốc độ băng chuyền so với danh định (các thời gian trên chia cho hệ số này)
+    unsigned int infeedCapacity;///< Số sản phẩm có thể chờ trước cân
+    unsigned long stallMs;      ///< Sản phẩm nằm trên cân lâu hơn thì coi là bỏ sót
+
+    unsigned int loopUs;        ///< Thời gian một vòng loop() ngoài LCD/Serial (µs)
+    uint32_t seed;              ///< Hạt giống ngẫu nhiên
+    bool echoSerial;            ///< In dữ liệu Serial của firmware ra stdout
+
+    uint8_t lanes;              ///< Số làn (1..SIM_MAX_LANES)
+    uint8_t sckPin;             ///< Chân SCK (dùng chung khi có nhiều làn) - giống main.cpp
+    uint8_t ratePin;            ///< Chân RATE của HX711 (firmware chỉ điều khiển khi được cấu hình)
+    uint8_t doutPin[SIM_MAX_LANES];      ///< Chân của từng làn, SIM_NO_PIN nếu không nối
+    uint8_t servo1Pin[SIM_MAX_LANES];
+    uint8_t servo2Pin[SIM_MAX_LANES];
+    uint8_t irArrivalPin[SIM_MAX_LANES];
+    uint8_t irCountPin[SIM_MAX_LANES];
+
+    SimConfig();
+};
+
+/**
+ * @brief Một mẫu thô đã ghi (xem Telemetry::logSample)
+ */
+struct ReplaySample {
+    uint32_t timeMs;
+    int32_t raw;
+};
+
+/**
+ * @brief Kết quả một lần mô phỏng
+ */
+struct SimStats {
+    unsigned long arrived;         ///< Sản phẩm đã đến (mọi làn)
+    unsigned long weighed;         ///< Sản phẩm đã được đẩy khỏi cân
+    unsigned long passed;          ///< Sản phẩm tới cảm biến cuối băng chuyền
+    unsigned long rejected;        ///< Sản phẩm bị servo 2 gạt ra
+    unsigned long goodRejected;    ///< Đạt chuẩn nhưng bị gạt
+    unsigned long badPassed;       ///< Lỗi nhưng lọt qua
+    unsigned long missedOverflow;  ///< Bỏ sót: hàng chờ trước cân đầy
+    unsigned long missedStall;     ///< Bỏ sót: nằm trên cân quá lâu không được xử lý
+    unsigned long emptyPushes;     ///< Servo 1 đẩy khi trên cân không có sản phẩm (firmware phát hiện nhầm)
+    unsigned long resolvedInWindow;///< Sản phẩm ra khỏi dây chuyền trong thời gian mô phỏng
+    double cycleSumMs;             ///< Tổng thời gian từ lúc lên cân tới lúc rời cân
+    double cycleMaxMs;
+    unsigned long loops;           ///< Số vòng loop() đã chạy
+    unsigned long serialBlockedUs; ///< Thời gian Serial chặn vòng lặp (bộ đệm TX đầy)
+
+    SimStats();
+};
+
+class BeltSimulator {
+public:
+    explicit BeltSimulator(const SimConfig& config);
+    ~BeltSimulator();
+
+    /**
+     * @brief Bộ mô phỏng đang nhận các lời gọi HAL
+     */
+    static BeltSimulator& active();
+
+    /**
+     * @brief Bắt đầu đưa sản phẩm vào (gọi sau khi firmware đã init)
+     */
+    void startArrivals();
+
+    /**
+     * @brief Chuyển HX711 sang phát lại chuỗi mẫu đã ghi (gọi trước khi firmware init)
+     * @param trace Các mẫu thô theo thời gian tăng dần
+     * @param zero Giá trị trả về trước khi phát lại (để tare của firmware ra đúng điểm 0)
+     */
+    void loadReplay(const std::vector<ReplaySample>& trace, long zero);
+    
+    /**
+     * @brief Bắt đầu phát lại (gọi sau khi firmware đã init)
+     */
+    void startReplay();
+    
+    /**
+     * @brief Tiến đồng hồ và xử lý các sự kiện tới hạn
+     * @param us Thời gian cần tiến (µs)
+     */
+    void advance(uint64_t us);
+
+    /**
+     * @brief Tiêu tốn thời gian trong một lời gọi HAL (LCD, Serial, delay)
+     * @details Trong ISR chỉ cộng đồng hồ, sự kiện được xử lý sau khi ISR kết thúc
+     */
+    void spend(uint64_t us);
+
+    /**
+     * @brief Đã hết thời gian đưa sản phẩm vào và mọi sản phẩm đã ra khỏi dây chuyền
+     */
+    bool finished() const;
+
+    uint64_t nowUs() const;
+    const SimStats& stats() const;
+    const SimConfig& config() const;
+
+    // ----- Giao diện cho HAL native -----
+    void pinMode(uint8_t pin, uint8_t mode);
+    int digitalRead(uint8_t pin);
+    void digitalWrite(uint8_t pin, uint8_t value);
+    void attachInterrupt(uint8_t num, void (*handler)(), int mode);
+    void detachInterrupt(uint8_t num);
+    void attachPinChange(uint8_t pin, void (*handler)());
+    void setInterruptsEnabled(bool enabled);
+
+    int attachServo(int pin);
+    void writeServo(int channel, int angle);
+    int readServo(int channel) const;
+
+    void serialBegin(unsigned long baud);
+    int serialAvailableForWrite();
+    void serialWrite(uint8_t c);
+    int serialAvailable() const;
+    int serialRead();
+
+    /**
+     * @brief Đưa dữ liệu vào đầu nhận Serial của firmware (lệnh từ máy tính)
+     */
+    void serialInject(const char* text);
+
+    /**
+     * @brief Bật/tắt in dữ liệu Serial của firmware ra stdout
+     */
+    void setEchoSerial(bool echo);
+
+private:
+    enum EventType {
+        EVENT_ARRIVAL,
+        EVENT_CONVERSION,
+        EVENT_ARRIVAL_IR_CLEAR,
+        EVENT_END_SENSOR_ON,
+        EVENT_END_SENSOR_OFF
+    };
+
+    struct Event {
+        uint64_t time;
+        uint64_t seq;
+        EventType type;
+        uint8_t lane;
+        int product;
+        bool operator>(const Event& other) const {
+            return time != other.time ? time > other.time : seq > other.seq;
+        }
+    };
+
+    enum ProductStage {
+        STAGE_INFEED,
+        STAGE_SCALE,
+        STAGE_BELT,
+        STAGE_EXIT,
+        STAGE_DONE
+    };
+
+    struct Product {
+        double weight;
+        bool good;
+        ProductStage stage;
+        uint64_t loadUs;
+        uint64_t windowStart;
+        uint64_t windowEnd;
+    };
+
+    struct ServoModel {
+        bool attached;
+        double angle;
+        double target;
+        uint64_t lastUs;
+    };
+
+    /**
+     * @brief Trạng thái một làn: dây chuyền, cân và HX711 của làn
+     */
+    struct Lane {
+        std::deque<int> infeed;
+        std::vector<int> belt;
+        int onScale;
+        int arrivalIrBlocked;
+        int endSensorBlocked;
+        bool pusherOut;
+
+        // Mô hình cân và HX711
+        double scaleTarget;
+        double scalePos;
+        double scaleVel;
+        uint64_t scaleUs;
+        uint32_t hxWord;
+        bool hxReady;
+        uint8_t hxClocked;
+        bool hxPending;         // Chuyển đổi xong trong lúc đang bị đọc
+        int hxDout;
+        double hxNoise;         // Độ lệch chuẩn nhiễu ở tốc độ hiện tại
+        double hxSkew;          // Hệ số chu kỳ của dao động nội (1 = đúng danh định)
+
+        ServoModel servos[2];   // Servo đẩy và servo gạt
+    };
+
+    SimConfig cfg;
+    SimStats st;
+    std::mt19937 rng;
+    uint64_t now;
+    uint64_t seq;
+    bool inEvent;
+    bool arrivalsOpen;
+    std::priority_queue<Event, std::vector<Event>, std::greater<Event> > events;
+
+    std::vector<Product> products;
+    Lane lanes[SIM_MAX_LANES];
+    uint8_t hxSck;              // Mức SCK (chung cho mọi HX711)
+    unsigned int hxSps;         // Tốc độ hiện tại theo chân RATE (chung)
+
+    // Phát lại mẫu đã ghi
+    std::vector<ReplaySample> replay;
+    size_t replayNext;
+    bool replayLoaded;
+    bool replayStarted;
+    long replayZero;
+
+    // Ngắt ngoài INT0/INT1 và ngắt đổi mức chân PCINT0..2 (xem SIM_VECTORS)
+    void (*isr[SIM_VECTORS])();
+    bool interruptsEnabled;
+    bool isrPending[SIM_VECTORS];
+    uint8_t pinChangeMask[SIM_VECTORS - SIM_INT_VECTORS];  // PCMSKx: chân được bật ngắt đổi mức
+
+    std::deque<uint8_t> serialRx;
+    unsigned long serialBaud;
+    double serialQueued;
+    uint64_t serialUs;
+
+    static BeltSimulator* current;
+
+    void schedule(uint64_t time, EventType type, uint8_t lane, int product = -1);
+    void process(const Event& event);
+    void onArrival(uint8_t lane);
+    void onConversion(uint8_t lane);
+    void raiseInterrupt(uint8_t num);
+    void pinChanged(uint8_t pin);
+    uint64_t beltUs(unsigned long ms) const;
+    void pollPhysics();
+    void pollLane(uint8_t lane);
+    void integrateScale(Lane& lane);
+    void setScaleTarget(Lane& lane, double grams);
+    double servoAngle(Lane& lane, int index);
+    int laneOfDout(uint8_t pin) const;
+    void drainSerial();
+    void resolve(int id, bool ejected);
+};
+
+#endif
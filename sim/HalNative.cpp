@@ -0,0 +1,408 @@
+/**
+ * @file HalNative.cpp
+ * @brief HAL native: chuyển mọi lời gọi phần cứng của firmware tới BeltSimulator
+ */
+
+#include "Hal.h"
+#include "BeltSimulator.h"
+#include <stdio.h>
+#include <string.h>
+#include <string>
+
+// Thời gian mỗi giao dịch I2C với LCD (PCF8574, 100 kHz, chế độ 4 bit)
+static const uint64_t LCD_COMMAND_US = 500;
+static const uint64_t LCD_CLEAR_US = 2000;
+static const uint64_t LCD_INIT_US = 50000;
+
+// Thời gian ghi một byte EEPROM (datasheet ATmega328P: 3.3 ms)
+static const uint64_t EEPROM_WRITE_US = 3400;
+
+HardwareSerial Serial;
+
+// Giá trị đã ghi của PORTB/PORTC/PORTD (chỉ số theo PB/PC/PD)
+static uint8_t outputLatch[PD + 1];
+
+// ==================== Đồng hồ và GPIO ====================
+
+unsigned long millis() {
+    return (unsigned long)(BeltSimulator::active().nowUs() / 1000);
+}
+
+unsigned long micros() {
+    return (unsigned long)BeltSimulator::active().nowUs();
+}
+
+void delay(unsigned long ms) {
+    BeltSimulator::active().spend((uint64_t)ms * 1000);
+}
+
+void delayMicroseconds(unsigned int us) {
+    BeltSimulator::active().spend(us);
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {
+    BeltSimulator::active().pinMode(pin, mode);
+}
+
+int digitalRead(uint8_t pin) {
+    return BeltSimulator::active().digitalRead(pin);
+}
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+    uint8_t port = digitalPinToPort(pin);
+    if (port != NOT_A_PORT) {
+        if (value == LOW) {
+            outputLatch[port] &= ~digitalPinToBitMask(pin);
+        } else {
+            outputLatch[port] |= digitalPinToBitMask(pin);
+        }
+    }
+    BeltSimulator::active().digitalWrite(pin, value);
+}
+
+void attachInterrupt(uint8_t interruptNum, void (*handler)(), int mode) {
+    BeltSimulator::active().attachInterrupt(interruptNum, handler, mode);
+}
+
+void detachInterrupt(uint8_t interruptNum) {
+    BeltSimulator::active().detachInterrupt(interruptNum);
+}
+
+void halAttachPinChange(uint8_t pin, void (*handler)()) {
+    BeltSimulator::active().attachPinChange(pin, handler);
+}
+
+void noInterrupts() {
+    BeltSimulator::active().setInterruptsEnabled(false);
+}
+
+void interrupts() {
+    BeltSimulator::active().setInterruptsEnabled(true);
+}
+
+char* ltoa(long value, char* buffer, int base) {
+    if (base == 10) {
+        sprintf(buffer, "%ld", value);
+    } else {
+        sprintf(buffer, "%lx", (unsigned long)value);
+    }
+    return buffer;
+}
+
+char* ultoa(unsigned long value, char* buffer, int base) {
+    sprintf(buffer, base == 10 ? "%lu" : "%lx", value);
+    return buffer;
+}
+
+// ==================== EEPROM ====================
+
+static uint8_t eepromData[E2END + 1];
+static uint64_t eepromBusyUntil = 0;
+
+/**
+ * Chờ lần ghi trước xong, như avr-libc (chờ bận EEPE)
+ */
+static void eepromWait() {
+    uint64_t now = BeltSimulator::active().nowUs();
+    if (now < eepromBusyUntil) {
+        BeltSimulator::active().spend(eepromBusyUntil - now);
+    }
+}
+
+uint8_t eeprom_read_byte(const uint8_t* address) {
+    eepromWait();
+    return eepromData[(uintptr_t)address & E2END];
+}
+
+void eeprom_write_byte(uint8_t* address, uint8_t value) {
+    eepromWait();
+    eepromData[(uintptr_t)address & E2END] = value;
+    eepromBusyUntil = BeltSimulator::active().nowUs() + EEPROM_WRITE_US;
+}
+
+void eeprom_update_byte(uint8_t* address, uint8_t value) {
+    if (eeprom_read_byte(address) != value) {
+        eeprom_write_byte(address, value);
+    }
+}
+
+bool eeprom_is_ready() {
+    return BeltSimulator::active().nowUs() >= eepromBusyUntil;
+}
+
+void halEepromErase() {
+    memset(eepromData, 0xFF, sizeof(eepromData));
+    eepromBusyUntil = 0;
+}
+
+bool halEepromLoad(const char* path) {
+    FILE* file = fopen(path, "rb");
+    if (file == nullptr) {
+        return false;
+    }
+    size_t n = fread(eepromData, 1, sizeof(eepromData), file);
+    fclose(file);
+    return n == sizeof(eepromData);
+}
+
+bool halEepromSave(const char* path) {
+    FILE* file = fopen(path, "wb");
+    if (file == nullptr) {
+        return false;
+    }
+    size_t n = fwrite(eepromData, 1, sizeof(eepromData), file);
+    fclose(file);
+    return n == sizeof(eepromData);
+}
+
+// ==================== Thanh ghi cổng ====================
+
+static HalPortRegister inputRegisters[PD + 1] = {
+    HalPortRegister(0, false), HalPortRegister(1, false), HalPortRegister(PB, false),
+    HalPortRegister(PC, false), HalPortRegister(PD, false)
+};
+static HalPortRegister outputRegisters[PD + 1] = {
+    HalPortRegister(0, true), HalPortRegister(1, true), HalPortRegister(PB, true),
+    HalPortRegister(PC, true), HalPortRegister(PD, true)
+};
+
+/**
+ * Chân Arduino của bit thứ n trong cổng, -1 nếu bit đó không ra chân
+ */
+static int portBitPin(uint8_t port, uint8_t n) {
+    switch (port) {
+        case PD: return n;
+        case PB: return n < 6 ? 8 + n : -1;
+        case PC: return n < 6 ? 14 + n : -1;
+        default: return -1;
+    }
+}
+
+uint8_t digitalPinToPort(uint8_t pin) {
+    if (pin < 8) return PD;
+    if (pin < 14) return PB;
+    if (pin < 20) return PC;
+    return NOT_A_PORT;
+}
+
+uint8_t digitalPinToBitMask(uint8_t pin) {
+    if (pin < 8) return (uint8_t)(1 << pin);
+    if (pin < 14) return (uint8_t)(1 << (pin - 8));
+    if (pin < 20) return (uint8_t)(1 << (pin - 14));
+    return 0;
+}
+
+HalPortRegister* portInputRegister(uint8_t port) {
+    return port <= PD ? &inputRegisters[port] : nullptr;
+}
+
+HalPortRegister* portOutputRegister(uint8_t port) {
+    return port <= PD ? &outputRegisters[port] : nullptr;
+}
+
+HalPortRegister::HalPortRegister(uint8_t port, bool output) : port(port), output(output) {
+}
+
+HalPortRegister::operator uint8_t() const {
+    if (output) {
+        return outputLatch[port];
+    }
+    uint8_t value = 0;
+    for (uint8_t n = 0; n < 8; n++) {
+        int pin = portBitPin(port, n);
+        if (pin >= 0 && digitalRead((uint8_t)pin) != LOW) {
+            value |= (uint8_t)(1 << n);
+        }
+    }
+    return value;
+}
+
+/**
+ * Ghi PORTx: chỉ các chân đổi mức mới đi tới bộ mô phỏng (ghi PINx bị bỏ qua)
+ */
+HalPortRegister& HalPortRegister::operator=(uint8_t value) {
+    if (!output) {
+        return *this;
+    }
+    uint8_t changed = value ^ outputLatch[port];
+    for (uint8_t n = 0; n < 8; n++) {
+        int pin = portBitPin(port, n);
+        if (pin >= 0 && (changed & (1 << n))) {
+            digitalWrite((uint8_t)pin, (value & (1 << n)) ? HIGH : LOW);
+        }
+    }
+    return *this;
+}
+
+HalPortRegister& HalPortRegister::operator|=(uint8_t mask) {
+    return *this = (uint8_t)(outputLatch[port] | mask);
+}
+
+HalPortRegister& HalPortRegister::operator&=(uint8_t mask) {
+    return *this = (uint8_t)(outputLatch[port] & mask);
+}
+
+// ==================== String ====================
+
+String::String(const char* value) : text(value ? value : "") {
+}
+
+String::String(int value) : text(std::to_string(value)) {
+}
+
+String::String(long value) : text(std::to_string(value)) {
+}
+
+String::String(double value, unsigned char decimals) {
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "%.*f", decimals, value);
+    text = buffer;
+}
+
+const char* String::c_str() const {
+    return text.c_str();
+}
+
+unsigned int String::length() const {
+    return (unsigned int)text.size();
+}
+
+char String::charAt(unsigned int index) const {
+    return index < text.size() ? text[index] : 0;
+}
+
+char String::operator[](unsigned int index) const {
+    return charAt(index);
+}
+
+// ==================== Print ====================
+
+size_t Print::write(const uint8_t* buffer, size_t size) {
+    size_t n = 0;
+    while (size--) {
+        n += write(*buffer++);
+    }
+    return n;
+}
+
+size_t Print::write(const char* text) {
+    return write((const uint8_t*)text, strlen(text));
+}
+
+size_t Print::print(const __FlashStringHelper* text) {
+    return write(reinterpret_cast<const char*>(text));
+}
+
+size_t Print::print(const char* text) {
+    return write(text);
+}
+
+size_t Print::print(const String& text) {
+    return write(text.c_str());
+}
+
+size_t Print::print(char c) {
+    return write((uint8_t)c);
+}
+
+size_t Print::print(unsigned char value, int base) {
+    return print((unsigned long)value, base);
+}
+
+size_t Print::print(int value, int base) {
+    return print((long)value, base);
+}
+
+size_t Print::print(unsigned int value, int base) {
+    return print((unsigned long)value, base);
+}
+
+size_t Print::print(long value, int base) {
+    char buffer[24];
+    snprintf(buffer, sizeof(buffer), base == HEX ? "%lX" : "%ld", value);
+    return write(buffer);
+}
+
+size_t Print::print(unsigned long value, int base) {
+    char buffer[24];
+    snprintf(buffer, sizeof(buffer), base == HEX ? "%lX" : "%lu", value);
+    return write(buffer);
+}
+
+size_t Print::print(double value, int digits) {
+    char buffer[40];
+    snprintf(buffer, sizeof(buffer), "%.*f", digits, value);
+    return write(buffer);
+}
+
+size_t Print::println() {
+    return write("\r\n");
+}
+
+// ==================== Serial ====================
+
+void HardwareSerial::begin(unsigned long baud) {
+    BeltSimulator::active().serialBegin(baud);
+}
+
+int HardwareSerial::available() {
+    return BeltSimulator::active().serialAvailable();
+}
+
+int HardwareSerial::read() {
+    return BeltSimulator::active().serialRead();
+}
+
+int HardwareSerial::availableForWrite() {
+    return BeltSimulator::active().serialAvailableForWrite();
+}
+
+void HardwareSerial::flush() {
+}
+
+size_t HardwareSerial::write(uint8_t c) {
+    BeltSimulator::active().serialWrite(c);
+    return 1;
+}
+
+// ==================== Thiết bị ====================
+
+HalServo::HalServo() : channel(-1) {
+}
+
+uint8_t HalServo::attach(int pin) {
+    channel = BeltSimulator::active().attachServo(pin);
+    return channel < 0 ? 0 : (uint8_t)channel;
+}
+
+void HalServo::write(int angle) {
+    BeltSimulator::active().writeServo(channel, angle);
+}
+
+int HalServo::read() {
+    return BeltSimulator::active().readServo(channel);
+}
+
+HalDisplay::HalDisplay(uint8_t, uint8_t, uint8_t) {
+}
+
+void HalDisplay::init() {
+    BeltSimulator::active().spend(LCD_INIT_US);
+}
+
+void HalDisplay::backlight() {
+    BeltSimulator::active().spend(LCD_COMMAND_US);
+}
+
+void HalDisplay::clear() {
+    BeltSimulator::active().spend(LCD_CLEAR_US);
+}
+
+void HalDisplay::setCursor(uint8_t, uint8_t) {
+    BeltSimulator::active().spend(LCD_COMMAND_US);
+}
+
+size_t HalDisplay::write(uint8_t) {
+    BeltSimulator::active().spend(LCD_COMMAND_US);
+    return 1;
+}
@@ -0,0 +1,232 @@
+/**
+ * @file HalNative.h
+ * @brief Cài đặt HAL cho môi trường native (máy tính) - dùng bởi bộ mô phỏng
+ * @author FTH Arduino Uno Project
+ * @date 2026
+ *
+ * Cung cấp đúng tập con của Arduino core và các thư viện Servo/LiquidCrystal_I2C
+ * mà firmware dùng (xem include/Hal.h). Mọi thao tác đều đi tới BeltSimulator:
+ * đồng hồ là thời gian mô phỏng, GPIO là cảm biến IR và giao tiếp HX711 mô phỏng,
+ * thiết bị là mô hình cân, servo và LCD.
+ *
+ * Khác biệt cần nhớ so với AVR: int là 32 bit, double là 64 bit, ngắt chạy đồng bộ
+ * ngay khi sự kiện xảy ra (không chen giữa hai lệnh của vòng lặp chính).
+ */
+
+#ifndef HAL_NATIVE_H
+#define HAL_NATIVE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <string>
+
+// ==================== Hằng số Arduino ====================
+
+#define HIGH 0x1
+#define LOW 0x0
+
+#define INPUT 0x0
+#define OUTPUT 0x1
+#define INPUT_PULLUP 0x2
+
+#define CHANGE 1
+#define FALLING 2
+#define RISING 3
+
+#define DEC 10
+#define HEX 16
+
+#define NOT_AN_INTERRUPT -1
+#define digitalPinToInterrupt(p) ((p) == 2 ? 0 : ((p) == 3 ? 1 : NOT_AN_INTERRUPT))
+
+#define bit(b) (1UL << (b))
+
+// Không có Flash riêng: dữ liệu PROGMEM nằm trong RAM như biến thường
+#define PROGMEM
+#define PSTR(s) (s)
+#define pgm_read_byte(addr) (*(const uint8_t*)(addr))
+#define pgm_read_word(addr) (*(const uint16_t*)(addr))
+#define pgm_read_dword(addr) (*(const uint32_t*)(addr))
+#define pgm_read_float(addr) (*(const float*)(addr))
+#define pgm_read_ptr(addr) (*(const void* const*)(addr))
+
+class __FlashStringHelper;
+#define F(s) (reinterpret_cast<const __FlashStringHelper*>(s))
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+// ==================== Đồng hồ và GPIO ====================
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+void pinMode(uint8_t pin, uint8_t mode);
+int digitalRead(uint8_t pin);
+void digitalWrite(uint8_t pin, uint8_t value);
+
+void attachInterrupt(uint8_t interruptNum, void (*handler)(), int mode);
+void detachInterrupt(uint8_t interruptNum);
+/**
+ * @brief Bật ngắt đổi mức (cả hai cạnh) cho một chân, như PCMSKx/PCICR trên AVR
+ * @details Các chân cùng cổng dùng chung một ISR (handler gắn sau cùng của cổng đó)
+ */
+void halAttachPinChange(uint8_t pin, void (*handler)());
+void noInterrupts();
+void interrupts();
+
+char* ltoa(long value, char* buffer, int base);
+char* ultoa(unsigned long value, char* buffer, int base);
+
+// ==================== EEPROM ====================
+
+// 1 KB như ATmega328P; mỗi lần ghi một byte bận EEPROM_WRITE_US thời gian mô phỏng
+#define E2END 0x3FF
+
+uint8_t eeprom_read_byte(const uint8_t* address);
+void eeprom_write_byte(uint8_t* address, uint8_t value);
+void eeprom_update_byte(uint8_t* address, uint8_t value);
+bool eeprom_is_ready();
+
+/**
+ * @brief Xóa EEPROM mô phỏng về 0xFF (như chip mới)
+ */
+void halEepromErase();
+
+/**
+ * @brief Nạp/lưu nội dung EEPROM mô phỏng từ/vào file (giữ trạng thái giữa hai lần chạy)
+ * @return false nếu không đọc/ghi được file
+ */
+bool halEepromLoad(const char* path);
+bool halEepromSave(const char* path);
+
+// ==================== Thanh ghi cổng (sơ đồ chân của Uno) ====================
+
+#define NOT_A_PORT 0
+#define PB 2    // Chân 8..13
+#define PC 3    // Chân A0..A5 (14..19)
+#define PD 4    // Chân 0..7
+
+/**
+ * @brief Thanh ghi PINx (đọc) hoặc PORTx (ghi) mô phỏng
+ * @details Đọc PINx ghép mức của 8 chân qua digitalRead; ghi PORTx gọi digitalWrite cho
+ *          từng chân đổi mức, nên bộ mô phỏng vẫn thấy từng cạnh SCK
+ */
+class HalPortRegister {
+private:
+    uint8_t port;
+    bool output;
+
+public:
+    HalPortRegister(uint8_t port, bool output);
+    operator uint8_t() const;
+    HalPortRegister& operator=(uint8_t value);
+    HalPortRegister& operator|=(uint8_t mask);
+    HalPortRegister& operator&=(uint8_t mask);
+};
+
+uint8_t digitalPinToPort(uint8_t pin);
+uint8_t digitalPinToBitMask(uint8_t pin);
+HalPortRegister* portInputRegister(uint8_t port);
+HalPortRegister* portOutputRegister(uint8_t port);
+
+// ==================== String / Print / Serial ====================
+
+class String {
+private:
+    std::string text;
+
+public:
+    String(const char* text = "");
+    String(int value);
+    String(long value);
+    String(double value, unsigned char decimals = 2);
+
+    const char* c_str() const;
+    unsigned int length() const;
+    char charAt(unsigned int index) const;
+    char operator[](unsigned int index) const;
+};
+
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    size_t write(const uint8_t* buffer, size_t size);
+    size_t write(const char* text);
+
+    size_t print(const __FlashStringHelper* text);
+    size_t print(const char* text);
+    size_t print(const String& text);
+    size_t print(char c);
+    size_t print(unsigned char value, int base = DEC);
+    size_t print(int value, int base = DEC);
+    size_t print(unsigned int value, int base = DEC);
+    size_t print(long value, int base = DEC);
+    size_t print(unsigned long value, int base = DEC);
+    size_t print(double value, int digits = 2);
+
+    size_t println();
+    template <typename T>
+    size_t println(T value) {
+        size_t n = print(value);
+        return n + println();
+    }
+    template <typename T>
+    size_t println(T value, int format) {
+        size_t n = print(value, format);
+        return n + println();
+    }
+};
+
+class HardwareSerial : public Print {
+public:
+    void begin(unsigned long baud);
+    int available();
+    int read();
+    int availableForWrite();
+    void flush();
+    size_t write(uint8_t c) override;
+    using Print::write;
+    operator bool() { return true; }
+};
+
+extern HardwareSerial Serial;
+
+// ==================== Thiết bị ====================
+
+/**
+ * @brief Servo mô phỏng với API của thư viện Servo
+ */
+class HalServo {
+private:
+    int channel;
+
+public:
+    HalServo();
+    uint8_t attach(int pin);
+    void write(int angle);
+    int read();
+};
+
+/**
+ * @brief LCD mô phỏng với API của LiquidCrystal_I2C (chỉ các hàm firmware dùng)
+ * @details Mỗi lệnh tiêu tốn thời gian mô phỏng như một giao dịch I2C thật
+ */
+class HalDisplay : public Print {
+public:
+    HalDisplay(uint8_t address, uint8_t columns, uint8_t rows);
+    void init();
+    void backlight();
+    void clear();
+    void setCursor(uint8_t col, uint8_t row);
+    size_t write(uint8_t c) override;
+    using Print::write;
+};
+
+#endif
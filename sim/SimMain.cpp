@@ -0,0 +1,464 @@
+/**
+ * @file SimMain.cpp
+ * @brief Chạy firmware thật trên bộ mô phỏng băng chuyền và báo cáo năng suất
+ *
+ * Build và chạy:
+ *   pio run -e native && .pio/build/native/program --rate 30 --duration 600
+ *   .pio/build/native/program --sweep 10:60:5        # quét tốc độ đến, in bảng
+ *   .pio/build/native/program --replay samples.csv   # phát lại mẫu ghi từ dây chuyền
+ *
+ * Tham số (mặc định trong ngoặc):
+ *   --rate N            sản phẩm đến mỗi phút, mỗi làn (30)
+ *   --lanes N           số làn 1..4 (1); từ 2 làn các HX711 dùng SCK chung
+ *                       (MultiLoadCell, DOUT A0..A3), không có chân RATE
+ *   --sweep A:B:STEP    chạy lần lượt các tốc độ từ A tới B
+ *   --arrival poisson|fixed   phân bố khoảng cách giữa các sản phẩm (poisson)
+ *   --weight normal:MEAN:SD | uniform:MIN:MAX  phân bố trọng lượng (normal:125:50)
+ *   --duration S        thời gian đưa sản phẩm vào, giây mô phỏng (600)
+ *   --sps 10|80         tốc độ lấy mẫu HX711 (10)
+ *   --rate-pin          nối chân RATE của HX711 để firmware tự chọn 10/80 SPS
+ *   --noise C           độ lệch chuẩn nhiễu cân, count (30)
+ *   --scale-hz F        tần số riêng của cân (4)
+ *   --servo-speed D     tốc độ servo thật, độ/giây (600)
+ *   --transit-ms T      thời gian thật từ cân tới servo 2 ở tốc độ băng danh định (1500)
+ *   --belt-speed F      tốc độ băng thật so với danh định, mọi thời gian trên băng chia
+ *                       cho F (1); firmware tự đo tốc độ bằng cảm biến cuối băng chuyền
+ *   --infeed N          số sản phẩm chờ được trước cân (2)
+ *   --loop-us U         thời gian một vòng loop() ngoài LCD/Serial (200)
+ *   --seed S            hạt giống ngẫu nhiên (1)
+ *   --text              telemetry dạng chữ và in Serial của firmware ra màn hình
+ *   --profile           cuối lần chạy gửi lệnh "p" và in thống kê profiler
+ *                       (cần build với -DPROFILER_ENABLED; chỉ thời gian LCD/Serial
+ *                       và delay là có ý nghĩa, tính toán không tốn thời gian mô phỏng)
+ *   --stats             cuối lần chạy gửi lệnh "s" và in thống kê quá trình (SPC) và
+ *                       biểu đồ tần suất của từng làn
+ *   --drift G           trung bình trọng lượng trôi G gram mỗi phút (0), để thử cảnh
+ *                       báo CUSUM/EWMA
+ *   --zero-drift G      điểm 0 của cân trôi G gram mỗi phút (0), để thử tự bám điểm 0
+ *   --replay FILE       đưa chuỗi mẫu thô đã ghi (lệnh "c", giải mã bằng
+ *                       tools/telemetry_decode.py --samples-csv) qua LoadCellManager và
+ *                       SystemController nhanh hơn thời gian thực; in log chữ của firmware
+ *                       (tất định: so sánh bằng diff giữa hai phiên bản firmware);
+ *                       chỉ chạy một làn
+ *   --eeprom FILE       nạp EEPROM từ FILE trước khi chạy (nếu có) và ghi lại sau khi
+ *                       chạy: lần chạy sau khởi động ấm từ trạng thái đã lưu; không có
+ *                       tham số này EEPROM trống (khởi động lạnh)
+ *   --zero-offset G     điểm 0 của cân lệch G gram ngay từ đầu (0). Cùng --eeprom của một
+ *                       lần chạy trước: điểm 0 đã lưu sai G gram (mất điện khi còn vụn
+ *                       trên cân, trôi nhiệt lúc tắt máy)
+ */
+
+#include "Hal.h"
+#include "BeltSimulator.h"
+#include "LoadCellManager.h"
+#include "ServoController.h"
+#include "DisplayManager.h"
+#include "Telemetry.h"
+#include "MultiLoadCell.h"
+#include "LaneController.h"
+#include "SystemController.h"
+#include "PersistentStore.h"
+#include "GradeEngine.h"
+#include <stdio.h>
+#include <algorithm>
+#include <chrono>
+#include <memory>
+
+// Cấu hình firmware - giống src/main.cpp
+static const float CALIBRATION_FACTOR = 340.0;
+// Bảng phân hạng như src/main.cpp: các hạng đạt là [50, 200) g, khớp weightMin/weightMax
+// mà bộ mô phỏng dùng để tính phân loại sai
+static const GradeBand GRADES[] = {
+    {0.0f, EJECT_SERVO_2, MSG_VERDICT_LIGHT},
+    {50.0f, EJECT_NONE, MSG_GRADE_3},
+    {100.0f, EJECT_NONE, MSG_GRADE_2},
+    {150.0f, EJECT_NONE, MSG_GRADE_1},
+    {200.0f, EJECT_SERVO_2, MSG_VERDICT_HEAVY}
+};
+static const uint8_t GRADE_COUNT = sizeof(GRADES) / sizeof(GRADES[0]);
+static const unsigned long SERIAL_BAUD = 115200;
+
+// Chân của từng làn khi có nhiều làn - giống sơ đồ nối dây trong src/main.cpp
+// DOUT cùng cổng PORTC (A0..A3), SCK chung ở chân 3; chỉ làn 1 có cảm biến IR
+static const uint8_t MULTI_DOUT_PINS[SIM_MAX_LANES] = {14, 15, 16, 17};
+static const uint8_t MULTI_SERVO1_PINS[SIM_MAX_LANES] = {8, 10, 12, 6};
+static const uint8_t MULTI_SERVO2_PINS[SIM_MAX_LANES] = {9, 11, 13, 7};
+static const uint8_t MULTI_IR_ARRIVAL_PINS[SIM_MAX_LANES] = {4, SIM_NO_PIN, SIM_NO_PIN, SIM_NO_PIN};
+static const uint8_t MULTI_IR_COUNT_PINS[SIM_MAX_LANES] = {5, SIM_NO_PIN, SIM_NO_PIN, SIM_NO_PIN};
+
+// Thời gian chờ tối đa sau khi ngừng đưa sản phẩm vào (giây mô phỏng)
+static const double DRAIN_LIMIT_S = 30.0;
+
+// Thời gian chạy thêm sau mẫu cuối cùng khi phát lại (giây mô phỏng)
+static const double REPLAY_TAIL_S = 5.0;
+
+/**
+ * Chuỗi mẫu thô đã ghi cùng điểm 0 và hệ số hiệu chuẩn lúc ghi
+ */
+struct Replay {
+    std::vector<ReplaySample> samples;
+    long zero;
+    float calibration;
+};
+
+struct SimResult {
+    SimStats stats;
+    int firmwarePass;
+    int firmwareReject;
+    double simulatedS;
+    double setupMs;
+};
+
+/**
+ * Chân cảm biến IR cho firmware: -1 nếu bộ mô phỏng không nối
+ */
+static int firmwarePin(uint8_t pin) {
+    return pin == SIM_NO_PIN ? -1 : pin;
+}
+
+/**
+ * Đổi cấu hình sang sơ đồ chân nhiều làn (SCK chung, mỗi làn hai servo)
+ */
+static void applyLanePins(SimConfig& cfg) {
+    if (cfg.lanes < 2) {
+        return;
+    }
+    for (uint8_t i = 0; i < SIM_MAX_LANES; i++) {
+        cfg.doutPin[i] = MULTI_DOUT_PINS[i];
+        cfg.servo1Pin[i] = MULTI_SERVO1_PINS[i];
+        cfg.servo2Pin[i] = MULTI_SERVO2_PINS[i];
+        cfg.irArrivalPin[i] = MULTI_IR_ARRIVAL_PINS[i];
+        cfg.irCountPin[i] = MULTI_IR_COUNT_PINS[i];
+    }
+}
+
+/**
+ * Một lần mô phỏng: dựng các đối tượng giống main.cpp, chạy setup() rồi loop()
+ * Một làn: HX711 dùng chế độ ngắt như main.cpp; nhiều làn: MultiLoadCell trên SCK chung
+ */
+static SimResult runOnce(const SimConfig& cfg, bool text, bool profile, bool stats, bool ratePin,
+                         const Replay* replay = nullptr, const char* eepromPath = nullptr) {
+    BeltSimulator sim(cfg);
+    if (replay != nullptr) {
+        sim.loadReplay(replay->samples, replay->zero);
+    }
+    halEepromErase();
+    if (eepromPath != nullptr) {
+        halEepromLoad(eepromPath);
+    }
+
+    float calibration = replay != nullptr ? replay->calibration : CALIBRATION_FACTOR;
+    uint8_t laneCount = sim.config().lanes;
+    MultiLoadCell sharedClock(cfg.sckPin);
+    std::unique_ptr<LoadCellManager> loadCells[SIM_MAX_LANES];
+    std::unique_ptr<ServoController> servoControllers[SIM_MAX_LANES];
+    std::unique_ptr<LaneController> laneControllers[SIM_MAX_LANES];
+    LaneController* lanes[SIM_MAX_LANES];
+    DisplayManager display(0x27, 16, 2);
+    PersistentStore store;
+    Telemetry telemetry(Serial, SERIAL_BAUD, text ? TELEMETRY_TEXT : TELEMETRY_BINARY);
+    for (uint8_t i = 0; i < laneCount; i++) {
+        if (laneCount == 1) {
+            loadCells[i].reset(new LoadCellManager(cfg.doutPin[i], cfg.sckPin, calibration, ACQ_INTERRUPT,
+                                                   ratePin ? cfg.ratePin : -1));
+        } else {
+            loadCells[i].reset(new LoadCellManager(cfg.doutPin[i], &sharedClock, calibration));
+        }
+        servoControllers[i].reset(new ServoController(cfg.servo1Pin[i], cfg.servo2Pin[i]));
+        laneControllers[i].reset(new LaneController(loadCells[i].get(), servoControllers[i].get(), &display,
+                                                    &telemetry, firmwarePin(cfg.irArrivalPin[i]),
+                                                    firmwarePin(cfg.irCountPin[i]), GRADES, GRADE_COUNT));
+        lanes[i] = laneControllers[i].get();
+    }
+    SystemController systemController(lanes, laneCount, &display, &telemetry,
+                                      laneCount > 1 ? &sharedClock : nullptr, &store);
+
+    uint64_t setupStart = sim.nowUs();
+    systemController.init();
+    double setupMs = (sim.nowUs() - setupStart) / 1000.0;
+    if (replay != nullptr) {
+        sim.startReplay();
+    } else {
+        sim.startArrivals();
+    }
+
+    uint64_t start = sim.nowUs();
+    // Phát lại chạy thêm một đoạn cố định sau mẫu cuối để firmware xử lý xong sản phẩm
+    double tailS = replay != nullptr ? REPLAY_TAIL_S : DRAIN_LIMIT_S;
+    uint64_t limit = start + (uint64_t)((cfg.durationS + tailS) * 1e6);
+    unsigned long loops = 0;
+    while (sim.nowUs() < limit && (replay != nullptr || !sim.finished())) {
+        systemController.run();
+        sim.advance(cfg.loopUs);
+        loops++;
+    }
+
+    if (profile) {
+        telemetry.setMode(TELEMETRY_TEXT);
+        sim.setEchoSerial(true);
+        sim.serialInject("p");
+        for (int i = 0; i < PROF_STAGE_COUNT + 2; i++) {
+            systemController.run();
+            sim.advance(cfg.loopUs);
+        }
+        sim.setEchoSerial(cfg.echoSerial);
+    }
+    if (stats) {
+        telemetry.setMode(TELEMETRY_TEXT);
+        sim.setEchoSerial(true);
+        sim.serialInject("s");
+        for (int i = 0; i < 2 * laneCount + 2; i++) {
+            systemController.run();
+            sim.advance(cfg.loopUs);
+        }
+        sim.setEchoSerial(cfg.echoSerial);
+    }
+    if (eepromPath != nullptr && !halEepromSave(eepromPath)) {
+        fprintf(stderr, "Khong ghi duoc %s\n", eepromPath);
+    }
+
+    SimResult result;
+    result.stats = sim.stats();
+    result.stats.loops = loops;
+    result.firmwarePass = systemController.getPassCount();
+    result.firmwareReject = systemController.getRejectCount();
+    result.simulatedS = (sim.nowUs() - start) / 1e6;
+    result.setupMs = setupMs;
+    return result;
+}
+
+static unsigned long missed(const SimStats& s) {
+    return s.missedOverflow + s.missedStall;
+}
+
+static double itemsPerMinute(const SimConfig& cfg, const SimStats& s) {
+    return s.resolvedInWindow * 60.0 / cfg.durationS;
+}
+
+static void printReport(const SimConfig& cfg, const SimResult& r) {
+    const SimStats& s = r.stats;
+    printf("=== Mo phong bang chuyen ===\n");
+    printf("Den: %.1f sp/phut moi lan x %u lan (%s), HX711 %u SPS, nhieu %.0f count, %.0f s\n",
+           cfg.arrivalRate, cfg.lanes, cfg.poissonArrivals ? "poisson" : "deu", cfg.sps,
+           cfg.noiseCounts, cfg.durationS);
+    printf("San pham den:          %lu\n", s.arrived);
+    printf("Nang suat:             %.1f sp/phut\n", itemsPerMinute(cfg, s));
+    printf("Ra cuoi bang / bi gat: %lu / %lu\n", s.passed, s.rejected);
+    printf("Phan loai sai:         %lu (dat bi gat %lu, loi lot qua %lu)\n",
+           s.goodRejected + s.badPassed, s.goodRejected, s.badPassed);
+    printf("Bo sot:                %lu (hang cho day %lu, ket tren can %lu)\n",
+           missed(s), s.missedOverflow, s.missedStall);
+    printf("Day khi can rong:      %lu\n", s.emptyPushes);
+    printf("Chu ky tren can:       tb %.0f ms, max %.0f ms\n",
+           s.weighed ? s.cycleSumMs / s.weighed : 0.0, s.cycleMaxMs);
+    printf("Firmware PASS/REJECT:  %d / %d\n", r.firmwarePass, r.firmwareReject);
+    printf("Khoi dong (setup):     %.0f ms\n", r.setupMs);
+    printf("Serial chan vong lap:  %.1f ms\n", s.serialBlockedUs / 1000.0);
+    printf("Vong loop():           %lu trong %.1f s mo phong\n", s.loops, r.simulatedS);
+}
+
+/**
+ * Đọc chuỗi mẫu dạng "t_ms,raw"; dòng "# tare=N,cpg_q8=M" cho điểm 0 và hệ số hiệu chuẩn
+ * Không có dòng đó thì điểm 0 là median của 10 mẫu đầu (cân rỗng lúc bắt đầu ghi)
+ * Dòng "# zero=N" (tự bám điểm 0 lúc ghi) bị bỏ qua: firmware phát lại tự bám trên cùng mẫu
+ */
+static bool loadReplay(const char* path, Replay& replay) {
+    FILE* file = fopen(path, "r");
+    if (file == nullptr) {
+        return false;
+    }
+    bool hasTare = false;
+    replay.calibration = CALIBRATION_FACTOR;
+    char line[128];
+    while (fgets(line, sizeof(line), file)) {
+        long tare, cpgQ8;
+        unsigned long t;
+        long raw;
+        if (sscanf(line, "# tare=%ld,cpg_q8=%ld", &tare, &cpgQ8) == 2) {
+            if (!hasTare) {
+                replay.zero = tare;
+                replay.calibration = cpgQ8 / 256.0f;
+                hasTare = true;
+            }
+        } else if (sscanf(line, "%lu,%ld", &t, &raw) == 2) {
+            ReplaySample sample;
+            sample.timeMs = (uint32_t)t;
+            sample.raw = (int32_t)raw;
+            replay.samples.push_back(sample);
+        }
+    }
+    fclose(file);
+    if (replay.samples.empty()) {
+        return false;
+    }
+    if (!hasTare) {
+        std::vector<long> head;
+        for (size_t i = 0; i < replay.samples.size() && i < 10; i++) {
+            head.push_back(replay.samples[i].raw);
+        }
+        std::nth_element(head.begin(), head.begin() + head.size() / 2, head.end());
+        replay.zero = head[head.size() / 2];
+    }
+    return true;
+}
+
+static bool parseWeight(const char* spec, SimConfig& cfg) {
+    char kind[16];
+    double a, b;
+    if (sscanf(spec, "%15[^:]:%lf:%lf", kind, &a, &b) != 3) {
+        return false;
+    }
+    if (strcmp(kind, "normal") == 0) {
+        cfg.weightDist = WEIGHT_NORMAL;
+    } else if (strcmp(kind, "uniform") == 0) {
+        cfg.weightDist = WEIGHT_UNIFORM;
+    } else {
+        return false;
+    }
+    cfg.weightA = a;
+    cfg.weightB = b;
+    return true;
+}
+
+int main(int argc, char** argv) {
+    SimConfig cfg;
+    bool text = false;
+    bool profile = false;
+    bool stats = false;
+    bool ratePin = false;
+    double sweepFrom = 0, sweepTo = 0, sweepStep = 0;
+    const char* replayPath = nullptr;
+    const char* eepromPath = nullptr;
+
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        const char* value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+        bool used = true;
+        if (strcmp(arg, "--text") == 0) {
+            text = true;
+            cfg.echoSerial = true;
+            used = false;
+        } else if (strcmp(arg, "--profile") == 0) {
+            profile = true;
+            used = false;
+        } else if (strcmp(arg, "--stats") == 0) {
+            stats = true;
+            used = false;
+        } else if (strcmp(arg, "--rate-pin") == 0) {
+            ratePin = true;
+            used = false;
+        } else if (value == nullptr) {
+            fprintf(stderr, "Thieu gia tri cho %s\n", arg);
+            return 2;
+        } else if (strcmp(arg, "--rate") == 0) {
+            cfg.arrivalRate = atof(value);
+        } else if (strcmp(arg, "--lanes") == 0) {
+            int lanes = atoi(value);
+            if (lanes < 1 || lanes > SIM_MAX_LANES) {
+                fprintf(stderr, "--lanes can tu 1 toi %u\n", SIM_MAX_LANES);
+                return 2;
+            }
+            cfg.lanes = (uint8_t)lanes;
+        } else if (strcmp(arg, "--sweep") == 0) {
+            if (sscanf(value, "%lf:%lf:%lf", &sweepFrom, &sweepTo, &sweepStep) != 3 || sweepStep <= 0) {
+                fprintf(stderr, "--sweep can dang A:B:STEP\n");
+                return 2;
+            }
+        } else if (strcmp(arg, "--arrival") == 0) {
+            cfg.poissonArrivals = (strcmp(value, "fixed") != 0);
+        } else if (strcmp(arg, "--weight") == 0) {
+            if (!parseWeight(value, cfg)) {
+                fprintf(stderr, "--weight can dang normal:MEAN:SD hoac uniform:MIN:MAX\n");
+                return 2;
+            }
+        } else if (strcmp(arg, "--zero-offset") == 0) {
+            cfg.zeroOffset = atof(value);
+        } else if (strcmp(arg, "--drift") == 0) {
+            cfg.weightDrift = atof(value);
+        } else if (strcmp(arg, "--zero-drift") == 0) {
+            cfg.zeroDrift = atof(value);
+        } else if (strcmp(arg, "--duration") == 0) {
+            cfg.durationS = atof(value);
+        } else if (strcmp(arg, "--sps") == 0) {
+            cfg.sps = (unsigned int)atoi(value);
+        } else if (strcmp(arg, "--noise") == 0) {
+            cfg.noiseCounts = atof(value);
+        } else if (strcmp(arg, "--scale-hz") == 0) {
+            cfg.naturalHz = atof(value);
+        } else if (strcmp(arg, "--servo-speed") == 0) {
+            cfg.servoSpeed = atof(value);
+        } else if (strcmp(arg, "--belt-speed") == 0) {
+            cfg.beltSpeed = atof(value);
+            if (cfg.beltSpeed <= 0) {
+                fprintf(stderr, "--belt-speed can lon hon 0\n");
+                return 2;
+            }
+        } else if (strcmp(arg, "--transit-ms") == 0) {
+            cfg.transitMs = strtoul(value, nullptr, 10);
+        } else if (strcmp(arg, "--infeed") == 0) {
+            cfg.infeedCapacity = (unsigned int)atoi(value);
+        } else if (strcmp(arg, "--loop-us") == 0) {
+            cfg.loopUs = (unsigned int)atoi(value);
+        } else if (strcmp(arg, "--seed") == 0) {
+            cfg.seed = (uint32_t)strtoul(value, nullptr, 10);
+        } else if (strcmp(arg, "--replay") == 0) {
+            replayPath = value;
+        } else if (strcmp(arg, "--eeprom") == 0) {
+            eepromPath = value;
+        } else {
+            fprintf(stderr, "Tham so khong hop le: %s\n", arg);
+            return 2;
+        }
+        if (used) {
+            i++;
+        }
+    }
+
+    if (replayPath != nullptr && cfg.lanes > 1) {
+        fprintf(stderr, "--replay chi chay mot lan\n");
+        return 2;
+    }
+    if (cfg.lanes > 1 && ratePin) {
+        fprintf(stderr, "Nhieu lan khong dung chan RATE, bo qua --rate-pin\n");
+        ratePin = false;
+    }
+    applyLanePins(cfg);
+
+    if (replayPath != nullptr) {
+        Replay replay;
+        if (!loadReplay(replayPath, replay)) {
+            fprintf(stderr, "Khong doc duoc %s\n", replayPath);
+            return 1;
+        }
+        double traceS = (replay.samples.back().timeMs - replay.samples.front().timeMs) / 1000.0;
+        cfg.durationS = traceS;
+        cfg.echoSerial = true;
+        std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+        SimResult r = runOnce(cfg, true, profile, stats, ratePin, &replay, eepromPath);
+        double wallS = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        printf("=== Phat lai %s ===\n", replayPath);
+        printf("Mau:                   %zu trong %.1f s (diem 0 %ld, he so %.2f)\n",
+               replay.samples.size(), traceS, replay.zero, replay.calibration);
+        printf("Firmware PASS/REJECT:  %d / %d\n", r.firmwarePass, r.firmwareReject);
+        // Ra stderr để stdout giống hệt nhau giữa các lần chạy
+        fprintf(stderr, "Toc do: %.0f lan thoi gian thuc\n",
+               wallS > 0 ? r.simulatedS / wallS : 0.0);
+        return 0;
+    }
+
+    if (sweepStep <= 0) {
+        printReport(cfg, runOnce(cfg, text, profile, stats, ratePin, nullptr, eepromPath));
+        return 0;
+    }
+
+    printf("rate,items_per_min,missorts,missed,empty_pushes,mean_cycle_ms,max_cycle_ms\n");
+    for (double rate = sweepFrom; rate <= sweepTo + 1e-9; rate += sweepStep) {
+        cfg.arrivalRate = rate;
+        SimResult r = runOnce(cfg, false, false, false, ratePin);
+        const SimStats& s = r.stats;
+        printf("%.1f,%.1f,%lu,%lu,%lu,%.0f,%.0f\n", rate, itemsPerMinute(cfg, s),
+               s.goodRejected + s.badPassed, missed(s), s.emptyPushes,
+               s.weighed ? s.cycleSumMs / s.weighed : 0.0, s.cycleMaxMs);
+    }
+    return 0;
+}
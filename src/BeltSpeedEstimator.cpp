@@ -0,0 +1,97 @@
+/**
+ * @file BeltSpeedEstimator.cpp
+ * @brief Implementation của BeltSpeedEstimator class
+ */
+
+#include "BeltSpeedEstimator.h"
+
+// Giới hạn của ước lượng (µs)
+static const int32_t EXIT_NOMINAL_US = (int32_t)EXIT_TIME_MS * 1000;
+static const int32_t EXIT_MIN_US = EXIT_NOMINAL_US / BELT_MATCH_RATIO;
+static const int32_t EXIT_MAX_US = EXIT_NOMINAL_US * BELT_MATCH_RATIO;
+
+/**
+ * Constructor - chưa có sản phẩm nào, ước lượng = danh định
+ */
+BeltSpeedEstimator::BeltSpeedEstimator()
+    : head(0), count(0), exitUs(EXIT_NOMINAL_US), lastExitUs(0), matched(0) {
+}
+
+/**
+ * Thêm vào cuối hàng đợi; đầy thì sản phẩm cũ nhất coi như đã mất
+ */
+void BeltSpeedEstimator::expect(uint32_t pushUs) {
+    if (count == BELT_PENDING_CAPACITY) {
+        head = (head + 1) % BELT_PENDING_CAPACITY;
+        count--;
+    }
+    pending[(head + count) % BELT_PENDING_CAPACITY] = pushUs;
+    count++;
+}
+
+/**
+ * Ghép cạnh với sản phẩm đạt chuẩn cũ nhất:
+ * - sản phẩm đó chưa được đẩy hoặc mới đẩy quá ít: cạnh không phải của nó, bỏ cạnh
+ * - đã đẩy quá lâu: sản phẩm đó không tới được (bị lấy ra), bỏ nó và thử sản phẩm sau
+ * - còn lại: một lần đo, ước lượng đi 1/BELT_SMOOTHING quãng về phía lần đo
+ */
+bool BeltSpeedEstimator::observe(uint32_t edgeUs) {
+    while (count > 0) {
+        // So sánh bằng hiệu để an toàn khi micros() tràn số
+        int32_t elapsed = (int32_t)(edgeUs - pending[head]);
+        if (elapsed < exitUs / BELT_MATCH_RATIO) {
+            return false;
+        }
+        head = (head + 1) % BELT_PENDING_CAPACITY;
+        count--;
+        if (elapsed > exitUs * BELT_MATCH_RATIO) {
+            continue;
+        }
+        lastExitUs = (uint32_t)elapsed;
+        exitUs += (elapsed - exitUs) / BELT_SMOOTHING;
+        if (exitUs < EXIT_MIN_US) {
+            exitUs = EXIT_MIN_US;
+        } else if (exitUs > EXIT_MAX_US) {
+            exitUs = EXIT_MAX_US;
+        }
+        matched++;
+        return true;
+    }
+    return false;
+}
+
+/**
+ * Thời gian tỉ lệ với thời gian đẩy -> cảm biến cuối (quãng đường cố định)
+ * Tính theo ms để tích vẫn vừa 32 bit (tránh phép chia 64 bit trên AVR)
+ */
+unsigned long BeltSpeedEstimator::scale(unsigned long nominalMs) const {
+    return nominalMs * (unsigned long)(exitUs / 1000) / EXIT_TIME_MS;
+}
+
+/**
+ * Ước lượng (ms)
+ */
+uint16_t BeltSpeedEstimator::getExitMs() const {
+    return (uint16_t)(exitUs / 1000);
+}
+
+/**
+ * Lần đo gần nhất (ms)
+ */
+uint16_t BeltSpeedEstimator::getLastExitMs() const {
+    return (uint16_t)(lastExitUs / 1000);
+}
+
+/**
+ * Tốc độ tỉ lệ nghịch với thời gian đi hết quãng đường
+ */
+uint16_t BeltSpeedEstimator::getSpeedPercent() const {
+    return (uint16_t)((100L * EXIT_NOMINAL_US + exitUs / 2) / exitUs);
+}
+
+/**
+ * Số lần đo được chấp nhận
+ */
+uint16_t BeltSpeedEstimator::getMatchCount() const {
+    return matched;
+}
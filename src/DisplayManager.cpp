@@ -4,71 +4,313 @@
  */
 
 #include "DisplayManager.h"
+#include "Messages.h"
+#include <stdlib.h>
 
 /**
  * Constructor - Khởi tạo đối tượng LCD với các thông số cấu hình
+ * Kích thước được giới hạn theo bộ đệm tĩnh
  */
 DisplayManager::DisplayManager(int address, int columns, int rows)
-    : lcd(address, columns, rows), address(address), columns(columns), rows(rows) {
+    : lcd(address, columns, rows),
+      address(address),
+      columns(columns > DISPLAY_MAX_COLUMNS ? DISPLAY_MAX_COLUMNS : columns),
+      rows(rows > DISPLAY_MAX_ROWS ? DISPLAY_MAX_ROWS : rows),
+      writeCol(0),
+      writeRow(0),
+      lcdCol(-1),
+      lcdRow(-1),
+      scanIndex(0),
+      laneCount(1),
+      splashActive(false),
+      splashStart(0) {
+    memset(frame, ' ', sizeof(frame));
+    memset(shown, ' ', sizeof(shown));
 }
 
 /**
  * Khởi tạo LCD và hiển thị thông báo khởi động
  * Bước 1: Khởi động LCD
- * Bước 2: Bật đèn nền (backlight)
+ * Bước 2: Bật đèn nền (backlight) và xóa màn hình (bộ đệm shown khớp với LCD trắng)
  * Bước 3: Hiển thị thông báo hệ thống sẵn sàng
  */
 void DisplayManager::init() {
     lcd.init();
     lcd.backlight();
+    lcd.clear();
+    memset(shown, ' ', sizeof(shown));
+    lcdCol = 0;
+    lcdRow = 0;
     showStartupMessage();
 }
 
 /**
- * Xóa toàn bộ màn hình LCD
- * Tất cả ký tự sẽ bị xóa và con trỏ về vị trí (0,0)
+ * Xóa toàn bộ bộ đệm, vị trí ghi về (0,0)
+ * Không gọi lcd.clear() (mất ~2 ms); flush() chỉ xóa các ô đang có chữ
  */
 void DisplayManager::clear() {
-    lcd.clear();
+    memset(frame, ' ', sizeof(frame));
+    writeCol = 0;
+    writeRow = 0;
+    splashActive = false;
+}
+
+/**
+ * Ghi text tại vị trí ghi hiện tại
+ */
+void DisplayManager::print(const char* text) {
+    splashActive = false;
+    putText(text);
+}
+
+/**
+ * Ghi text tại vị trí chỉ định trên màn hình
+ * Đặt vị trí ghi trước khi ghi để kiểm soát vị trí chính xác
+ */
+void DisplayManager::print(const char* text, int col, int row) {
+    writeCol = col;
+    writeRow = row;
+    print(text);
+}
+
+/**
+ * Ghi chuỗi trong Flash tại vị trí ghi hiện tại
+ */
+void DisplayManager::print(const __FlashStringHelper* text) {
+    splashActive = false;
+    putText(text);
+}
+
+/**
+ * Ghi chuỗi trong Flash tại vị trí chỉ định
+ */
+void DisplayManager::print(const __FlashStringHelper* text, int col, int row) {
+    writeCol = col;
+    writeRow = row;
+    print(text);
+}
+
+/**
+ * Ghi số tại vị trí ghi hiện tại qua bộ đệm trên stack
+ */
+void DisplayManager::printNumber(long value, uint8_t decimals) {
+    char buffer[DISPLAY_NUMBER_BUFFER];
+    formatFixed(value, decimals, buffer);
+    print(buffer);
 }
 
 /**
- * Hiển thị text tại vị trí con trỏ hiện tại
+ * Ghi số tại vị trí chỉ định
  */
-void DisplayManager::print(const String& text) {
-    lcd.print(text);
+void DisplayManager::printNumber(long value, uint8_t decimals, int col, int row) {
+    writeCol = col;
+    writeRow = row;
+    printNumber(value, decimals);
 }
 
 /**
- * Hiển thị text tại vị trí chỉ định trên màn hình
- * Đặt con trỏ trước khi in để kiểm soát vị trí chính xác
+ * Đặt số làn: 1 làn giữ bố cục "Weight:" hai hàng, nhiều làn chia màn hình thành các ô
  */
-void DisplayManager::print(const String& text, int col, int row) {
-    lcd.setCursor(col, row);
-    lcd.print(text);
+void DisplayManager::setLaneCount(uint8_t count) {
+    laneCount = count == 0 ? 1 : count;
 }
 
 /**
- * Hiển thị trọng lượng dưới dạng:
- * Hàng 1: "Weight:"
- * Hàng 2: "<giá_trị> g"
- * Thêm khoảng trắng để xóa ký tự cũ còn sót lại
+ * Hiển thị trọng lượng
+ * Một làn:
+ *   Hàng 1: "Weight:" và ký hiệu xu hướng ở cột cuối
+ *   Hàng 2: "<giá_trị> g"
+ * Nhiều làn: mỗi làn một ô 8 cột "<làn>:<giá_trị>" (1 chữ số thập phân), ký hiệu xu
+ *   hướng ở cột cuối của ô nếu còn chỗ; làn 1-2 ở hàng 1, làn 3-4 ở hàng 2; chỉ ô của
+ *   làn vừa cân được ghi lại
+ * Điền khoảng trắng tới cuối hàng/ô; ô nào không đổi sẽ không được gửi lại
  */
-void DisplayManager::displayWeight(float weight) {
-    lcd.setCursor(0, 0);
-    lcd.print("Weight:         ");  // Xóa dữ liệu cũ
-    lcd.setCursor(0, 1);
-    lcd.print(weight);
-    lcd.print(" g      ");  // Xóa dữ liệu cũ
+void DisplayManager::displayWeight(float weight, uint8_t lane, char trend) {
+    char buffer[DISPLAY_NUMBER_BUFFER];
+    
+    if (laneCount > 1) {
+        // Các ô chỉ ghi đè một phần màn hình: xóa thông báo khởi động còn lại trước
+        if (splashActive) {
+            clear();
+        }
+        uint8_t cellsPerRow = columns / DISPLAY_LANE_CELL_COLUMNS;
+        if (cellsPerRow == 0 || lane >= cellsPerRow * rows) {
+            return;
+        }
+        formatWeight(weight, 1, buffer);
+        writeRow = lane / cellsPerRow;
+        writeCol = (lane % cellsPerRow) * DISPLAY_LANE_CELL_COLUMNS;
+        uint8_t end = writeCol + DISPLAY_LANE_CELL_COLUMNS;
+        putChar('1' + lane);
+        putChar(':');
+        putText(buffer);
+        padTo(end - 1);
+        if (writeCol < end) {
+            putChar(trend);
+        }
+        return;
+    }
+    
+    splashActive = false;
+    formatWeight(weight, 2, buffer);
+    writeCol = 0;
+    writeRow = 0;
+    putText(message(MSG_LCD_WEIGHT));
+    padTo(columns - 1);
+    putChar(trend);
+    writeCol = 0;
+    writeRow = 1;
+    putText(buffer);
+    putText(message(MSG_LCD_GRAM));
+    padRow();
 }
 
 /**
  * Hiển thị thông báo hệ thống sẵn sàng
- * Thông báo sẽ hiển thị trong 2 giây rồi tự động xóa
- * Góp phần tạo trải nghiệm người dùng tốt hơn
+ * Thông báo tự xóa sau DISPLAY_SPLASH_TIME_MS trong update(), trừ khi đã có nội dung mới
  */
 void DisplayManager::showStartupMessage() {
-    lcd.print("SYSTEM READY...");
-    delay(2000);
-    lcd.clear();
+    clear();
+    putText(message(MSG_LCD_READY));
+    splashActive = true;
+    splashStart = millis();
+}
+
+/**
+ * Quét bộ đệm từ vị trí dừng lần trước, gửi các ô khác với LCD
+ * - Chỉ gọi setCursor khi ô cần ghi không nằm ngay sau con trỏ LCD
+ * - Dừng khi hết thời gian (đã gửi ít nhất một ô), lần sau quét tiếp
+ */
+bool DisplayManager::flush(unsigned int budgetUs) {
+    unsigned long start = micros();
+    uint8_t total = columns * rows;
+    bool wrote = false;
+    
+    for (uint8_t n = 0; n < total; n++) {
+        uint8_t index = (scanIndex + n) % total;
+        uint8_t row = index / columns;
+        uint8_t col = index % columns;
+        char c = frame[row][col];
+        if (c == shown[row][col]) {
+            continue;
+        }
+        if (wrote && micros() - start >= budgetUs) {
+            scanIndex = index;
+            return false;
+        }
+        
+        if (lcdRow != row || lcdCol != col) {
+            lcd.setCursor(col, row);
+        }
+        lcd.write((uint8_t)c);
+        shown[row][col] = c;
+        lcdRow = row;
+        lcdCol = col + 1;  // LCD tự tăng con trỏ sau mỗi ký tự
+        wrote = true;
+    }
+    scanIndex = 0;
+    return true;
+}
+
+/**
+ * Cập nhật màn hình mỗi vòng lặp: hết thời gian thông báo khởi động thì xóa,
+ * sau đó gửi dần các ô thay đổi
+ */
+void DisplayManager::update() {
+    if (splashActive && millis() - splashStart >= DISPLAY_SPLASH_TIME_MS) {
+        clear();
+    }
+    flush();
+}
+
+/**
+ * Ghi ký tự vào bộ đệm, bỏ qua phần vượt quá cuối hàng
+ */
+void DisplayManager::putChar(char c) {
+    if (writeRow < rows && writeCol < columns) {
+        frame[writeRow][writeCol] = c;
+    }
+    writeCol++;
+}
+
+/**
+ * Ghi chuỗi vào bộ đệm
+ */
+void DisplayManager::putText(const char* text) {
+    while (*text) {
+        putChar(*text++);
+    }
+}
+
+/**
+ * Ghi chuỗi trong Flash vào bộ đệm, từng byte
+ */
+void DisplayManager::putText(const __FlashStringHelper* text) {
+    const char* p = reinterpret_cast<const char*>(text);
+    char c;
+    while ((c = (char)pgm_read_byte(p++)) != '\0') {
+        putChar(c);
+    }
+}
+
+/**
+ * Điền khoảng trắng để xóa ký tự cũ còn sót lại ở cuối hàng
+ */
+void DisplayManager::padRow() {
+    padTo(columns);
+}
+
+/**
+ * Điền khoảng trắng tới cột chỉ định để xóa ký tự cũ trong ô
+ */
+void DisplayManager::padTo(uint8_t col) {
+    if (col > columns) {
+        col = columns;
+    }
+    while (writeCol < col) {
+        putChar(' ');
+    }
+}
+
+/**
+ * Định dạng trọng lượng bằng số nguyên: làm tròn theo số chữ số thập phân rồi
+ * dùng formatFixed
+ */
+void DisplayManager::formatWeight(float weight, uint8_t decimals, char* buffer) {
+    if (decimals >= 2) {
+        formatFixed(lroundf(weight * 100.0f), 2, buffer);
+    } else {
+        formatFixed(lroundf(weight * 10.0f), 1, buffer);
+    }
+}
+
+/**
+ * Ghi phần nguyên bằng ultoa, phần thập phân từng chữ số (có số 0 đứng đầu)
+ */
+void DisplayManager::formatFixed(long value, uint8_t decimals, char* buffer) {
+    if (decimals > DISPLAY_MAX_DECIMALS) {
+        decimals = DISPLAY_MAX_DECIMALS;
+    }
+    unsigned long scale = 1;
+    for (uint8_t i = 0; i < decimals; i++) {
+        scale *= 10;
+    }
+    char* p = buffer;
+    unsigned long magnitude = (unsigned long)value;
+    if (value < 0) {
+        *p++ = '-';
+        magnitude = 0UL - magnitude;
+    }
+    ultoa(magnitude / scale, p, 10);
+    p += strlen(p);
+    if (decimals > 0) {
+        *p++ = '.';
+        unsigned long fraction = magnitude % scale;
+        for (uint8_t i = decimals; i > 0; i--) {
+            p[i - 1] = '0' + fraction % 10;
+            fraction /= 10;
+        }
+        p += decimals;
+    }
+    *p = '\0';
 }
@@ -0,0 +1,119 @@
+/**
+ * @file GradeEngine.cpp
+ * @brief Implementation của GradeEngine class
+ */
+
+#include "GradeEngine.h"
+#include "Telemetry.h"
+
+/**
+ * Constructor - tìm hạng đạt đầu tiên một lần, bộ đếm bắt đầu từ 0
+ */
+GradeEngine::GradeEngine(const GradeBand* table, uint8_t gradeCount)
+    : table(table),
+      gradeCount(gradeCount == 0 ? 1 : (gradeCount > MAX_GRADES ? MAX_GRADES : gradeCount)),
+      firstPassGrade(0) {
+    while (firstPassGrade < this->gradeCount && getAction(firstPassGrade) != EJECT_NONE) {
+        firstPassGrade++;
+    }
+    for (uint8_t i = 0; i + 1 < MAX_GRADES; i++) {
+        lowerBounds[i] = 0;
+    }
+    for (uint8_t i = 0; i < MAX_GRADES; i++) {
+        counts[i] = 0;
+    }
+}
+
+/**
+ * Số hạng
+ */
+uint8_t GradeEngine::getGradeCount() const {
+    return gradeCount;
+}
+
+/**
+ * Đọc float trong PROGMEM
+ */
+float GradeEngine::getFromGrams(uint8_t grade) const {
+    return pgm_read_float(&table[grade].fromGrams);
+}
+
+/**
+ * Cận của hạng g nằm ở lowerBounds[g - 1] (hạng 0 không có cận)
+ */
+void GradeEngine::setLowerBound(uint8_t grade, int32_t counts) {
+    if (grade == 0 || grade >= gradeCount) {
+        return;
+    }
+    lowerBounds[grade - 1] = counts;
+}
+
+/**
+ * Hai cận bằng nhau làm một hạng rỗng, vẫn hợp lệ; cận giảm thì tìm kiếm nhị phân sai
+ */
+bool GradeEngine::isSorted() const {
+    for (uint8_t i = 1; i + 1 < gradeCount; i++) {
+        if (lowerBounds[i] < lowerBounds[i - 1]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Hạng = số cận dưới <= trọng lượng. Tìm kiếm nhị phân: kết quả luôn nằm trong
+ * [low, high], mỗi bước thu hẹp một nửa
+ */
+uint8_t GradeEngine::classify(int32_t rawWeight) const {
+    uint8_t low = 0;
+    uint8_t high = gradeCount - 1;
+    while (low < high) {
+        uint8_t mid = (low + high + 1) / 2;
+        if (rawWeight >= lowerBounds[mid - 1]) {
+            low = mid;
+        } else {
+            high = mid - 1;
+        }
+    }
+    return low;
+}
+
+/**
+ * Đếm một sản phẩm
+ */
+void GradeEngine::count(uint8_t grade) {
+    if (grade < gradeCount) {
+        counts[grade]++;
+    }
+}
+
+/**
+ * Cơ cấu xử lý (PROGMEM)
+ */
+uint8_t GradeEngine::getAction(uint8_t grade) const {
+    return pgm_read_byte(&table[grade].action);
+}
+
+/**
+ * Tên hạng (PROGMEM)
+ */
+MessageId GradeEngine::getName(uint8_t grade) const {
+    return (MessageId)pgm_read_byte(&table[grade].name);
+}
+
+/**
+ * Hạng bị gạt nằm dưới hạng đạt đầu tiên là quá nhẹ, nằm trên là quá nặng
+ */
+uint8_t GradeEngine::getVerdict(uint8_t grade) const {
+    if (getAction(grade) == EJECT_NONE) {
+        return VERDICT_PASS;
+    }
+    return grade < firstPassGrade ? VERDICT_LIGHT : VERDICT_HEAVY;
+}
+
+/**
+ * Số sản phẩm của hạng
+ */
+uint16_t GradeEngine::getCount(uint8_t grade) const {
+    return grade < gradeCount ? counts[grade] : 0;
+}
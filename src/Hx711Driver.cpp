@@ -0,0 +1,115 @@
+/**
+ * @file Hx711Driver.cpp
+ * @brief Implementation của Hx711Driver class
+ */
+
+#include "Hx711Driver.h"
+
+/**
+ * Constructor - bit của chân tính bằng halPinMask (hằng số khi chân là hằng số)
+ */
+Hx711Driver::Hx711Driver(int doutPin, int sckPin, Hx711ShiftInFn fixedShiftIn)
+    : doutPin(doutPin),
+      sckPin(sckPin),
+      doutMask(halPinMask(doutPin)),
+      sckMask(halPinMask(sckPin)),
+      doutPort(nullptr),
+      sckPort(nullptr),
+      fixedShiftIn(fixedShiftIn) {
+}
+
+/**
+ * Chân DATA OUT
+ */
+int Hx711Driver::getDoutPin() const {
+    return doutPin;
+}
+
+/**
+ * Cấu hình chân, lấy thanh ghi một lần; SCK thấp = HX711 hoạt động (như HX711::begin)
+ */
+void Hx711Driver::begin() {
+    pinMode(sckPin, OUTPUT);
+    pinMode(doutPin, INPUT);
+    sckPort = portOutputRegister(halPinPort(sckPin));
+    doutPort = portInputRegister(halPinPort(doutPin));
+    *sckPort &= ~sckMask;
+}
+
+/**
+ * DOUT thấp = có dữ liệu mới
+ */
+bool Hx711Driver::isReady() const {
+    return (*doutPort & doutMask) == 0;
+}
+
+/**
+ * Chờ bận có giới hạn thời gian (giống MultiLoadCell::waitReady)
+ */
+bool Hx711Driver::waitReady(unsigned long timeoutMs) {
+    unsigned long start = millis();
+    while (!isReady()) {
+        if (millis() - start >= timeoutMs) {
+            return false;
+        }
+        delayMicroseconds(100);
+    }
+    return true;
+}
+
+/**
+ * Đọc ngoài ISR: ngắt chỉ tắt trong từng xung SCK
+ */
+int32_t Hx711Driver::read() {
+    return shiftIn(true);
+}
+
+/**
+ * Đọc trong ISR: ngắt đã tắt, không được bật lại giữa chừng
+ */
+int32_t Hx711Driver::readLocked() {
+    return shiftIn(false);
+}
+
+/**
+ * Mỗi xung: SCK lên, chờ ~1 µs (HX711 cần 0.1 µs để đưa bit ra DOUT, SCK cao tối
+ * thiểu 0.2 µs), đọc PINx, SCK xuống. Phần dịch giá trị và vòng lặp chạy khi SCK thấp,
+ * đủ thời gian SCK thấp tối thiểu (0.2 µs) mà không cần chờ thêm.
+ * Driver tạo bằng makeHx711Driver dùng hàm sinh cho đúng cặp chân.
+ */
+int32_t Hx711Driver::shiftIn(bool guardPulses) {
+    if (fixedShiftIn != nullptr) {
+        return fixedShiftIn(guardPulses);
+    }
+    uint32_t value = 0;
+    for (uint8_t i = 0; i < HX711_DATA_BITS; i++) {
+        if (guardPulses) {
+            noInterrupts();
+        }
+        *sckPort |= sckMask;
+        delayMicroseconds(1);
+        uint8_t level = *doutPort & doutMask;
+        *sckPort &= ~sckMask;
+        if (guardPulses) {
+            interrupts();
+        }
+        value = (value << 1) | (level ? 1 : 0);
+    }
+    for (uint8_t i = 0; i < HX711_GAIN_PULSES; i++) {
+        if (guardPulses) {
+            noInterrupts();
+        }
+        *sckPort |= sckMask;
+        delayMicroseconds(1);
+        *sckPort &= ~sckMask;
+        if (guardPulses) {
+            interrupts();
+        }
+    }
+
+    // Mở rộng dấu từ 24 bit sang 32 bit
+    if (value & 0x800000UL) {
+        value |= 0xFF000000UL;
+    }
+    return (int32_t)value;
+}
@@ -0,0 +1,27 @@
+/**
+ * @file IntMath.cpp
+ * @brief Implementation của các hàm số học nguyên
+ */
+
+#include "IntMath.h"
+
+/**
+ * Mỗi vòng quyết định một bit của kết quả, từ bit cao nhất
+ */
+uint16_t isqrt32(uint32_t value) {
+    uint32_t result = 0;
+    uint32_t bit = 1UL << 30;
+    while (bit > value) {
+        bit >>= 2;
+    }
+    while (bit != 0) {
+        if (value >= result + bit) {
+            value -= result + bit;
+            result = (result >> 1) + bit;
+        } else {
+            result >>= 1;
+        }
+        bit >>= 2;
+    }
+    return (uint16_t)result;
+}
@@ -0,0 +1,168 @@
+/**
+ * @file IrSensor.cpp
+ * @brief Implementation của IrSensor class
+ */
+
+#include "IrSensor.h"
+
+static_assert((IR_EDGE_QUEUE_SIZE & (IR_EDGE_QUEUE_SIZE - 1)) == 0,
+              "IR_EDGE_QUEUE_SIZE phai la luy thua cua 2");
+
+IrSensor* IrSensor::instances[IR_MAX_SENSORS];
+uint8_t IrSensor::instanceCount = 0;
+
+#if defined(ARDUINO) && defined(__AVR__)
+
+// Mỗi cổng một vector; cả ba cùng vào ISR chung, chân nào đổi mức do ISR tự so
+ISR(PCINT0_vect) {
+    IrSensor::onPinChange();
+}
+
+ISR(PCINT1_vect) {
+    IrSensor::onPinChange();
+}
+
+ISR(PCINT2_vect) {
+    IrSensor::onPinChange();
+}
+
+/**
+ * Bật bit của chân trong PCMSKx và bit của cổng trong PCICR
+ */
+static void enablePinChange(int pin) {
+    volatile uint8_t* pcicr = digitalPinToPCICR(pin);
+    if (pcicr == 0) {
+        return;
+    }
+    *digitalPinToPCMSK(pin) |= bit(digitalPinToPCMSKbit(pin));
+    *pcicr |= bit(digitalPinToPCICRbit(pin));
+}
+
+#elif defined(ARDUINO)
+
+// Board không phải AVR: chân nào cũng có ngắt ngoài, dùng cả hai cạnh
+static void enablePinChange(int pin) {
+    attachInterrupt(digitalPinToInterrupt(pin), IrSensor::onPinChange, CHANGE);
+}
+
+#else
+
+static void enablePinChange(int pin) {
+    halAttachPinChange((uint8_t)pin, IrSensor::onPinChange);
+}
+
+#endif
+
+/**
+ * Constructor - bit của chân tính bằng halPinMask như Hx711Driver
+ */
+IrSensor::IrSensor(int pin)
+    : pin(pin),
+      mask(pin >= 0 ? halPinMask(pin) : 0),
+      inputPort(nullptr),
+      head(0),
+      tail(0),
+      overruns(0),
+      lastLevel(0),
+      lastEdgeUs(0) {
+}
+
+/**
+ * Đọc mức ban đầu trước khi bật ngắt, để lần đổi mức đầu tiên được so đúng
+ */
+void IrSensor::begin() {
+    if (pin < 0 || inputPort != nullptr) {
+        return;
+    }
+    pinMode(pin, INPUT);
+    inputPort = portInputRegister(halPinPort(pin));
+
+    noInterrupts();
+    lastLevel = *inputPort & mask;
+    lastEdgeUs = micros() - IR_DEBOUNCE_US;
+    if (instanceCount < IR_MAX_SENSORS) {
+        instances[instanceCount++] = this;
+    }
+    interrupts();
+    enablePinChange(pin);
+}
+
+/**
+ * Có lắp cảm biến
+ */
+bool IrSensor::isConnected() const {
+    return pin >= 0;
+}
+
+/**
+ * Cảm biến kéo xuống thấp khi bị che
+ */
+bool IrSensor::isBlocked() const {
+    return inputPort != nullptr && (*inputPort & mask) == 0;
+}
+
+/**
+ * Hàng đợi khác rỗng
+ */
+bool IrSensor::hasEdge() const {
+    return tail != head;
+}
+
+/**
+ * Đọc dữ liệu trước rồi mới tăng tail, trả ô đó lại cho ISR (như SampleBuffer)
+ */
+bool IrSensor::pop(uint32_t& timeUs) {
+    if (tail == head) {
+        return false;
+    }
+    timeUs = edges[tail];
+    tail = (tail + 1) & (IR_EDGE_QUEUE_SIZE - 1);
+    return true;
+}
+
+/**
+ * Đưa tail lên head: bên đọc chỉ thay đổi tail nên không cần tắt ngắt
+ */
+void IrSensor::clear() {
+    tail = head;
+}
+
+/**
+ * Số cạnh bị mất
+ */
+uint8_t IrSensor::getOverruns() const {
+    return overruns;
+}
+
+/**
+ * ISR chung: một lần micros() cho mọi cảm biến, mỗi cảm biến một lần đọc PINx
+ */
+void IrSensor::onPinChange() {
+    uint32_t nowUs = micros();
+    for (uint8_t i = 0; i < instanceCount; i++) {
+        instances[i]->sample(nowUs);
+    }
+}
+
+/**
+ * Chỉ cạnh xuống (vừa bị che) được ghi; cạnh lên chỉ cập nhật mức
+ */
+void IrSensor::sample(uint32_t nowUs) {
+    uint8_t level = *inputPort & mask;
+    if (level == lastLevel) {
+        return;
+    }
+    lastLevel = level;
+    if (level != 0 || nowUs - lastEdgeUs < IR_DEBOUNCE_US) {
+        return;
+    }
+    lastEdgeUs = nowUs;
+
+    uint8_t next = (head + 1) & (IR_EDGE_QUEUE_SIZE - 1);
+    if (next == tail) {
+        overruns++;
+        return;
+    }
+    edges[head] = nowUs;
+    head = next;
+}
@@ -0,0 +1,454 @@
+/**
+ * @file LaneController.cpp
+ * @brief Implementation của LaneController class
+ */
+
+#include "LaneController.h"
+#include "Messages.h"
+
+/**
+ * Constructor - Liên kết các module của làn, ngưỡng được đổi sang count trong init()
+ */
+LaneController::LaneController(LoadCellManager* loadCell, ServoController* servoController, DisplayManager* display,
+                               Telemetry* telemetry, int irSensorPin, int irCountPin, const GradeBand* grades,
+                               uint8_t gradeCount)
+    : loadCell(loadCell),
+      servoController(servoController),
+      display(display),
+      telemetry(telemetry),
+      arrivalSensor(irSensorPin),
+      countSensor(irCountPin),
+      laneId(0),
+      grades(grades, gradeCount),
+      presenceRaw(0),
+      passCount(0),
+      rejectCount(0),
+      currentState(STATE_IDLE),
+      stateStartTime(0),
+      currentRaw(0),
+      currentGrade(0),
+      currentValid(false),
+      currentVerdict(VERDICT_PASS),
+      currentConfidence(0),
+      decisionTime(0),
+      settleMs(0),
+      arrivalTime(0),
+      announcedOnly(false),
+      laneEvents(0) {
+}
+
+/**
+ * Khởi tạo làn theo thứ tự:
+ * 1. IR Sensors - cảm biến phát hiện và đếm sản phẩm (nếu có lắp), đọc bằng ngắt đổi mức
+ * 2. LoadCell - cảm biến đo trọng lượng, tare (hoặc điểm 0 đã lưu) và đổi các cận
+ *    phân hạng sang count
+ * 3. Servo - cơ cấu đẩy và gạt của làn
+ * Điểm 0 đã lưu chỉ dùng khi hệ số hiệu chuẩn không đổi (nạp firmware với hệ số khác
+ * thì tare lại); bộ đếm được khôi phục trong mọi trường hợp
+ */
+void LaneController::init(uint8_t id, const LaneSnapshot* saved) {
+    laneId = id;
+    if (saved != nullptr) {
+        passCount = saved->passCount;
+        rejectCount = saved->rejectCount;
+        if (saved->scaleQ8 == loadCell->getScaleQ8()) {
+            loadCell->restoreZero(saved->tareOffset);
+            Serial.println(message(MSG_WARM_START));
+        }
+    }
+
+    arrivalSensor.begin();
+    countSensor.begin();
+    Serial.println(message(MSG_IR_READY));
+
+    loadCell->init();  // Tare (hoặc điểm 0 đã lưu) trong init, không tare lần hai
+    updateThresholds();
+
+    servoController->init();  // Chuyển động kiểm tra chạy nền và tự về 0°
+}
+
+/**
+ * Thực thi một bước của làn (non-blocking)
+ * Quy trình:
+ * 1. IDLE: cân ở chế độ chờ (không lọc), chờ cảm biến IR đến cân báo sản phẩm
+ *    hoặc cân thấy vật (> 10g) - làn không lắp IR hoặc IR bỏ sót
+ * 2. WEIGHING: lọc đầy đủ, chờ trọng lượng ổn định (hoặc hết thời gian),
+ *    phân loại PASS/REJECT, gạt servo 1
+ * 3. PUSHING: chờ servo 1 gạt xong rồi đưa về 0°
+ * 4. CLEARING: chờ sản phẩm rời khỏi cân rồi quay về IDLE
+ * Song song: servo 2 gạt sản phẩm lỗi khi tới hạn trong hàng đợi,
+ * nên nhiều sản phẩm có thể cùng nằm trên băng chuyền.
+ * Các cạnh của cảm biến cuối băng chuyền (ghi bằng ngắt) được xử lý ở mọi bước
+ */
+void LaneController::run() {
+    // Kiểm tra cảm biến đếm sản phẩm đạt chuẩn (chạy liên tục)
+    checkPassCounter();
+
+    {
+        PROFILE_SCOPE(PROF_SERVO);
+        // Gạt các sản phẩm lỗi đã tới vị trí servo 2
+        serviceEjector();
+        // Thực thi các chuyển động servo đã tới hạn
+        servoController->update();
+    }
+
+    // Lấy mẫu ở mọi trạng thái: trong lúc đẩy và chờ rời cân (~0.8 s) bộ đệm mẫu 8 phần tử
+    // sẽ tràn. Ngoài lúc cân, mẫu chỉ dùng để theo dõi nhiễu/điểm 0 và phát hiện vật trên
+    // cân (chế độ chờ, không qua median/EMA); lúc cân isSettled() lấy mẫu qua bộ lọc
+    bool loaded = false;
+    if (currentState != STATE_WEIGHING) {
+        // Cân rỗng: đang chờ sản phẩm và IR chưa báo sản phẩm mới (sản phẩm báo lúc
+        // CLEARING nằm yên trên cân tới khi về IDLE)
+        loaded = loadCell->pollIdle(presenceRaw, currentState == STATE_IDLE && !arrivalSensor.hasEdge());
+    }
+    if (loadCell->getZeroEvents() != 0) {
+        reportZeroEvent();
+    }
+    if (laneEvents != 0) {
+        reportLaneEvent();
+    }
+    unsigned long elapsed = millis() - stateStartTime;
+
+    switch (currentState) {
+        case STATE_IDLE:
+            // Điểm 0 đã lưu chưa kiểm tra xong (khối mẫu ổn định đầu tiên lúc cân rỗng):
+            // lệch >= 10 g thì cân rỗng trông như có vật, nên chỉ IR mở lần cân. Sản phẩm
+            // IR báo vẫn được cân và đẩy đi, để kiểm tra không lấy nó làm điểm 0
+            if (!loadCell->isZeroVerified()) {
+                loaded = false;
+            }
+            // Cạnh IR đến cân (ISR đã ghi) báo sản phẩm trước khi cân kịp thấy nó;
+            // không có IR thì chờ trọng lượng >= 10g (dưới ngưỡng coi như nhiễu)
+            if (loaded || arrivalSensor.hasEdge()) {
+                announcedOnly = !loaded;
+                telemetry->logArrival(laneId);
+                loadCell->beginSettling();
+                enterState(STATE_WEIGHING);
+                arrivalTime = takeArrivalTime(stateStartTime);
+            }
+            break;
+
+        case STATE_WEIGHING: {
+            // Quyết định ngay khi median ổn định - sản phẩm nhẹ/ổn định nhanh không phải chờ
+            // (servo 1 phải rảnh, ví dụ đã xong chuyển động kiểm tra lúc khởi động)
+            bool settled = loadCell->isSettled();
+            // Mở bởi cạnh IR: thời gian cân tính từ lúc tải tới cân, như khi cân tự phát
+            // hiện. IR bị che mà cân vẫn rỗng (tay người, vật lạ) thì không có gì để đẩy
+            if (announcedOnly) {
+                if (loadCell->hasLoad()) {
+                    announcedOnly = false;
+                    enterState(STATE_WEIGHING);
+                } else if (elapsed >= MAX_SETTLE_TIME_MS) {
+                    loadCell->endSettling();
+                    enterState(STATE_IDLE);
+                }
+                break;
+            }
+            if ((settled || elapsed >= MAX_SETTLE_TIME_MS) && !servoController->isBusy(SERVO_1)) {
+                classifyProduct(settled);
+                enterState(STATE_PUSHING);
+            }
+            break;
+        }
+
+        case STATE_PUSHING:
+            // Chờ servo 1 gạt xong và chạy về vị trí ban đầu theo quỹ đạo
+            if (!servoController->isBusy(SERVO_1)) {
+                reportProduct((uint16_t)elapsed);
+                enterState(STATE_CLEARING);
+            }
+            break;
+
+        case STATE_CLEARING:
+            // Chờ sản phẩm rời khỏi cân hoàn toàn
+            // Nếu băng chuyền đã đầy sản phẩm đang theo dõi thì chưa nhận sản phẩm mới
+            if (elapsed >= CLEAR_TIME_MS && !inFlight.isFull()) {
+                enterState(STATE_IDLE);
+            }
+            break;
+    }
+}
+
+/**
+ * Chuyển trạng thái và ghi lại thời điểm bắt đầu để tính thời gian chờ
+ */
+void LaneController::enterState(SystemState state) {
+    currentState = state;
+    stateStartTime = millis();
+}
+
+/**
+ * Phân loại sản phẩm theo trung bình median trong đoạn ổn định
+ * Nếu hết thời gian mà chưa ổn định thì dùng giá trị đã lọc hiện tại
+ * Servo 1 luôn gạt 180° để đẩy sản phẩm từ cân lên băng chuyền
+ */
+void LaneController::classifyProduct(bool settled) {
+    PROFILE_SCOPE(PROF_CLASSIFY);
+    currentRaw = settled ? loadCell->getSettledWeight() : loadCell->getRawWeight();
+    currentConfidence = settled ? loadCell->getSettleConfidence() : 0;
+    loadCell->endSettling();
+    currentGrade = grades.classify(currentRaw);
+    grades.count(currentGrade);
+    currentValid = (grades.getAction(currentGrade) == EJECT_NONE);
+    currentVerdict = grades.getVerdict(currentGrade);
+
+    if (currentValid) {
+        passCount++;
+    } else {
+        rejectCount++;
+    }
+
+    // Thời gian cân được ghi vào bản ghi telemetry khi servo 1 về xong
+    unsigned long now = millis();
+    decisionTime = now;
+    settleMs = (uint16_t)(now - arrivalTime);
+
+    // Thống kê quá trình: chi phí cố định, cảnh báo trôi được gửi cùng kết quả sản phẩm
+    stats.add(currentRaw, now);
+
+    // Hiển thị lên LCD - chỉ đổi sang gram ở biên hiển thị/Serial, kèm ký hiệu xu hướng
+    display->displayWeight(loadCell->countsToGrams(currentRaw), laneId, stats.getTrend());
+
+    // Servo 1 đặt bên phải cân, gạt sang 180° để đẩy sản phẩm rồi tự về 0°
+    servoController->scheduleMove(SERVO_1, PUSH_ANGLE, now, PUSH_DWELL_MS);
+
+    // Theo dõi sản phẩm trên băng chuyền: tới servo 2 sau khi servo 1 gạt tới 180°
+    // (thời gian theo quỹ đạo) và sản phẩm đi hết quãng đường từ cân tới servo 2.
+    // Ở tốc độ thiết kế servo 2 tới góc gạt lúc sản phẩm tới vị trí P (TRANSIT_TIME_MS
+    // cộng thời gian chạy của servo 2); quãng đường tới P đổi theo tốc độ đo được, thời
+    // gian chạy của servo 2 thì không, nên servo 2 vẫn chạm sản phẩm ở cùng vị trí
+    unsigned long pushTime = servoController->getMoveTime(SERVO_1, 0, PUSH_ANGLE);
+    unsigned long ejectMove = servoController->getMoveTime(SERVO_2, 0, EJECT_ANGLE);
+    unsigned long reachTime = belt.scale(TRANSIT_TIME_MS + ejectMove);
+    TrackedProduct product;
+    product.rawWeight = currentRaw;
+    product.action = grades.getAction(currentGrade);
+    product.ejectTime = now + pushTime + (reachTime > ejectMove ? reachTime - ejectMove : 0);
+    inFlight.push(product);  // Không thể đầy: CLEARING đã chờ hàng đợi có chỗ
+
+    // Sản phẩm đạt chuẩn sẽ che cảm biến cuối: đo tốc độ băng từ lúc nó rời cân
+    if (currentValid && countSensor.isConnected()) {
+        belt.expect(micros() + pushTime * 1000UL);
+    }
+}
+
+/**
+ * Điều khiển servo 2 không chặn:
+ * Khi servo 2 rảnh và sản phẩm đầu hàng đã tới vị trí servo 2 thì xử lý nó
+ * Sản phẩm của hạng đi hết băng chuyền chỉ được xóa khỏi hàng đợi, servo 2 không làm gì
+ */
+void LaneController::serviceEjector() {
+    if (inFlight.isEmpty() || servoController->isBusy(SERVO_2)) {
+        return;
+    }
+
+    unsigned long now = millis();
+    const TrackedProduct& product = inFlight.peek();
+    // So sánh bằng hiệu để an toàn khi millis() tràn số
+    if ((long)(now - product.ejectTime) < 0) {
+        return;
+    }
+
+    if (product.action == EJECT_SERVO_2) {
+        // Servo 2: Gạt 145° để đẩy sản phẩm lỗi ra ngoài băng chuyền, tự về 0° sau đó
+        servoController->scheduleMove(SERVO_2, EJECT_ANGLE, now, EJECT_DWELL_MS);
+    }
+    inFlight.pop();
+}
+
+/**
+ * Gửi kết quả sản phẩm: chế độ chữ in trọng lượng, kết luận và thống kê của làn;
+ * chế độ nhị phân gửi một khung cố định kèm thời gian từng giai đoạn
+ */
+void LaneController::reportProduct(uint16_t pushMs) {
+    ProductRecord record;
+    record.timestamp = decisionTime;
+    record.rawWeight = currentRaw;
+    record.verdict = currentVerdict;
+    record.confidence = currentConfidence;
+    record.passCount = passCount;
+    record.rejectCount = rejectCount;
+    record.settleMs = settleMs;
+    record.pushMs = pushMs;
+    record.inFlight = inFlight.size();
+    record.medianWindow = loadCell->getMedianWindow();
+    record.sampleRate = loadCell->getSampleRate();
+    record.noiseCounts = loadCell->getNoiseCounts();
+    record.lane = laneId;
+    record.grade = currentGrade;
+    int32_t drift = loadCell->getZeroDrift();
+    record.zeroDrift = (int16_t)(drift > 32767 ? 32767 : (drift < -32768 ? -32768 : drift));
+    telemetry->logProduct(record, loadCell->countsToGrams(currentRaw), grades.getName(currentGrade));
+    if (stats.takeRaised() != 0) {
+        reportStats(false);
+    }
+}
+
+/**
+ * Mỗi lần gọi một sự kiện (bit thấp nhất), xóa cờ khi Telemetry nhận khung
+ */
+void LaneController::reportZeroEvent() {
+    uint8_t events = loadCell->getZeroEvents();
+    uint8_t event = events & -events;
+    int32_t counts = (event == ZERO_EVENT_TRACK_LIMIT)    ? loadCell->getZeroDrift()
+                     : (event == ZERO_EVENT_TARE_NO_DATA) ? 0
+                                                          : loadCell->getRestoreError();
+    if (telemetry->logZero(millis(), laneId, event, counts, loadCell->countsToGrams(counts))) {
+        loadCell->clearZeroEvent(event);
+    }
+}
+
+/**
+ * Như reportZeroEvent(): mỗi lần gọi một sự kiện, xóa cờ khi Telemetry nhận khung
+ */
+void LaneController::reportLaneEvent() {
+    uint8_t event = laneEvents & -laneEvents;
+    if (telemetry->logEvent(millis(), laneId, event)) {
+        laneEvents &= ~event;
+    }
+}
+
+/**
+ * Đổi các cận sang count một lần để mỗi lần phân loại chỉ còn tìm kiếm nhị phân trên int32
+ */
+void LaneController::updateThresholds() {
+    for (uint8_t grade = 1; grade < grades.getGradeCount(); grade++) {
+        grades.setLowerBound(grade, loadCell->gramsToCounts(grades.getFromGrams(grade)));
+    }
+    if (!grades.isSorted()) {
+        laneEvents |= LANE_EVENT_GRADE_UNSORTED;
+    }
+    presenceRaw = loadCell->gramsToCounts(PRESENCE_THRESHOLD);
+
+    // Biểu đồ tần suất phủ từ cận đầu tới cận cuối của bảng (các hạng giữa)
+    uint8_t last = grades.getGradeCount() - 1;
+    int32_t low = last > 0 ? loadCell->gramsToCounts(grades.getFromGrams(1)) : presenceRaw;
+    int32_t high = last > 0 ? loadCell->gramsToCounts(grades.getFromGrams(last)) : presenceRaw;
+    stats.setRange(low, high);
+}
+
+/**
+ * Lấy các lần cảm biến IR cuối băng chuyền bị che (cạnh xuống, ISR ghi micros())
+ * Không lần nào bị sót dù vòng lặp bận, và thời điểm là lúc bị che, không phải lúc đọc
+ * Lưu ý: passCount đã được đếm tại cân, đây chỉ để xác nhận và đo tốc độ băng
+ */
+void LaneController::checkPassCounter() {
+    uint32_t edgeUs;
+    while (countSensor.pop(edgeUs)) {
+        bool matched = belt.observe(edgeUs);
+        unsigned long edgeTime = millis() - (micros() - edgeUs) / 1000;
+        telemetry->logPassCount(edgeTime, laneId, matched ? belt.getLastExitMs() : 0,
+                                (uint16_t)belt.scale(TRANSIT_TIME_MS));
+    }
+}
+
+/**
+ * Cạnh IR đến cân mới nhất (bỏ các cạnh cũ hơn); cạnh quá MAX_SETTLE_TIME_MS trước lúc
+ * cân phát hiện không phải của sản phẩm này (vật lạ, tay người che cảm biến)
+ */
+unsigned long LaneController::takeArrivalTime(unsigned long detectedAt) {
+    uint32_t edgeUs;
+    bool seen = false;
+    uint32_t latestUs = 0;
+    while (arrivalSensor.pop(edgeUs)) {
+        latestUs = edgeUs;
+        seen = true;
+    }
+    uint32_t ageUs = micros() - latestUs;
+    if (!seen || ageUs > MAX_SETTLE_TIME_MS * 1000UL) {
+        return detectedAt;
+    }
+    return millis() - ageUs / 1000;
+}
+
+/**
+ * Trạng thái lưu vào EEPROM; bộ đếm 16 bit như trong ProductRecord
+ */
+void LaneController::saveState(LaneSnapshot& snapshot) const {
+    snapshot.tareOffset = loadCell->getTareOffset();
+    snapshot.scaleQ8 = loadCell->getScaleQ8();
+    snapshot.passCount = (uint16_t)passCount;
+    snapshot.rejectCount = (uint16_t)rejectCount;
+}
+
+/**
+ * Tare lại theo lệnh - chỉ khi làn đang chờ sản phẩm (cân rỗng)
+ */
+bool LaneController::tare() {
+    if (currentState != STATE_IDLE) {
+        return false;
+    }
+    loadCell->tare();
+    return true;
+}
+
+/**
+ * Lấy số sản phẩm đạt chuẩn
+ */
+int LaneController::getPassCount() {
+    return passCount;
+}
+
+/**
+ * Lấy số sản phẩm bị loại
+ */
+int LaneController::getRejectCount() {
+    return rejectCount;
+}
+
+/**
+ * Bảng phân hạng của làn
+ */
+const GradeEngine& LaneController::getGrades() const {
+    return grades;
+}
+
+/**
+ * Một dòng: "Phan hang lan 1: <hạng 0> | >= 50.0 g: <hạng 1> | ..."
+ */
+void LaneController::printGrades() const {
+    Serial.print(message(MSG_BANNER_GRADES));
+    Serial.print(laneId + 1);
+    Serial.print(message(MSG_BANNER_GRADE_NAME));
+    Serial.print(message(grades.getName(0)));
+    for (uint8_t grade = 1; grade < grades.getGradeCount(); grade++) {
+        Serial.print(message(MSG_BANNER_GRADE_FROM));
+        Serial.print(grades.getFromGrams(grade), 1);
+        Serial.print(message(MSG_LCD_GRAM));
+        Serial.print(message(MSG_BANNER_GRADE_NAME));
+        Serial.print(message(grades.getName(grade)));
+    }
+    Serial.println();
+}
+
+/**
+ * Thống kê quá trình hoặc biểu đồ tần suất; gram chỉ dùng ở chế độ chữ
+ */
+bool LaneController::reportStats(bool histogram) {
+    float gramsPerCount = loadCell->countsToGrams(1);
+    if (histogram) {
+        return telemetry->logHistogram(laneId, stats, gramsPerCount);
+    }
+    return telemetry->logStats(laneId, stats, gramsPerCount, millis());
+}
+
+/**
+ * Xóa thống kê quá trình (dải biểu đồ giữ nguyên)
+ */
+void LaneController::resetStats() {
+    stats.reset();
+}
+
+/**
+ * Bật/tắt ghi mẫu thô của cân trong làn
+ */
+void LaneController::setCapture(Telemetry* sink) {
+    loadCell->setCapture(sink);
+}
+
+/**
+ * Làn đang ghi mẫu thô hay không
+ */
+bool LaneController::isCapturing() const {
+    return loadCell->isCapturing();
+}
@@ -4,70 +4,571 @@
  */
 
 #include "LoadCellManager.h"
+#include "Messages.h"
+#include "IntMath.h"
 #include <math.h>
 
+LoadCellManager* LoadCellManager::isrInstance = nullptr;
+
+// Phương sai của median / phương sai của một mẫu (nhiễu Gauss), dạng Q8, theo cửa sổ 1..7
+static const uint16_t MEDIAN_VARIANCE_Q8[MEDIAN_MAX_WINDOW + 1] = {
+    256, 256, 160, 115, 92, 73, 63, 54
+};
+
+// Số cặp mẫu tối thiểu trước khi tin ước lượng nhiễu
+static const uint8_t NOISE_MIN_SAMPLES = 16;
+
 /**
  * Constructor - Lưu trữ các thông số cấu hình
  * Không thực hiện khởi tạo phần cứng tại đây, chỉ lưu tham số
  */
-LoadCellManager::LoadCellManager(int doutPin, int sckPin, float calibrationFactor)
-    : doutPin(doutPin),
-      sckPin(sckPin),
-      calibrationFactor(calibrationFactor),
-      filteredWeight(0.0f),
-      hasFilteredWeight(false),
-      noiseFloor(3.0f),
-      spikeThreshold(50.0f),
-      alpha(0.25f) {
+LoadCellManager::LoadCellManager(int doutPin, int sckPin, float calibrationFactor,
+                                 AcquisitionMode mode, int ratePin)
+    : LoadCellManager(Hx711Driver(doutPin, sckPin), calibrationFactor, mode, ratePin) {
+}
+
+/**
+ * Constructor với driver tạo sẵn (chân cố định lúc biên dịch)
+ */
+LoadCellManager::LoadCellManager(const Hx711Driver& hx711, float calibrationFactor,
+                                 AcquisitionMode mode, int ratePin)
+    : hx711(hx711),
+      doutPin(hx711.getDoutPin()),
+      countsPerGramQ8(0),
+      countSign(1),
+      tareOffset(0),
+      noiseFloor(0),
+      mode(mode),
+      filter(5, FILTER_ALPHA_Q8, 0),
+      sampleCount(0),
+      settleTolerance(0),
+      settledMedian(0),
+      settlingActive(false),
+      tracking(false),
+      expectEmpty(false),
+      presenceLevel(0),
+      presenceRun(0),
+      loadSeen(false),
+      capture(nullptr),
+      sharedClock(nullptr),
+      ratePin(ratePin),
+      fastRate(false),
+      autoWindow(true),
+      discardSamples(0),
+      lastNet(0),
+      hasLastNet(false),
+      noiseVariance(0),
+      noiseSamples(0),
+      lastDisturbance(0),
+      accuracyLimit(0),
+      lastArrival(0),
+      arrivalInterval(0),
+      zeroUnverified(false),
+      zeroBand(0),
+      zeroFallbackBand(0),
+      zeroSum(0),
+      zeroSamples(0),
+      zeroAnchor(0),
+      zeroRestoreError(0),
+      zeroEvents(0),
+      zeroTrackBand(0),
+      zeroTrackStep(1),
+      zeroTrackLimit(0),
+      zeroDrift(0),
+      zeroLimitLatched(false),
+      lastZeroTrack(0) {
+    setCalibrationFactor(calibrationFactor);
+}
+
+/**
+ * Constructor cho làn dùng SCK chung - các tham số còn lại như constructor thường
+ */
+LoadCellManager::LoadCellManager(int doutPin, MultiLoadCell* sharedClock, float calibrationFactor)
+    : LoadCellManager(doutPin, -1, calibrationFactor, ACQ_SHARED_CLOCK, -1) {
+    this->sharedClock = sharedClock;
 }
 
 /**
  * Khởi tạo kết nối với HX711 và cấu hình cảm biến
  * Bước 1: Thiết lập các chân giao tiếp
- * Bước 2: Áp dụng hệ số hiệu chuẩn
- * Bước 3: Tare về 0 để loại bỏ trọng lượng bát/khay chứa
+ * Bước 2: Tare về 0 để loại bỏ trọng lượng bát/khay chứa - bỏ qua nếu đã có điểm 0
+ *         từ EEPROM (restoreZero), điểm 0 đó được kiểm tra nền trong addSample
+ * Bước 3: Bật chế độ lấy mẫu (ngắt hoặc polling)
+ * Hệ số hiệu chuẩn đã được đổi sang fixed-point trong constructor; Hx711Driver chỉ
+ * đọc giá trị thô
+ * Làn dùng SCK chung không dùng Hx711Driver mà gắn kênh vào MultiLoadCell
  */
 void LoadCellManager::init() {
-    hx711.begin(doutPin, sckPin);
-    hx711.set_scale(calibrationFactor);
-    hx711.tare();  // Đặt điểm 0 ban đầu
-    Serial.println("LoadCell Initialized");
+    if (ratePin >= 0) {
+        pinMode(ratePin, OUTPUT);
+        digitalWrite(ratePin, LOW);  // Bắt đầu ở 10 SPS (ít nhiễu nhất)
+    }
+    if (mode == ACQ_SHARED_CLOCK) {
+        if (!sharedClock->attach(this, doutPin)) {
+            Serial.println(message(MSG_LOADCELL_SHARED_FAIL));
+        }
+    } else {
+        hx711.begin();
+    }
+    if (!zeroUnverified) {
+        tare();  // Đặt điểm 0 ban đầu
+    }
+    setAcquisitionMode(mode);
+    Serial.println(message(MSG_LOADCELL_READY));
 }
 
 /**
- * Đọc trọng lượng nhanh với median filter để loại nhiễu
- * Median filter: lấy giá trị ở giữa sau khi sắp xếp - loại bỏ spike hiệu quả
- * @param samples Số mẫu đọc (mặc định 5 - tối ưu cho tốc độ và độ chính xác)
- * @return Trọng lượng tính bằng gram
+ * Đọc trọng lượng đã lọc - không bao giờ chờ ADC
+ * Mỗi chuyển đổi mới của HX711 cập nhật ngay ước lượng (không lấy lại cả loạt mẫu)
+ * Toàn bộ tính toán dùng int32, không có phép toán float
+ * @param samples Kích thước cửa sổ median; 0 = tự chọn theo nhiễu đo được (adaptSampling)
+ * @return Trọng lượng tính bằng count (đã trừ điểm 0)
  */
-float LoadCellManager::getWeight(int samples) {
-    if (!hx711.is_ready()) {
+int32_t LoadCellManager::getRawWeight(int samples) {
+    tracking = false;
+    autoWindow = (samples == 0);
+    if (!autoWindow) {
+        // Giới hạn samples để đảm bảo tốc độ
+        if (samples > 7) samples = 7;
+        if (samples < 3) samples = 3;
+        filter.setWindow(samples);
+    }
+    
+    pollSamples();
+    
+    // Triệt nhiễu nhỏ quanh 0g
+    int32_t weight = filter.getValue();
+    if (weight < noiseFloor && weight > -noiseFloor) {
         return 0;
     }
+    return weight;
+}
+
+/**
+ * Chế độ chờ: cùng đường lấy mẫu, addSample chỉ đếm các mẫu vượt ngưỡng
+ */
+bool LoadCellManager::pollIdle(int32_t presence, bool empty) {
+    tracking = true;
+    expectEmpty = empty;
+    presenceLevel = presence;
+    pollSamples();
+    return presenceRun >= IDLE_PRESENCE_SAMPLES;
+}
+
+/**
+ * Lấy mẫu mới mà không chờ:
+ * - ACQ_INTERRUPT: lấy hết các mẫu ISR đã ghi vào bộ đệm
+ * - ACQ_POLLING: đọc một mẫu nếu HX711 đã chuyển đổi xong (DOUT thấp)
+ * - ACQ_SHARED_CLOCK: đọc mọi kênh nếu tất cả đã sẵn sàng (làn nào gọi trước thì đọc
+ *   cho cả các làn khác), rồi lấy mẫu của làn này như chế độ ngắt
+ * Khi đang ghi mẫu thô, mỗi mẫu được gửi kèm thời điểm chuyển đổi. Ở chế độ ngắt,
+ * ISR chỉ lưu 16 bit thấp của millis(), đủ để khôi phục vì bộ đệm được đọc lại
+ * sau chưa tới 65 s.
+ * Cách lấy mẫu chỉ được chọn lại khi có mẫu mới (nhiễu và nhịp sản phẩm không đổi
+ * giữa hai mẫu), không phải ở mọi vòng lặp
+ */
+void LoadCellManager::pollSamples() {
+    int32_t raw;
+    uint16_t before = sampleCount;
+    if (mode != ACQ_POLLING) {
+        if (mode == ACQ_SHARED_CLOCK) {
+            sharedClock->poll();
+        }
+        uint16_t stamp;
+        while (rawSamples.pop(raw, stamp)) {
+            if (capture != nullptr) {
+                uint32_t now = millis();
+                capture->logSample(now - (uint16_t)((uint16_t)now - stamp), raw);
+            }
+            addSample(raw);
+        }
+    } else if (hx711.isReady()) {
+        int32_t value;
+        {
+            PROFILE_SCOPE(PROF_HX711);
+            value = hx711.read();
+        }
+        if (capture != nullptr) {
+            capture->logSample(millis(), value);
+        }
+        addSample(value);
+    }
+    if (sampleCount != before) {
+        adaptSampling();
+    }
+}
+
+/**
+ * Đưa mẫu đã trừ điểm 0 vào bộ lọc (xem WeightFilter::add)
+ * Median của cửa sổ cũng là đầu vào của bộ phát hiện ổn định
+ * Chế độ chờ bỏ qua median, EMA và bộ phát hiện ổn định: chỉ theo dõi nhiễu/điểm 0 và đếm mẫu
+ * liên tiếp vượt ngưỡng có vật
+ */
+void LoadCellManager::addSample(int32_t raw) {
+    if (discardSamples > 0) {
+        discardSamples--;  // HX711 vừa đổi tốc độ, mẫu chưa ổn định
+        return;
+    }
+    PROFILE_SCOPE(PROF_FILTER);
+    int32_t net = countSign * (raw - tareOffset);
+    if (!settlingActive) {
+        trackZero(net);
+        net = countSign * (raw - tareOffset);
+    }
+    trackNoise(net);
+    if (tracking && !settlingActive) {
+        if (net < presenceLevel) {
+            presenceRun = 0;
+        } else if (presenceRun < IDLE_PRESENCE_SAMPLES) {
+            presenceRun++;
+        }
+        sampleCount++;
+        return;
+    }
+    int32_t m = filter.add(net);
+    sampleCount++;
     
-    // Giới hạn samples để đảm bảo tốc độ (5 mẫu là tối ưu)
-    if (samples > 7) samples = 7;
-    if (samples < 3) samples = 3;
+    if (settlingActive && (loadSeen || m >= presenceLevel)) {
+        loadSeen = true;
+        settling.update(net);
+        settledMedian = m;
+    }
+}
+
+/**
+ * Mẫu từ bộ đọc SCK chung - cùng bộ đệm với ISR, chỉ khác bên ghi
+ */
+void LoadCellManager::queueSample(int32_t raw, uint16_t stamp) {
+    rawSamples.push(raw, stamp);
+}
+
+/**
+ * Số mẫu đã lọc
+ */
+uint16_t LoadCellManager::getSampleCount() const {
+    return sampleCount;
+}
+
+/**
+ * Bắt đầu theo dõi quá trình quá độ của sản phẩm vừa đặt lên cân
+ * Đồng thời cập nhật khoảng cách trung bình giữa các sản phẩm
+ * Từ chế độ chờ: cửa sổ median còn mẫu từ trước lúc chờ nên được xóa
+ */
+void LoadCellManager::beginSettling() {
+    if (tracking) {
+        filter.reset();
+        tracking = false;
+    }
+    presenceRun = 0;
+    loadSeen = false;
+    // Đoạn ổn định tính theo thời gian (3 mẫu ở 10 SPS, 24 mẫu ở 80 SPS) và chứa quá
+    // nửa cửa sổ median, để median nằm trong dải của đoạn
+    uint8_t run = (uint8_t)(SETTLE_RUN_MS * getSampleRate() / 1000);
+    uint8_t half = filter.getWindow() / 2 + 1;
+    int32_t noise = SETTLE_NOISE_SIGMAS * (int32_t)getNoiseCounts();
+    if (noise > 2 * settleTolerance) {
+        noise = 2 * settleTolerance;  // Nhiễu lớn hơn: chờ hết MAX_SETTLE_TIME_MS, dùng giá trị lọc
+    }
+    settling.reset(run > half ? run : half, settleTolerance + noise);
+    settlingActive = true;
     
-    // Đọc nhiều mẫu
-    float readings[7];
-    for (int i = 0; i < samples; i++) {
-        readings[i] = hx711.get_units(1);
+    unsigned long now = millis();
+    if (lastArrival != 0) {
+        long interval = (long)(now - lastArrival);
+        if (arrivalInterval == 0) {
+            arrivalInterval = interval;
+        } else {
+            arrivalInterval += (interval - (long)arrivalInterval) / (1 << INTERVAL_EWMA_SHIFT);
+        }
+    }
+    lastArrival = now;
+}
+
+/**
+ * Ngừng cập nhật bộ phát hiện ổn định (chỉ cần trong lúc cân)
+ */
+void LoadCellManager::endSettling() {
+    settlingActive = false;
+}
+
+/**
+ * Lấy các mẫu mới rồi kiểm tra median đã ổn định chưa
+ */
+bool LoadCellManager::isSettled() {
+    pollSamples();
+    return settling.isSettled();
+}
+
+/**
+ * Median đã vượt ngưỡng có vật trong lần cân này
+ */
+bool LoadCellManager::hasLoad() const {
+    return loadSeen;
+}
+
+/**
+ * Median của bộ lọc ở mẫu mới nhất của lần cân (count)
+ */
+int32_t LoadCellManager::getSettledWeight() const {
+    return settledMedian;
+}
+
+/**
+ * Độ tin cậy của trọng lượng ổn định (%)
+ */
+uint8_t LoadCellManager::getSettleConfidence() const {
+    return settling.getConfidence();
+}
+
+/**
+ * Ước lượng nhiễu từ hiệu hai mẫu liên tiếp: var(x1 - x2) = 2 sigma^2
+ * Chỉ đo khi cân đứng yên: không trong lúc cân (quá độ), và chưa có hiệu nào lớn
+ * hơn 4 sigma (sản phẩm lên/xuống, spike, dao động tắt dần) trong NOISE_QUIET_MS
+ * vừa qua. Khi chưa đủ mẫu thì dùng ngưỡng triệt nhiễu làm giới hạn tạm.
+ */
+void LoadCellManager::trackNoise(int32_t net) {
+    int32_t diff = net - lastNet;
+    bool valid = hasLastNet;
+    lastNet = net;
+    hasLastNet = true;
+    if (!valid || settlingActive) {
+        return;
+    }
+    
+    unsigned long now = millis();
+    uint32_t magnitude = (diff < 0) ? -diff : diff;
+    uint32_t half = (magnitude > 46340UL) ? 0xFFFFFFFFUL : magnitude * magnitude / 2;
+    bool disturbed = (noiseSamples < NOISE_MIN_SAMPLES)
+                         ? magnitude > (uint32_t)noiseFloor
+                         : half > noiseVariance * 8;
+    if (disturbed) {
+        lastDisturbance = now;
+        return;
+    }
+    if (now - lastDisturbance < NOISE_QUIET_MS) {
+        return;
+    }
+    
+    noiseVariance += ((int32_t)half - (int32_t)noiseVariance) / (1 << NOISE_EWMA_SHIFT);
+    if (noiseVariance > NOISE_VARIANCE_MAX) {
+        noiseVariance = NOISE_VARIANCE_MAX;
+    }
+    if (noiseSamples < NOISE_MIN_SAMPLES) {
+        noiseSamples++;
+    }
+}
+
+/**
+ * Chọn cách lấy mẫu, chỉ khi không có sản phẩm đang cân:
+ * - Tốc độ (khi có chân RATE): sản phẩm đến dày (hoặc vừa có sản phẩm) thì dùng 80 SPS
+ *   nếu median 7 mẫu ở 80 SPS vẫn đạt độ chính xác; thưa hoặc nhiễu thì về 10 SPS
+ * - Cửa sổ median: nhỏ nhất (3, 5, 7) đạt độ chính xác - lúc ít nhiễu kết luận nhanh
+ *   hơn, lúc nhiều nhiễu lấy trung vị trên nhiều mẫu hơn
+ */
+void LoadCellManager::adaptSampling() {
+    if (settlingActive || noiseSamples < NOISE_MIN_SAMPLES) {
+        return;
     }
     
-    // Sắp xếp mảng (insertion sort - nhanh cho mảng nhỏ)
-    for (int i = 1; i < samples; i++) {
-        float key = readings[i];
-        int j = i - 1;
-        while (j >= 0 && readings[j] > key) {
-            readings[j + 1] = readings[j];
-            j--;
+    if (ratePin >= 0) {
+        unsigned long interval = arrivalInterval;
+        unsigned long sinceLast = millis() - lastArrival;
+        if (lastArrival == 0 || sinceLast > interval) {
+            interval = (lastArrival == 0) ? 0 : sinceLast;  // Dây chuyền đang thưa dần
+        }
+        uint32_t fastVariance = noiseVariance;
+        if (!fastRate) {
+            fastVariance = noiseVariance * RATE_NOISE_RATIO_Q4 / 16;
+        }
+        bool fastAccurate = meetsAccuracy(fastVariance, MEDIAN_MAX_WINDOW);
+        if (!fastRate && fastAccurate && interval != 0 && interval < FAST_RATE_INTERVAL_MS) {
+            setFastRate(true);
+        } else if (fastRate && (!fastAccurate || interval == 0 || interval > SLOW_RATE_INTERVAL_MS)) {
+            setFastRate(false);
         }
-        readings[j + 1] = key;
     }
     
-    // Trả về giá trị median (ở giữa) - loại bỏ spike cao và thấp
-    return readings[samples / 2];
+    if (autoWindow) {
+        uint8_t window = ADAPTIVE_MIN_WINDOW;
+        while (window < MEDIAN_MAX_WINDOW && !meetsAccuracy(noiseVariance, window)) {
+            window += 2;
+        }
+        filter.setWindow(window);
+    }
+}
+
+/**
+ * 2 sigma của median <= độ chính xác  <=>  variance * hệ số median <= (độ chính xác / 2)^2
+ */
+bool LoadCellManager::meetsAccuracy(uint32_t variance, uint8_t window) const {
+    if (variance > NOISE_VARIANCE_MAX) {
+        return false;
+    }
+    return (variance * MEDIAN_VARIANCE_Q8[window] >> 8) <= accuracyLimit;
+}
+
+/**
+ * Đổi tốc độ: RATE cao = 80 SPS. Ước lượng nhiễu được quy đổi theo tỉ lệ datasheet
+ * cho tới khi đo lại, và bỏ vài mẫu đầu trong lúc HX711 ổn định lại
+ */
+void LoadCellManager::setFastRate(bool fast) {
+    fastRate = fast;
+    digitalWrite(ratePin, fast ? HIGH : LOW);
+    if (fast) {
+        noiseVariance = noiseVariance * RATE_NOISE_RATIO_Q4 / 16;
+    } else {
+        noiseVariance = noiseVariance * 16 / RATE_NOISE_RATIO_Q4;
+    }
+    discardSamples = RATE_SWITCH_DISCARD;
+    hasLastNet = false;
+}
+
+/**
+ * Độ lệch chuẩn nhiễu (count)
+ */
+uint16_t LoadCellManager::getNoiseCounts() const {
+    return isqrt32(noiseVariance);
+}
+
+/**
+ * Cửa sổ median đang dùng
+ */
+uint8_t LoadCellManager::getMedianWindow() const {
+    return filter.getWindow();
+}
+
+/**
+ * Tốc độ lấy mẫu hiện tại (SPS)
+ */
+uint8_t LoadCellManager::getSampleRate() const {
+    return fastRate ? 80 : 10;
+}
+
+/**
+ * Khoảng cách trung bình giữa hai sản phẩm (ms)
+ */
+unsigned long LoadCellManager::getArrivalInterval() const {
+    return arrivalInterval;
+}
+
+/**
+ * Xóa trạng thái bộ lọc - các mẫu cũ tính theo điểm 0 cũ không còn đúng
+ */
+void LoadCellManager::resetFilter() {
+    filter.reset();
+    hasLastNet = false;
+}
+
+/**
+ * Đọc trọng lượng tính bằng gram - chỉ đổi sang float ở bước cuối cùng
+ */
+float LoadCellManager::getWeight(int samples) {
+    return countsToGrams(getRawWeight(samples));
+}
+
+/**
+ * Đổi gram -> count: counts = grams * countsPerGram
+ * Chỉ gọi khi khởi tạo (chuyển ngưỡng sang count một lần duy nhất)
+ */
+int32_t LoadCellManager::gramsToCounts(float grams) const {
+    return (int32_t)lroundf(grams * countsPerGramQ8 / (float)(1L << SCALE_Q_BITS));
+}
+
+/**
+ * Đổi count -> gram cho hiển thị và Serial
+ */
+float LoadCellManager::countsToGrams(int32_t counts) const {
+    return counts * (float)(1L << SCALE_Q_BITS) / countsPerGramQ8;
+}
+
+/**
+ * Chọn chế độ lấy mẫu
+ * Chế độ ngắt chỉ dùng được khi DOUT nối vào chân ngắt ngoài (INT0/INT1)
+ */
+void LoadCellManager::setAcquisitionMode(AcquisitionMode newMode) {
+    if (mode == ACQ_SHARED_CLOCK || newMode == ACQ_SHARED_CLOCK) {
+        return;
+    }
+    if (mode == ACQ_INTERRUPT && isrInstance == this) {
+        detachDataReadyInterrupt();
+    }
+    
+    mode = newMode;
+    if (mode == ACQ_INTERRUPT) {
+        if (digitalPinToInterrupt(doutPin) == NOT_AN_INTERRUPT) {
+            Serial.println(message(MSG_LOADCELL_NO_INTERRUPT));
+            mode = ACQ_POLLING;
+            return;
+        }
+        attachDataReadyInterrupt();
+    }
+}
+
+/**
+ * Chế độ lấy mẫu đang dùng
+ */
+AcquisitionMode LoadCellManager::getAcquisitionMode() const {
+    return mode;
+}
+
+/**
+ * Số mẫu ISR phải bỏ vì bộ đệm đầy
+ */
+uint8_t LoadCellManager::getSampleOverruns() const {
+    return rawSamples.getOverruns();
+}
+
+/**
+ * Gắn ISR vào cạnh xuống của DOUT
+ * Nếu DOUT đã ở mức thấp từ trước (dữ liệu đang chờ) sẽ không có cạnh xuống,
+ * nên đọc ngay một lần để HX711 bắt đầu chuyển đổi tiếp theo
+ */
+void LoadCellManager::attachDataReadyInterrupt() {
+    isrInstance = this;
+    attachInterrupt(digitalPinToInterrupt(doutPin), onDataReady, FALLING);
+    noInterrupts();
+    onDataReady();
+    interrupts();
+}
+
+/**
+ * Gỡ ISR - cần khi tare tự đọc cảm biến
+ */
+void LoadCellManager::detachDataReadyInterrupt() {
+    detachInterrupt(digitalPinToInterrupt(doutPin));
+    isrInstance = nullptr;
+}
+
+/**
+ * ISR: HX711 báo có dữ liệu mới bằng cách kéo DOUT xuống thấp
+ * Dịch ra 24 bit (MSB trước), thêm xung chọn kênh A/gain 128, mở rộng dấu
+ * rồi ghi vào bộ đệm.
+ * Trên AVR chỉ chặn riêng ngắt INTn của DOUT rồi bật lại ngắt toàn cục, nên Timer0
+ * (millis) và UART không phải chờ cả lần đọc: Hx711Driver::read() chỉ tắt ngắt trong
+ * từng xung SCK, SCK vẫn không bao giờ ở mức cao quá 60 µs (HX711 power-down).
+ * ISR này không thể chạy lồng vì INTn đã bị chặn; nơi khác (native) đọc với ngắt tắt.
+ */
+void LoadCellManager::onDataReady() {
+    LoadCellManager* self = isrInstance;
+    // DOUT bật/tắt trong lúc dịch bit có thể để lại cờ ngắt giả
+    if (self == nullptr || !self->hx711.isReady()) {
+        return;
+    }
+    PROFILE_SCOPE(PROF_HX711);
+    
+#if defined(EIMSK) && defined(EIFR)
+    uint8_t intMask = bit(digitalPinToInterrupt(self->doutPin));  // Bit INTn trùng số ngắt
+    EIMSK &= ~intMask;
+    interrupts();
+    int32_t value = self->hx711.read();
+    noInterrupts();
+    // Xóa cờ ngắt do DOUT thay đổi trong lúc dịch bit rồi mới bỏ chặn INTn
+    EIFR = intMask;
+    EIMSK |= intMask;
+#else
+    int32_t value = self->hx711.readLocked();
+#endif
+    self->rawSamples.push(value, (uint16_t)millis());
 }
 
 /**
@@ -75,15 +576,265 @@ float LoadCellManager::getWeight(int samples) {
  * Sử dụng khi cần loại bỏ trọng lượng của vật chứa
  */
 void LoadCellManager::tare() {
-    hx711.tare();
+    // Tare tự đọc cảm biến, tạm gỡ ISR để tránh tranh chấp chân SCK
+    bool useInterrupt = (mode == ACQ_INTERRUPT && isrInstance == this);
+    if (useInterrupt) {
+        detachDataReadyInterrupt();
+    }
+    int32_t average;
+    if (!averageReadings(TARE_SAMPLES, average)) {
+        // Báo qua Telemetry từ LaneController::run(), giữ điểm 0 cũ
+        zeroEvents |= ZERO_EVENT_TARE_NO_DATA;
+        if (useInterrupt) {
+            attachDataReadyInterrupt();
+        }
+        return;
+    }
+    applyTare(average);
+    if (useInterrupt) {
+        attachDataReadyInterrupt();
+    }
+}
+
+/**
+ * Điểm 0 mới: bỏ các mẫu cũ để bộ lọc không trộn giá trị trước/sau, đoạn ghi mẫu thô
+ * nhận điểm 0 mới để phát lại đúng
+ */
+void LoadCellManager::applyTare(int32_t offset) {
+    tareOffset = offset;
+    zeroUnverified = false;
+    zeroDrift = 0;
+    zeroLimitLatched = false;
+    zeroSum = 0;
+    zeroSamples = 0;
+    lastZeroTrack = millis();
+    resetFilter();
+    if (capture != nullptr) {
+        capture->beginCapture(millis(), tareOffset, getScaleQ8());
+    }
+}
+
+/**
+ * Điểm 0 từ lần chạy trước: dùng ngay, kiểm tra sau
+ */
+void LoadCellManager::restoreZero(int32_t offset) {
+    tareOffset = offset;
+    zeroUnverified = true;
+    zeroSum = 0;
+    zeroSamples = 0;
+}
+
+/**
+ * Điểm 0 khi cân rỗng: cần một khối mẫu liên tiếp trong dải (mẫu ngoài dải - có vật,
+ * spike - bắt đầu gom lại), trung bình của chúng là độ lệch điểm 0
+ * - Điểm 0 lấy từ EEPROM chưa kiểm tra: ZERO_FALLBACK_SAMPLES mẫu trong
+ *   ±ZERO_FALLBACK_BAND_G quanh mẫu đầu khối, chỉ khi làn báo cân rỗng (sản phẩm IR đưa
+ *   lên cân lúc làn còn giữ cũng ổn định trong lúc đẩy và chờ rời cân). Độ lệch (trôi
+ *   nhiệt, vụn trên cân lúc mất điện) được trừ đi một lần, lệch quá ±ZERO_CHECK_BAND_G
+ *   thì báo
+ * - Đã kiểm tra (chế độ chờ): ZERO_TRACK_SAMPLES mẫu trong dải hẹp ±ZERO_TRACK_BAND_G
+ *   quanh 0 (dưới xa ngưỡng có vật), không đợi cân yên; mỗi ZERO_TRACK_INTERVAL_MS chỉnh
+ *   tối đa ZERO_TRACK_STEP_G. Sản phẩm đặt lên cân làm mẫu nhảy ra khỏi dải nên không bị
+ *   bám vào điểm 0; vật nhẹ để lại trên cân chỉ bị bám chậm và tổng không quá
+ *   ZERO_TRACK_LIMIT_G
+ * Mỗi mẫu một phép cộng int32, mỗi khối một phép chia
+ */
+void LoadCellManager::trackZero(int32_t net) {
+    // Cả kiểm tra lẫn tự bám chỉ khi làn biết cân rỗng: sản phẩm nằm yên trên cân lúc
+    // CLEARING, hay vừa được IR báo, trông như một khối ổn định lệch điểm 0
+    if (!tracking || !expectEmpty) {
+        zeroSum = 0;
+        zeroSamples = 0;
+        return;
+    }
+    int32_t band = zeroUnverified ? zeroFallbackBand : zeroTrackBand;
+    if (zeroSamples == 0) {
+        zeroAnchor = zeroUnverified ? net : 0;
+    }
+    if (net - zeroAnchor > band || net - zeroAnchor < -band) {
+        zeroSum = 0;
+        zeroSamples = 0;
+        return;
+    }
+    zeroSum += net;
+    zeroSamples++;
+    if (zeroSamples < (zeroUnverified ? ZERO_FALLBACK_SAMPLES : ZERO_TRACK_SAMPLES)) {
+        return;
+    }
+    int32_t error = zeroSum / zeroSamples;
+    zeroSum = 0;
+    zeroSamples = 0;
+    if (zeroUnverified) {
+        if (error > zeroBand || error < -zeroBand) {
+            zeroRestoreError = error;
+            zeroEvents |= ZERO_EVENT_RESTORE_FALLBACK;
+        }
+        applyTare(tareOffset + countSign * error);
+        return;
+    }
+    
+    // Giới hạn tốc độ và tổng độ trôi; so sánh bằng hiệu để an toàn khi millis() tràn số
+    unsigned long now = millis();
+    if (now - lastZeroTrack < ZERO_TRACK_INTERVAL_MS) {
+        return;
+    }
+    if (error > zeroTrackStep) {
+        error = zeroTrackStep;
+    } else if (error < -zeroTrackStep) {
+        error = -zeroTrackStep;
+    }
+    if (zeroDrift + error > zeroTrackLimit) {
+        error = zeroTrackLimit - zeroDrift;
+    } else if (zeroDrift + error < -zeroTrackLimit) {
+        error = -zeroTrackLimit - zeroDrift;
+    }
+    if (error == 0) {
+        return;
+    }
+    lastZeroTrack = now;
+    zeroDrift += error;
+    tareOffset += countSign * error;
+    if (capture != nullptr) {
+        capture->logCaptureZero(now, tareOffset);
+    }
+    // Báo một lần cho tới lần tare sau, kể cả khi độ trôi rời giới hạn rồi quay lại;
+    // làn gửi sự kiện ngoài đường lấy mẫu (Serial có thể chặn khi bộ đệm TX đầy)
+    if ((zeroDrift == zeroTrackLimit || zeroDrift == -zeroTrackLimit) && !zeroLimitLatched) {
+        zeroLimitLatched = true;
+        zeroEvents |= ZERO_EVENT_TRACK_LIMIT;
+    }
+}
+
+/**
+ * Điểm 0 hiện tại
+ */
+int32_t LoadCellManager::getTareOffset() const {
+    return tareOffset;
+}
+
+/**
+ * Điểm 0 đã đo hoặc đã kiểm tra
+ */
+bool LoadCellManager::isZeroVerified() const {
+    return !zeroUnverified;
+}
+
+/**
+ * Sự kiện điểm 0 đang chờ báo
+ */
+uint8_t LoadCellManager::getZeroEvents() const {
+    return zeroEvents;
+}
+
+/**
+ * Đã báo xong một sự kiện
+ */
+void LoadCellManager::clearZeroEvent(uint8_t event) {
+    zeroEvents &= ~event;
+}
+
+/**
+ * Độ chỉnh của lần tare nền
+ */
+int32_t LoadCellManager::getRestoreError() const {
+    return zeroRestoreError;
+}
+
+/**
+ * Tổng độ chỉnh của tự bám điểm 0 từ lần tare
+ */
+int32_t LoadCellManager::getZeroDrift() const {
+    return zeroDrift;
+}
+
+/**
+ * Hệ số Q8 kèm dấu, đúng như giá trị gửi trong FRAME_CAPTURE_START
+ */
+int32_t LoadCellManager::getScaleQ8() const {
+    return countSign * countsPerGramQ8;
+}
+
+/**
+ * Trung bình các lần chuyển đổi tiếp theo, chờ bận (chỉ lúc khởi động hoặc lệnh tare)
+ * Mẫu cũ trong bộ đệm bị bỏ. Trên SCK chung các làn khác cũng nhận mẫu trong lúc này
+ * và bỏ chúng khi tới lượt tare của mình
+ */
+bool LoadCellManager::averageReadings(uint8_t times, int32_t& average) {
+    int32_t raw;
+    uint16_t stamp;
+    while (rawSamples.pop(raw, stamp)) {
+    }
+    
+    int32_t sum = 0;
+    uint8_t count = 0;
+    if (mode == ACQ_SHARED_CLOCK) {
+        while (count < times && sharedClock->waitReady(HX711_READY_TIMEOUT_MS)) {
+            sharedClock->poll();
+            while (count < times && rawSamples.pop(raw, stamp)) {
+                sum += raw;
+                count++;
+            }
+        }
+    } else {
+        while (count < times && hx711.waitReady(HX711_READY_TIMEOUT_MS)) {
+            sum += hx711.read();
+            count++;
+        }
+    }
+    if (count < times) {
+        return false;
+    }
+    average = sum / times;
+    return true;
 }
 
 /**
  * Cập nhật hệ số hiệu chuẩn
  * Hệ số này quyết định độ chính xác của phép đo
  * Cần hiệu chuẩn bằng cách sử dụng các quả cân chuẩn
+ * Lưu dạng Q8 (count/gram * 256) kèm dấu riêng để trọng lượng dạng count luôn
+ * dương khi có vật trên cân; các ngưỡng đã đổi sang count cần tính lại
  */
 void LoadCellManager::setCalibrationFactor(float factor) {
-    calibrationFactor = factor;
-    hx711.set_scale(calibrationFactor);
-}
\ No newline at end of file
+    countSign = (factor < 0) ? -1 : 1;
+    countsPerGramQ8 = (int32_t)lroundf(fabsf(factor) * (1L << SCALE_Q_BITS));
+    if (countsPerGramQ8 == 0) {
+        countsPerGramQ8 = 1;  // Tránh chia cho 0 khi đổi sang gram
+    }
+    
+    // Ngưỡng của bộ lọc tính theo count
+    noiseFloor = gramsToCounts(FILTER_NOISE_FLOOR_G);
+    filter.setSpikeThreshold(gramsToCounts(FILTER_SPIKE_THRESHOLD_G));
+    settleTolerance = gramsToCounts(SETTLE_TOLERANCE_G);
+    zeroBand = gramsToCounts(ZERO_CHECK_BAND_G);
+    zeroFallbackBand = gramsToCounts(ZERO_FALLBACK_BAND_G);
+    zeroTrackBand = gramsToCounts(ZERO_TRACK_BAND_G);
+    zeroTrackStep = gramsToCounts(ZERO_TRACK_STEP_G);
+    if (zeroTrackStep < 1) {
+        zeroTrackStep = 1;
+    }
+    zeroTrackLimit = gramsToCounts(ZERO_TRACK_LIMIT_G);
+    int32_t halfAccuracy = gramsToCounts(SAMPLING_ACCURACY_G / 2);
+    accuracyLimit = (uint32_t)halfAccuracy * (uint32_t)halfAccuracy;
+}
+
+/**
+ * Bật/tắt ghi mẫu thô
+ * Khi tắt thì gửi nốt khối mẫu đang gom
+ */
+void LoadCellManager::setCapture(Telemetry* sink) {
+    if (capture != nullptr && sink == nullptr) {
+        capture->flushCapture();
+    }
+    capture = sink;
+    if (capture != nullptr) {
+        capture->beginCapture(millis(), tareOffset, getScaleQ8());
+    }
+}
+
+/**
+ * Đang ghi mẫu thô hay không
+ */
+bool LoadCellManager::isCapturing() const {
+    return capture != nullptr;
+}
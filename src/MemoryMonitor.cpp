@@ -0,0 +1,63 @@
+/**
+ * @file MemoryMonitor.cpp
+ * @brief Implementation của MemoryMonitor class
+ */
+
+#include "MemoryMonitor.h"
+
+#if defined(ARDUINO) && defined(__AVR__)
+
+// Ký hiệu do avr-libc/linker định nghĩa
+extern uint8_t __data_start;
+extern uint8_t __heap_start;
+extern char* __brkval;
+
+/**
+ * Đỉnh heap hiện tại (__brkval = 0 khi chưa malloc lần nào)
+ */
+static uint8_t* heapEnd() {
+    return __brkval != 0 ? (uint8_t*)__brkval : &__heap_start;
+}
+
+/**
+ * Tô từ đỉnh heap tới dưới SP một khoảng MEMORY_PAINT_GUARD
+ */
+void MemoryMonitor::paintStack() {
+    uint8_t* p = heapEnd();
+    uint8_t* limit = (uint8_t*)SP - MEMORY_PAINT_GUARD;
+    while (p < limit) {
+        *p++ = MEMORY_CANARY;
+    }
+}
+
+/**
+ * Quét từ đỉnh heap lên tới byte đầu tiên bị ghi đè (stack đã xuống tới đó)
+ */
+void MemoryMonitor::snapshot(MemoryStats& stats) {
+    uint8_t* heapTop = heapEnd();
+    uint8_t* stackPointer = (uint8_t*)SP;
+    uint8_t* p = heapTop;
+    while (p < stackPointer && *p == MEMORY_CANARY) {
+        p++;
+    }
+    stats.staticBytes = (uint16_t)(&__heap_start - &__data_start);
+    stats.heapBytes = (uint16_t)(heapTop - &__heap_start);
+    stats.freeBytes = (uint16_t)(stackPointer - heapTop);
+    stats.minFreeBytes = (uint16_t)(p - heapTop);
+    stats.stackMaxBytes = (uint16_t)((uint8_t*)RAMEND - p + 1);
+}
+
+#else
+
+void MemoryMonitor::paintStack() {
+}
+
+void MemoryMonitor::snapshot(MemoryStats& stats) {
+    stats.staticBytes = 0;
+    stats.heapBytes = 0;
+    stats.freeBytes = 0;
+    stats.minFreeBytes = 0;
+    stats.stackMaxBytes = 0;
+}
+
+#endif
@@ -0,0 +1,28 @@
+/**
+ * @file Messages.cpp
+ * @brief Các chuỗi của MESSAGE_CATALOG trong PROGMEM
+ */
+
+#include "Messages.h"
+
+// Mỗi thông báo một mảng PROGMEM riêng (PROGMEM không áp dụng cho chuỗi trong bảng con trỏ)
+#define MESSAGE_TEXT(id, text) static const char id##_TEXT[] PROGMEM = text;
+MESSAGE_CATALOG(MESSAGE_TEXT)
+#undef MESSAGE_TEXT
+
+// Bảng con trỏ theo ID, cũng nằm trong Flash
+#define MESSAGE_POINTER(id, text) id##_TEXT,
+static const char* const MESSAGE_TABLE[MSG_COUNT] PROGMEM = {
+    MESSAGE_CATALOG(MESSAGE_POINTER)
+};
+#undef MESSAGE_POINTER
+
+/**
+ * Đọc con trỏ chuỗi từ bảng trong Flash; ID ngoài bảng trả về "?"
+ */
+const __FlashStringHelper* message(MessageId id) {
+    if (id >= MSG_COUNT) {
+        id = MSG_UNKNOWN;
+    }
+    return reinterpret_cast<const __FlashStringHelper*>(pgm_read_ptr(&MESSAGE_TABLE[id]));
+}
@@ -0,0 +1,72 @@
+/**
+ * @file MotionProfile.cpp
+ * @brief Bảng quỹ đạo trong Flash và hàm nội suy
+ */
+
+#include "MotionProfile.h"
+#include "IntMath.h"
+
+// Kiểm tra lúc biên dịch: hai đầu bảng phải là 0 và 65535
+static_assert(sCurvePoint(0) == 0 && sCurvePoint(MOTION_TABLE_STEPS) == 65535, "S-curve sai");
+static_assert(trapezoidPoint(0) == 0 && trapezoidPoint(MOTION_TABLE_STEPS) == 65535, "Trapezoid sai");
+
+/**
+ * Sinh danh sách chỉ số 0..N lúc biên dịch (C++11 chưa có std::index_sequence)
+ */
+template<uint8_t... I> struct IndexList {};
+template<uint8_t N, uint8_t... I> struct MakeIndexList : MakeIndexList<N - 1, N - 1, I...> {};
+template<uint8_t... I> struct MakeIndexList<0, I...> { typedef IndexList<I...> type; };
+
+/**
+ * Bảng quỹ đạo: mỗi phần tử là giá trị constexpr của hàm tương ứng
+ */
+template<typename List> struct MotionTables;
+template<uint8_t... I> struct MotionTables<IndexList<I...> > {
+    static const uint16_t sCurve[sizeof...(I)];
+    static const uint16_t trapezoid[sizeof...(I)];
+};
+template<uint8_t... I>
+const uint16_t MotionTables<IndexList<I...> >::sCurve[sizeof...(I)] PROGMEM = { sCurvePoint(I)... };
+template<uint8_t... I>
+const uint16_t MotionTables<IndexList<I...> >::trapezoid[sizeof...(I)] PROGMEM = { trapezoidPoint(I)... };
+
+typedef MotionTables<MakeIndexList<MOTION_TABLE_STEPS + 1>::type> Tables;
+
+/**
+ * Thời gian chuyển động = max(giới hạn bởi vận tốc, giới hạn bởi gia tốc)
+ * - Vận tốc: 1.5 D / T <= vmax  =>  T >= 1500 D / vmax (ms)
+ * - Gia tốc: k D / T^2 <= amax  =>  T >= sqrt(k D / amax) * 1000 (ms)
+ */
+uint16_t motionDurationMs(uint16_t degrees, uint16_t maxSpeed, uint16_t maxAccel, MotionProfileType type) {
+    if (degrees == 0) {
+        return 0;
+    }
+    uint32_t bySpeed = (maxSpeed > 0) ? (1500UL * degrees + maxSpeed - 1) / maxSpeed : 0;
+    uint32_t byAccel = 0;
+    if (maxAccel > 0) {
+        // k/10 * D / amax * 10^6 (ms^2), tính theo thứ tự để không tràn uint32
+        uint32_t t2 = profileAccelFactorX10(type) * degrees * 100000UL / maxAccel;
+        byAccel = isqrt32(t2) + 1;
+    }
+    uint32_t duration = (bySpeed > byAccel) ? bySpeed : byAccel;
+    return (duration > 65535UL) ? 65535U : (uint16_t)duration;
+}
+
+/**
+ * Tra bảng trong Flash và nội suy tuyến tính giữa hai điểm liền kề
+ */
+uint16_t motionPosition(MotionProfileType type, unsigned long elapsed, unsigned long duration) {
+    if (duration == 0 || elapsed >= duration) {
+        return 65535U;
+    }
+    const uint16_t* table = (type == PROFILE_SCURVE) ? Tables::sCurve : Tables::trapezoid;
+    
+    // Vị trí trong bảng dạng Q8: phần nguyên là chỉ số, phần lẻ để nội suy
+    uint32_t pos = (uint32_t)elapsed * (MOTION_TABLE_STEPS * 256UL) / duration;
+    uint8_t index = pos >> 8;
+    uint8_t frac = pos & 0xFF;
+    
+    uint16_t a = pgm_read_word(&table[index]);
+    uint16_t b = pgm_read_word(&table[index + 1]);
+    return a + (uint16_t)(((uint32_t)(b - a) * frac) >> 8);
+}
@@ -0,0 +1,144 @@
+/**
+ * @file MultiLoadCell.cpp
+ * @brief Implementation của MultiLoadCell class
+ */
+
+#include "MultiLoadCell.h"
+#include "LoadCellManager.h"
+
+/**
+ * Constructor - chưa chạm vào phần cứng
+ */
+MultiLoadCell::MultiLoadCell(int sckPin)
+    : sckPin(sckPin),
+      sckPort(nullptr),
+      sckMask(0),
+      doutPort(nullptr),
+      doutPortId(NOT_A_PORT),
+      readyMask(0),
+      channels(0) {
+}
+
+/**
+ * Gắn kênh: kênh đầu tiên cấu hình SCK (mức thấp = HX711 hoạt động) và chọn cổng DOUT,
+ * các kênh sau phải có DOUT trên cùng cổng đó để một lần đọc PINx lấy được mọi bit
+ */
+bool MultiLoadCell::attach(LoadCellManager* lane, int doutPin) {
+    uint8_t port = digitalPinToPort(doutPin);
+    if (channels >= MULTI_LOADCELL_MAX_CHANNELS || port == NOT_A_PORT) {
+        return false;
+    }
+    if (channels == 0) {
+        pinMode(sckPin, OUTPUT);
+        digitalWrite(sckPin, LOW);
+        sckPort = portOutputRegister(digitalPinToPort(sckPin));
+        sckMask = digitalPinToBitMask(sckPin);
+        doutPort = portInputRegister(port);
+        doutPortId = port;
+    } else if (port != doutPortId) {
+        return false;
+    }
+    
+    pinMode(doutPin, INPUT);
+    doutMasks[channels] = digitalPinToBitMask(doutPin);
+    readyMask |= doutMasks[channels];
+    lanes[channels] = lane;
+    channels++;
+    return true;
+}
+
+/**
+ * Một lần đọc thanh ghi: mọi DOUT thấp thì mọi kênh đã có dữ liệu
+ */
+bool MultiLoadCell::isReady() const {
+    return channels > 0 && (*doutPort & readyMask) == 0;
+}
+
+/**
+ * Đọc một lượt khi mọi kênh sẵn sàng, gắn cùng một thời điểm cho mọi mẫu
+ * Kênh có dữ liệu sớm phải chờ kênh chậm nhất, nên có thể chuyển đổi xong lần tiếp
+ * theo ngay trong lúc đang bị đọc (dao động nội lệch nhau, khoảng 0.06% số lần đọc ở
+ * 10 SPS). Giá trị của kênh đó bị lẫn hai lần chuyển đổi: bỏ mẫu, DOUT vẫn thấp nên
+ * giá trị mới được đọc ở lượt sau
+ */
+bool MultiLoadCell::poll() {
+    if (!isReady()) {
+        return false;
+    }
+    int32_t values[MULTI_LOADCELL_MAX_CHANNELS];
+    uint8_t torn = readAll(values);
+    uint16_t stamp = (uint16_t)millis();
+    for (uint8_t i = 0; i < channels; i++) {
+        if (!(torn & doutMasks[i])) {
+            lanes[i]->queueSample(values[i], stamp);
+        }
+    }
+    return true;
+}
+
+/**
+ * Chờ bận có giới hạn thời gian, chỉ dùng lúc khởi động (giống HX711::wait_ready)
+ */
+bool MultiLoadCell::waitReady(unsigned long timeoutMs) {
+    unsigned long start = millis();
+    while (!isReady()) {
+        if (millis() - start >= timeoutMs) {
+            return false;
+        }
+        delayMicroseconds(100);
+    }
+    return true;
+}
+
+/**
+ * Số kênh đã gắn
+ */
+uint8_t MultiLoadCell::getChannelCount() const {
+    return channels;
+}
+
+/**
+ * Giai đoạn 1: 24 xung SCK, sau mỗi cạnh lên đọc nguyên thanh ghi PINx vào frames[],
+ * rồi các xung chọn gain. Như Hx711Driver, ngắt chỉ tắt trong từng xung (SCK cao ~1 µs,
+ * xa giới hạn 60 µs của HX711); ngắt giữa hai xung chỉ kéo dài lúc SCK thấp. Sau xung
+ * cuối mọi DOUT phải trở lại mức cao; kênh nào còn thấp đã có chuyển đổi mới trong lúc đọc.
+ * Giai đoạn 2: tách bit của từng kênh từ frames[], mở rộng dấu.
+ */
+uint8_t MultiLoadCell::readAll(int32_t values[]) {
+    PROFILE_SCOPE(PROF_HX711);
+    uint8_t frames[HX711_DATA_BITS];
+    
+    for (uint8_t i = 0; i < HX711_DATA_BITS; i++) {
+        noInterrupts();
+        *sckPort |= sckMask;
+        delayMicroseconds(1);
+        frames[i] = *doutPort;
+        *sckPort &= ~sckMask;
+        interrupts();
+    }
+    for (uint8_t i = 0; i < HX711_GAIN_PULSES; i++) {
+        noInterrupts();
+        *sckPort |= sckMask;
+        delayMicroseconds(1);
+        *sckPort &= ~sckMask;
+        interrupts();
+    }
+    uint8_t torn = (uint8_t)(~*doutPort) & readyMask;
+    
+    for (uint8_t ch = 0; ch < channels; ch++) {
+        uint8_t mask = doutMasks[ch];
+        uint32_t value = 0;
+        for (uint8_t i = 0; i < HX711_DATA_BITS; i++) {
+            value <<= 1;
+            if (frames[i] & mask) {
+                value |= 1;
+            }
+        }
+        // Mở rộng dấu từ 24 bit sang 32 bit
+        if (value & 0x800000UL) {
+            value |= 0xFF000000UL;
+        }
+        values[ch] = (int32_t)value;
+    }
+    return torn;
+}
@@ -0,0 +1,164 @@
+/**
+ * @file PersistentStore.cpp
+ * @brief Implementation của PersistentStore class
+ */
+
+#include "PersistentStore.h"
+#include "Telemetry.h"
+#include <string.h>
+
+static_assert(PERSIST_SLOTS >= 2, "EEPROM qua nho cho vong ban ghi");
+
+// Vị trí các trường trong bản ghi
+static const uint8_t RECORD_FORMAT = 0;
+static const uint8_t RECORD_SEQUENCE = 1;
+static const uint8_t RECORD_TARE = 3;
+static const uint8_t RECORD_SCALE = 7;
+static const uint8_t RECORD_PASS = 11;
+static const uint8_t RECORD_REJECT = 13;
+static const uint8_t RECORD_CRC = PERSIST_RECORD_BYTES - 1;
+
+static void put16(uint8_t* out, uint16_t value) {
+    out[0] = (uint8_t)value;
+    out[1] = (uint8_t)(value >> 8);
+}
+
+static void put32(uint8_t* out, uint32_t value) {
+    put16(out, (uint16_t)value);
+    put16(out + 2, (uint16_t)(value >> 16));
+}
+
+static uint16_t get16(const uint8_t* in) {
+    return (uint16_t)(in[0] | ((uint16_t)in[1] << 8));
+}
+
+static uint32_t get32(const uint8_t* in) {
+    return get16(in) | ((uint32_t)get16(in + 2) << 16);
+}
+
+/**
+ * Constructor - chưa biết ô nào hợp lệ cho tới begin()
+ */
+PersistentStore::PersistentStore() : pendingAddress(0), pendingIndex(PERSIST_RECORD_BYTES) {
+    for (uint8_t i = 0; i < PERSIST_CHANNELS; i++) {
+        newestSlot[i] = PERSIST_SLOTS;
+        sequence[i] = 0;
+    }
+}
+
+/**
+ * Quét mọi ô: ô hợp lệ có seq mới hơn (hiệu dương) là ô mới nhất của vùng
+ */
+void PersistentStore::begin() {
+    uint8_t record[PERSIST_RECORD_BYTES];
+    for (uint8_t channel = 0; channel < PERSIST_CHANNELS; channel++) {
+        newestSlot[channel] = PERSIST_SLOTS;
+        for (uint8_t slot = 0; slot < PERSIST_SLOTS; slot++) {
+            if (!readSlot(channel, slot, record)) {
+                continue;
+            }
+            uint16_t seq = get16(&record[RECORD_SEQUENCE]);
+            if (newestSlot[channel] == PERSIST_SLOTS || (int16_t)(seq - sequence[channel]) > 0) {
+                newestSlot[channel] = slot;
+                sequence[channel] = seq;
+            }
+        }
+    }
+}
+
+/**
+ * Đọc lại ô mới nhất (đã kiểm tra trong begin, đọc lại để không giữ bản sao trong RAM)
+ */
+bool PersistentStore::load(uint8_t channel, LaneSnapshot& snapshot) const {
+    uint8_t record[PERSIST_RECORD_BYTES];
+    if (channel >= PERSIST_CHANNELS || newestSlot[channel] >= PERSIST_SLOTS ||
+        !readSlot(channel, newestSlot[channel], record)) {
+        return false;
+    }
+    snapshot.tareOffset = (int32_t)get32(&record[RECORD_TARE]);
+    snapshot.scaleQ8 = (int32_t)get32(&record[RECORD_SCALE]);
+    snapshot.passCount = get16(&record[RECORD_PASS]);
+    snapshot.rejectCount = get16(&record[RECORD_REJECT]);
+    return true;
+}
+
+/**
+ * So với ô mới nhất, khác thì chuẩn bị bản ghi cho ô kế tiếp; service() ghi dần
+ */
+bool PersistentStore::save(uint8_t channel, const LaneSnapshot& snapshot) {
+    if (isBusy()) {
+        return false;
+    }
+    if (channel >= PERSIST_CHANNELS) {
+        return true;
+    }
+    encode(snapshot, pending);
+
+    uint8_t slot = 0;
+    if (newestSlot[channel] < PERSIST_SLOTS) {
+        uint8_t current[PERSIST_RECORD_BYTES];
+        if (readSlot(channel, newestSlot[channel], current) &&
+            memcmp(&current[RECORD_TARE], &pending[RECORD_TARE], RECORD_CRC - RECORD_TARE) == 0) {
+            return true;
+        }
+        slot = (newestSlot[channel] + 1) % PERSIST_SLOTS;
+    }
+
+    uint16_t seq = sequence[channel] + 1;
+    put16(&pending[RECORD_SEQUENCE], seq);
+    pending[RECORD_CRC] = Telemetry::crc8(pending, RECORD_CRC);
+    newestSlot[channel] = slot;
+    sequence[channel] = seq;
+    pendingAddress = slotAddress(channel, slot);
+    pendingIndex = 0;
+    return true;
+}
+
+/**
+ * Một byte mỗi lần, chỉ khi lần ghi trước đã xong - không bao giờ chờ EEPROM
+ * CRC là byte cuối: mất điện giữa chừng để lại ô sai CRC, ô trước vẫn hợp lệ
+ */
+void PersistentStore::service() {
+    if (!isBusy() || !eeprom_is_ready()) {
+        return;
+    }
+    eeprom_update_byte((uint8_t*)(uintptr_t)(pendingAddress + pendingIndex), pending[pendingIndex]);
+    pendingIndex++;
+}
+
+/**
+ * Còn byte chưa ghi
+ */
+bool PersistentStore::isBusy() const {
+    return pendingIndex < PERSIST_RECORD_BYTES;
+}
+
+/**
+ * Vùng của làn nối tiếp nhau, ô nối tiếp nhau trong vùng
+ */
+uint16_t PersistentStore::slotAddress(uint8_t channel, uint8_t slot) {
+    return channel * PERSIST_REGION_BYTES + slot * PERSIST_RECORD_BYTES;
+}
+
+/**
+ * Ô hợp lệ: đúng định dạng và đúng CRC (ô chưa ghi toàn 0xFF bị loại bởi định dạng)
+ */
+bool PersistentStore::readSlot(uint8_t channel, uint8_t slot, uint8_t* record) {
+    uint16_t address = slotAddress(channel, slot);
+    for (uint8_t i = 0; i < PERSIST_RECORD_BYTES; i++) {
+        record[i] = eeprom_read_byte((const uint8_t*)(uintptr_t)(address + i));
+    }
+    return record[RECORD_FORMAT] == PERSIST_FORMAT &&
+           record[RECORD_CRC] == Telemetry::crc8(record, RECORD_CRC);
+}
+
+/**
+ * Ghi các trường little-endian như khung telemetry
+ */
+void PersistentStore::encode(const LaneSnapshot& snapshot, uint8_t* record) {
+    record[RECORD_FORMAT] = PERSIST_FORMAT;
+    put32(&record[RECORD_TARE], (uint32_t)snapshot.tareOffset);
+    put32(&record[RECORD_SCALE], (uint32_t)snapshot.scaleQ8);
+    put16(&record[RECORD_PASS], snapshot.passCount);
+    put16(&record[RECORD_REJECT], snapshot.rejectCount);
+}
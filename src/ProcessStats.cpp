@@ -0,0 +1,287 @@
+/**
+ * @file ProcessStats.cpp
+ * @brief Implementation của ProcessStats class
+ */
+
+#include "ProcessStats.h"
+#include "IntMath.h"
+
+// Ô trong dải của biểu đồ (trừ ô dưới và ô trên dải)
+static const int32_t HIST_INNER_BINS = SPC_HIST_BINS - 2;
+
+/**
+ * Chia làm tròn về số gần nhất (cả số âm). Chia cắt bỏ lệch cùng một phía mỗi lần và
+ * làm trung bình Welford trôi tỉ lệ với n; làm tròn thì sai số có trung bình 0
+ */
+static int64_t divRound(int64_t value, int64_t divisor) {
+    return (value >= 0 ? value + divisor / 2 : value - divisor / 2) / divisor;
+}
+
+/**
+ * Constructor - dải biểu đồ được LaneController đặt theo bảng phân hạng
+ */
+ProcessStats::ProcessStats()
+    : histLow(0), histWidth(1) {
+    reset();
+}
+
+/**
+ * Xóa mọi thứ trừ dải biểu đồ
+ */
+void ProcessStats::reset() {
+    count = 0;
+    meanQ32 = 0;
+    m2 = 0;
+    for (uint8_t i = 0; i < SPC_HIST_BINS; i++) {
+        histogram[i] = 0;
+    }
+    lastItemMs = 0;
+    intervalMs = 0;
+    refMean = 0;
+    refSigma = 1;
+    cusumHigh = 0;
+    cusumLow = 0;
+    ewma = 0;
+    ewmaLimit = 0;
+    flags = 0;
+    raised = 0;
+    alarmCount = 0;
+}
+
+/**
+ * Độ rộng làm tròn lên để ô cuối trong dải vẫn kết thúc ở (hoặc sau) high
+ */
+void ProcessStats::setRange(int32_t low, int32_t high) {
+    int32_t width = high > low ? (high - low + HIST_INNER_BINS - 1) / HIST_INNER_BINS : 1;
+    if (low == histLow && width == histWidth) {
+        return;
+    }
+    histLow = low;
+    histWidth = width;
+    for (uint8_t i = 0; i < SPC_HIST_BINS; i++) {
+        histogram[i] = 0;
+    }
+}
+
+/**
+ * Một sản phẩm, chi phí cố định:
+ * - Welford: vài phép chia và 1 phép nhân int64
+ * - Biểu đồ: 1 phép chia int32
+ * - Nhịp, CUSUM, EWMA: cộng trừ int32 (EWMA thêm 1 phép chia)
+ */
+void ProcessStats::add(int32_t rawWeight, unsigned long now) {
+    count++;
+    int32_t weight = rawWeight > SPC_WEIGHT_LIMIT ? SPC_WEIGHT_LIMIT
+                   : (rawWeight < -SPC_WEIGHT_LIMIT ? -SPC_WEIGHT_LIMIT : rawWeight);
+    int64_t weightQ32 = (int64_t)weight << SPC_MEAN_SHIFT;
+    int64_t delta = weightQ32 - meanQ32;
+    meanQ32 += divRound(delta, count);
+    // delta * (x - mean mới): delta về Q8, độ lệch mới về count, để tích (tới 2^56) vừa int64.
+    // Hai độ lệch cùng dấu nên tích không âm, trừ khi làm tròn một độ lệch gần 0
+    int64_t residual = divRound(weightQ32 - meanQ32, 1LL << SPC_MEAN_SHIFT);
+    int64_t term = divRound(divRound(delta, 1LL << (SPC_MEAN_SHIFT - 8)) * residual, 1 << 8);
+    if (term > 0) {
+        m2 += (uint64_t)term;
+    }
+
+    uint8_t bin = 0;
+    if (rawWeight >= histLow) {
+        int32_t index = (rawWeight - histLow) / histWidth + 1;
+        bin = index > SPC_HIST_BINS - 1 ? SPC_HIST_BINS - 1 : (uint8_t)index;
+    }
+    if (histogram[bin] < 0xFFFF) {
+        histogram[bin]++;
+    }
+
+    // So sánh bằng hiệu để an toàn khi millis() tràn số
+    if (count > 1) {
+        int32_t gap = (int32_t)(now - lastItemMs);
+        intervalMs = intervalMs == 0 ? gap : intervalMs + (gap - intervalMs) / SPC_RATE_SMOOTHING;
+    }
+    lastItemMs = now;
+
+    if ((flags & SPC_BASELINE) == 0) {
+        if (count >= SPC_BASELINE_ITEMS) {
+            freezeBaseline();
+        }
+        return;
+    }
+
+    // CUSUM dạng bảng; tổng bị chặn ở 2H để trôi xong thì về 0 sau vài sản phẩm.
+    // Cảnh báo bật khi vượt H, tắt khi tổng về 0 (không bật tắt liên tục quanh H)
+    int32_t deviation = rawWeight - refMean;
+    int32_t slack = refSigma / 2;
+    int32_t decision = SPC_CUSUM_H_SIGMA * refSigma;
+    cusumHigh += deviation - slack;
+    cusumLow += -deviation - slack;
+    cusumHigh = cusumHigh < 0 ? 0 : (cusumHigh > 2 * decision ? 2 * decision : cusumHigh);
+    cusumLow = cusumLow < 0 ? 0 : (cusumLow > 2 * decision ? 2 * decision : cusumLow);
+    updateAlarm(SPC_CUSUM_HIGH, cusumHigh > decision, cusumHigh == 0);
+    updateAlarm(SPC_CUSUM_LOW, cusumLow > decision, cusumLow == 0);
+
+    // EWMA: cảnh báo tắt khi EWMA quay lại qua μ0
+    ewma += (rawWeight - ewma) / SPC_EWMA_SMOOTHING;
+    updateAlarm(SPC_EWMA_HIGH, ewma - refMean > ewmaLimit, ewma <= refMean);
+    updateAlarm(SPC_EWMA_LOW, refMean - ewma > ewmaLimit, ewma >= refMean);
+}
+
+/**
+ * μ0, σ0 lấy từ Welford; EWMA bắt đầu ở μ0
+ * Giới hạn tiệm cận L σ0 √(λ/(2−λ)) với λ = 1/S là L σ0 / √(2S − 1)
+ */
+void ProcessStats::freezeBaseline() {
+    refMean = getMean();
+    refSigma = getStdDev();
+    if (refSigma < 1) {
+        refSigma = 1;
+    }
+    uint32_t sigmaSquared = (uint32_t)refSigma * (uint32_t)refSigma;
+    ewmaLimit = SPC_EWMA_L * isqrt32(sigmaSquared / (2 * SPC_EWMA_SMOOTHING - 1));
+    ewma = refMean;
+    cusumHigh = 0;
+    cusumLow = 0;
+    flags |= SPC_BASELINE;
+}
+
+/**
+ * Cờ vừa chuyển từ tắt sang bật được giữ trong raised tới khi takeRaised()
+ */
+void ProcessStats::updateAlarm(uint8_t flag, bool trip, bool clear) {
+    if (clear) {
+        flags &= ~flag;
+        return;
+    }
+    if (trip && (flags & flag) == 0) {
+        flags |= flag;
+        raised |= flag;
+        alarmCount++;
+    }
+}
+
+/**
+ * Lấy và xóa các cờ vừa bật
+ */
+uint8_t ProcessStats::takeRaised() {
+    uint8_t result = raised;
+    raised = 0;
+    return result;
+}
+
+/**
+ * Số sản phẩm
+ */
+uint32_t ProcessStats::getCount() const {
+    return count;
+}
+
+/**
+ * Trung bình Q32 làm tròn về count
+ */
+int32_t ProcessStats::getMean() const {
+    return (int32_t)divRound(meanQ32, 1LL << SPC_MEAN_SHIFT);
+}
+
+/**
+ * Phương sai mẫu m2 / (n - 1), căn bậc hai nguyên
+ */
+uint16_t ProcessStats::getStdDev() const {
+    if (count < 2) {
+        return 0;
+    }
+    uint64_t variance = m2 / (count - 1);
+    return isqrt32(variance > 0xFFFFFFFFULL ? 0xFFFFFFFFUL : (uint32_t)variance);
+}
+
+/**
+ * Dây chuyền dừng lâu hơn khoảng cách trung bình thì dùng thời gian chờ hiện tại
+ */
+uint16_t ProcessStats::getRatePerMinute(unsigned long now) const {
+    if (intervalMs <= 0) {
+        return 0;
+    }
+    int32_t interval = intervalMs;
+    int32_t waiting = (int32_t)(now - lastItemMs);
+    if (waiting > interval) {
+        interval = waiting;
+    }
+    return (uint16_t)((60000L + interval / 2) / interval);
+}
+
+/**
+ * Trung bình gốc
+ */
+int32_t ProcessStats::getRefMean() const {
+    return refMean;
+}
+
+/**
+ * Độ lệch chuẩn gốc
+ */
+int32_t ProcessStats::getRefSigma() const {
+    return refSigma;
+}
+
+/**
+ * EWMA
+ */
+int32_t ProcessStats::getEwma() const {
+    return ewma;
+}
+
+/**
+ * Tổng đã chặn ở 2H (tối đa 200%), σ0 <= 65535 nên tích vẫn vừa int32
+ */
+uint8_t ProcessStats::getCusumPercent(bool high) const {
+    int32_t decision = SPC_CUSUM_H_SIGMA * refSigma;
+    int32_t sum = high ? cusumHigh : cusumLow;
+    int32_t percent = sum * 100 / decision;
+    return (uint8_t)(percent > 255 ? 255 : percent);
+}
+
+/**
+ * Cờ trạng thái
+ */
+uint8_t ProcessStats::getFlags() const {
+    return flags;
+}
+
+/**
+ * Số lần cảnh báo
+ */
+uint16_t ProcessStats::getAlarmCount() const {
+    return alarmCount;
+}
+
+/**
+ * Cận dưới của ô 1
+ */
+int32_t ProcessStats::getHistLow() const {
+    return histLow;
+}
+
+/**
+ * Độ rộng một ô
+ */
+int32_t ProcessStats::getHistWidth() const {
+    return histWidth;
+}
+
+/**
+ * Số sản phẩm của ô
+ */
+uint16_t ProcessStats::getBin(uint8_t bin) const {
+    return bin < SPC_HIST_BINS ? histogram[bin] : 0;
+}
+
+/**
+ * Trôi lên hoặc xuống theo cờ đang bật (cả hai cùng bật thì ưu tiên trôi lên)
+ */
+char ProcessStats::getTrend() const {
+    if (flags & (SPC_CUSUM_HIGH | SPC_EWMA_HIGH)) {
+        return '^';
+    }
+    if (flags & (SPC_CUSUM_LOW | SPC_EWMA_LOW)) {
+        return 'v';
+    }
+    return ' ';
+}
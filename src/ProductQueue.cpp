@@ -0,0 +1,66 @@
+/**
+ * @file ProductQueue.cpp
+ * @brief Implementation của ProductQueue class
+ */
+
+#include "ProductQueue.h"
+
+/**
+ * Constructor - Hàng đợi ban đầu rỗng
+ */
+ProductQueue::ProductQueue()
+    : head(0), count(0) {
+}
+
+/**
+ * Thêm sản phẩm vào vị trí (head + count) theo vòng
+ * Sản phẩm được cân theo thứ tự nên thời điểm tới servo 2 cũng tăng dần
+ */
+bool ProductQueue::push(const TrackedProduct& product) {
+    if (count >= PRODUCT_QUEUE_CAPACITY) {
+        return false;
+    }
+    uint8_t tail = (head + count) % PRODUCT_QUEUE_CAPACITY;
+    items[tail] = product;
+    count++;
+    return true;
+}
+
+/**
+ * Trả về sản phẩm cũ nhất
+ */
+const TrackedProduct& ProductQueue::peek() const {
+    return items[head];
+}
+
+/**
+ * Xóa sản phẩm cũ nhất, đầu hàng đợi tiến lên một vị trí
+ */
+void ProductQueue::pop() {
+    if (count == 0) {
+        return;
+    }
+    head = (head + 1) % PRODUCT_QUEUE_CAPACITY;
+    count--;
+}
+
+/**
+ * Hàng đợi rỗng - không có sản phẩm nào trên băng chuyền
+ */
+bool ProductQueue::isEmpty() const {
+    return count == 0;
+}
+
+/**
+ * Hàng đợi đầy - cần chờ trước khi nhận thêm sản phẩm
+ */
+bool ProductQueue::isFull() const {
+    return count >= PRODUCT_QUEUE_CAPACITY;
+}
+
+/**
+ * Số sản phẩm đang được theo dõi
+ */
+uint8_t ProductQueue::size() const {
+    return count;
+}
@@ -0,0 +1,155 @@
+/**
+ * @file Profiler.cpp
+ * @brief Implementation của Profiler class (chỉ biên dịch khi PROFILER_ENABLED)
+ */
+
+#include "Profiler.h"
+#include "Messages.h"
+
+#ifdef PROFILER_ENABLED
+
+Profiler profiler;
+
+/**
+ * Constructor - Thống kê rỗng, không có giai đoạn nào chờ xuất
+ */
+Profiler::Profiler() : lastLoopStart(0), loopStarted(false), dumpStage(PROF_STAGE_COUNT) {
+    clearStats();
+}
+
+/**
+ * Ghi một lần đo:
+ * - total sắp tràn thì chia đôi cả total và count (giữ nguyên trung bình)
+ * - bucket đầy (255) thì chia đôi mọi bucket (giữ nguyên hình dạng histogram)
+ */
+void Profiler::record(ProfileStage stage, unsigned long us) {
+    ProfileStats& s = stats[stage];
+    
+    if (s.total + us < s.total) {
+        s.total >>= 1;
+        s.count >>= 1;
+    }
+    s.total += us;
+    s.count++;
+    
+    uint16_t clamped = (us > 0xFFFF) ? 0xFFFF : (uint16_t)us;
+    if (clamped < s.minUs) {
+        s.minUs = clamped;
+    }
+    if (clamped > s.maxUs) {
+        s.maxUs = clamped;
+    }
+    
+    // floor(log2(us)) bằng dịch bit, giới hạn ở bucket cuối
+    uint8_t bucket = 0;
+    while (us > 1 && bucket < PROFILER_BUCKETS - 1) {
+        us >>= 1;
+        bucket++;
+    }
+    if (s.histogram[bucket] == 0xFF) {
+        for (uint8_t i = 0; i < PROFILER_BUCKETS; i++) {
+            s.histogram[i] >>= 1;
+        }
+    }
+    s.histogram[bucket]++;
+}
+
+/**
+ * Khoảng cách giữa hai lần gọi liên tiếp là một chu kỳ vòng lặp
+ */
+void Profiler::markLoop() {
+    unsigned long now = micros();
+    if (loopStarted) {
+        record(PROF_LOOP, now - lastLoopStart);
+    }
+    lastLoopStart = now;
+    loopStarted = true;
+}
+
+/**
+ * Chép thống kê; tắt ngắt vì ISR có thể đang ghi PROF_HX711
+ */
+void Profiler::snapshot(ProfileStage stage, ProfileStats& out) const {
+    noInterrupts();
+    out = stats[stage];
+    interrupts();
+}
+
+/**
+ * Xóa thống kê; tắt ngắt để ISR không ghi xen vào
+ */
+void Profiler::reset() {
+    noInterrupts();
+    clearStats();
+    interrupts();
+    loopStarted = false;
+}
+
+/**
+ * Min bắt đầu ở giá trị lớn nhất để lần đo đầu tiên ghi đè
+ */
+void Profiler::clearStats() {
+    for (uint8_t i = 0; i < PROF_STAGE_COUNT; i++) {
+        ProfileStats& s = stats[i];
+        s.count = 0;
+        s.total = 0;
+        s.minUs = 0xFFFF;
+        s.maxUs = 0;
+        for (uint8_t b = 0; b < PROFILER_BUCKETS; b++) {
+            s.histogram[b] = 0;
+        }
+    }
+}
+
+/**
+ * Bắt đầu xuất từ giai đoạn đầu tiên
+ */
+void Profiler::requestDump() {
+    dumpStage = 0;
+}
+
+/**
+ * Lấy giai đoạn cần xuất tiếp theo (một giai đoạn mỗi vòng lặp để không chặn Serial)
+ */
+bool Profiler::nextDump(ProfileStage& stage) {
+    if (dumpStage >= PROF_STAGE_COUNT) {
+        return false;
+    }
+    stage = (ProfileStage)dumpStage++;
+    return true;
+}
+
+/**
+ * Lùi lại một giai đoạn để gửi lại ở vòng lặp sau
+ */
+void Profiler::retryDump() {
+    if (dumpStage > 0) {
+        dumpStage--;
+    }
+}
+
+/**
+ * Trung bình = total / count (0 nếu chưa đo lần nào)
+ */
+uint16_t Profiler::mean(const ProfileStats& s) {
+    if (s.count == 0) {
+        return 0;
+    }
+    uint32_t m = s.total / s.count;
+    return (m > 0xFFFF) ? 0xFFFF : (uint16_t)m;
+}
+
+static_assert(MSG_STAGE_SERIAL - MSG_STAGE_LOOP + 1 == PROF_STAGE_COUNT,
+              "MSG_STAGE_* phai khop ProfileStage");
+
+/**
+ * Tên giai đoạn in ở chế độ chữ: MSG_STAGE_* cùng thứ tự với ProfileStage
+ */
+const __FlashStringHelper* Profiler::stageName(ProfileStage stage) {
+    if (stage >= PROF_STAGE_COUNT) {
+        return message(MSG_UNKNOWN);
+    }
+    return message((MessageId)(MSG_STAGE_LOOP + stage));
+}
+
+#endif
@@ -0,0 +1,119 @@
+/**
+ * @file RunningMedian.cpp
+ * @brief Implementation của RunningMedian class
+ */
+
+#include "RunningMedian.h"
+
+/**
+ * Constructor - Cửa sổ rỗng
+ */
+RunningMedian::RunningMedian(uint8_t window)
+    : window(1), next(0), count(0) {
+    setWindow(window);
+}
+
+/**
+ * Thêm mẫu mới:
+ * Bước 1: Nếu cửa sổ đầy, xóa mẫu cũ nhất khỏi mảng sắp xếp
+ * Bước 2: Chèn mẫu mới vào đúng vị trí (binary search + dịch phần tử)
+ * Bước 3: Ghi mẫu mới vào ring thay cho mẫu cũ nhất
+ */
+int32_t RunningMedian::add(int32_t sample) {
+    if (count == window) {
+        int32_t oldest = ring[next];
+        uint8_t pos = lowerBound(oldest);
+        for (uint8_t i = pos; i + 1 < count; i++) {
+            sorted[i] = sorted[i + 1];
+        }
+        count--;
+    }
+    
+    uint8_t pos = lowerBound(sample);
+    for (uint8_t i = count; i > pos; i--) {
+        sorted[i] = sorted[i - 1];
+    }
+    sorted[pos] = sample;
+    count++;
+    
+    ring[next] = sample;
+    next = (next + 1) % window;
+    
+    return median();
+}
+
+/**
+ * Median: phần tử giữa của mảng đã sắp xếp
+ * Với số mẫu chẵn lấy phần tử giữa phía trên (giống median cũ của getWeight)
+ */
+int32_t RunningMedian::median() const {
+    if (count == 0) {
+        return 0;
+    }
+    return sorted[count / 2];
+}
+
+/**
+ * Đổi kích thước cửa sổ
+ * Dựng lại ring và mảng sắp xếp từ các mẫu mới nhất (chỉ xảy ra khi đổi cấu hình)
+ */
+void RunningMedian::setWindow(uint8_t newWindow) {
+    if (newWindow < 1) newWindow = 1;
+    if (newWindow > MEDIAN_MAX_WINDOW) newWindow = MEDIAN_MAX_WINDOW;
+    if (newWindow == window) {
+        return;
+    }
+    
+    // Lấy các mẫu theo thứ tự từ cũ tới mới
+    int32_t recent[MEDIAN_MAX_WINDOW];
+    uint8_t keep = (count < newWindow) ? count : newWindow;
+    for (uint8_t i = 0; i < keep; i++) {
+        uint8_t idx = (next + window - keep + i) % window;
+        recent[i] = ring[idx];
+    }
+    
+    window = newWindow;
+    reset();
+    for (uint8_t i = 0; i < keep; i++) {
+        add(recent[i]);
+    }
+}
+
+/**
+ * Kích thước cửa sổ hiện tại
+ */
+uint8_t RunningMedian::getWindow() const {
+    return window;
+}
+
+/**
+ * Số mẫu đang có
+ */
+uint8_t RunningMedian::size() const {
+    return count;
+}
+
+/**
+ * Xóa cửa sổ - dùng sau khi tare
+ */
+void RunningMedian::reset() {
+    next = 0;
+    count = 0;
+}
+
+/**
+ * Binary search trên mảng sắp xếp
+ */
+uint8_t RunningMedian::lowerBound(int32_t value) const {
+    uint8_t lo = 0;
+    uint8_t hi = count;
+    while (lo < hi) {
+        uint8_t mid = (lo + hi) / 2;
+        if (sorted[mid] < value) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
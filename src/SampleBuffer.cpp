@@ -0,0 +1,52 @@
+/**
+ * @file SampleBuffer.cpp
+ * @brief Implementation của SampleBuffer class
+ */
+
+#include "SampleBuffer.h"
+
+static_assert((SAMPLE_BUFFER_SIZE & (SAMPLE_BUFFER_SIZE - 1)) == 0,
+              "SAMPLE_BUFFER_SIZE phai la luy thua cua 2");
+
+/**
+ * Constructor - head == tail nghĩa là bộ đệm rỗng
+ */
+SampleBuffer::SampleBuffer()
+    : head(0), tail(0), overruns(0) {
+}
+
+/**
+ * Ghi dữ liệu trước rồi mới tăng head, để bên đọc không bao giờ thấy
+ * một ô chưa ghi xong. Một ô luôn để trống để phân biệt đầy và rỗng.
+ */
+bool SampleBuffer::push(int32_t sample, uint16_t stamp) {
+    uint8_t next = (head + 1) & (SAMPLE_BUFFER_SIZE - 1);
+    if (next == tail) {
+        overruns++;
+        return false;
+    }
+    data[head] = sample;
+    stamps[head] = stamp;
+    head = next;
+    return true;
+}
+
+/**
+ * Đọc dữ liệu trước rồi mới tăng tail, trả ô đó lại cho ISR
+ */
+bool SampleBuffer::pop(int32_t& sample, uint16_t& stamp) {
+    if (tail == head) {
+        return false;
+    }
+    sample = data[tail];
+    stamp = stamps[tail];
+    tail = (tail + 1) & (SAMPLE_BUFFER_SIZE - 1);
+    return true;
+}
+
+/**
+ * Số mẫu bị mất - dùng để chẩn đoán khi vòng lặp chính quá chậm
+ */
+uint8_t SampleBuffer::getOverruns() const {
+    return overruns;
+}
@@ -4,31 +4,147 @@
  */
 
 #include "ServoController.h"
+#include "Messages.h"
 
 /**
- * Constructor - Lưu trữ thông tin chân điều khiển
+ * Constructor - Lưu trữ thông tin chân điều khiển và giới hạn chuyển động mặc định
  */
 ServoController::ServoController(int servo1Pin, int servo2Pin)
     : servo1Pin(servo1Pin), servo2Pin(servo2Pin) {
+    for (uint8_t i = 0; i < SERVO_COUNT; i++) {
+        commands[i].phase = SERVO_IDLE;
+        limits[i].maxSpeed = SERVO_DEFAULT_MAX_SPEED;
+        limits[i].maxAccel = SERVO_DEFAULT_MAX_ACCEL;
+        limits[i].profile = PROFILE_SCURVE;
+        currentAngle[i] = SERVO_ATTACH_ANGLE;
+    }
 }
 
 /**
  * Khởi tạo và kiểm tra servo motor
- * Bước 1: Gắn servo vào các chân PWM
- * Bước 2: Thực hiện chuỗi kiểm tra (90° -> 0°) để đảm bảo hoạt động bình thường
+ * Bước 1: Gắn servo vào các chân PWM (servo về 90° theo mặc định của thư viện)
+ * Bước 2: Lên lịch chuỗi kiểm tra (giữ 90° rồi về 0°) để đảm bảo hoạt động bình thường
+ * Chuyển động kiểm tra chạy nền qua update(), không chặn quá trình khởi động
  */
 void ServoController::init() {
     servo1.attach(servo1Pin);
     servo2.attach(servo2Pin);
     
-    // Kiểm tra hoạt động: chuyển động từ 90° về 0°
-    servo1.write(90);
-    servo2.write(90);
-    delay(1000);  // Chờ servo đến vị trí
-    servo1.write(0);
-    servo2.write(0);
+    // Kiểm tra hoạt động: giữ 90° trong 1 giây rồi chạy về 0°
+    unsigned long now = millis();
+    scheduleMove(SERVO_1, 90, now, 1000);
+    scheduleMove(SERVO_2, 90, now, 1000);
+    update();
     
-    Serial.println("Servos Initialized");
+    Serial.println(message(MSG_SERVO_READY));
+}
+
+/**
+ * Lên lịch chuyển động cho một servo
+ * Mỗi servo chỉ giữ một lệnh; lệnh mới bị từ chối cho tới khi lệnh cũ hoàn thành
+ */
+bool ServoController::scheduleMove(ServoId id, int angle, unsigned long startTime,
+                                   unsigned long holdMs, int returnAngle) {
+    ServoCommand& cmd = commands[id];
+    if (cmd.phase != SERVO_IDLE) {
+        return false;
+    }
+    cmd.targetAngle = angle;
+    cmd.returnAngle = returnAngle;
+    cmd.startTime = startTime;
+    cmd.holdTime = holdMs;
+    cmd.phase = SERVO_PENDING;
+    return true;
+}
+
+/**
+ * Thực thi lệnh của từng servo:
+ * PENDING -> MOVING_OUT (quỹ đạo tới góc đích) -> HOLDING (giữ holdTime)
+ *         -> MOVING_BACK (quỹ đạo về góc nghỉ) -> IDLE
+ * Mỗi giai đoạn bắt đầu đúng lúc giai đoạn trước kết thúc (không cộng dồn trễ của loop)
+ * So sánh bằng hiệu thời gian để an toàn khi millis() tràn số
+ */
+void ServoController::update() {
+    unsigned long now = millis();
+    for (uint8_t i = 0; i < SERVO_COUNT; i++) {
+        ServoCommand& cmd = commands[i];
+        ServoId id = (ServoId)i;
+        
+        if (cmd.phase == SERVO_PENDING && (long)(now - cmd.startTime) >= 0) {
+            beginMove(id, SERVO_MOVING_OUT, cmd.targetAngle, cmd.startTime);
+        }
+        if (cmd.phase == SERVO_MOVING_OUT && stepMove(id, cmd.targetAngle, now)) {
+            cmd.startTime += cmd.moveTime;
+            cmd.phase = SERVO_HOLDING;
+        }
+        if (cmd.phase == SERVO_HOLDING && now - cmd.startTime >= cmd.holdTime) {
+            beginMove(id, SERVO_MOVING_BACK, cmd.returnAngle, cmd.startTime + cmd.holdTime);
+        }
+        if (cmd.phase == SERVO_MOVING_BACK && stepMove(id, cmd.returnAngle, now)) {
+            cmd.phase = SERVO_IDLE;
+        }
+    }
+}
+
+/**
+ * Bắt đầu đoạn chuyển động: ghi nhớ góc xuất phát và tính thời gian theo giới hạn
+ */
+void ServoController::beginMove(ServoId id, ServoPhase phase, int toAngle, unsigned long startTime) {
+    ServoCommand& cmd = commands[id];
+    cmd.fromAngle = currentAngle[id];
+    cmd.moveTime = getMoveTime(id, cmd.fromAngle, toAngle);
+    cmd.startTime = startTime;
+    cmd.phase = phase;
+}
+
+/**
+ * Góc tại thời điểm now = góc xuất phát + quãng đường * vị trí chuẩn hóa trong bảng
+ */
+bool ServoController::stepMove(ServoId id, int toAngle, unsigned long now) {
+    const ServoCommand& cmd = commands[id];
+    unsigned long elapsed = now - cmd.startTime;
+    if (elapsed >= cmd.moveTime) {
+        writeAngle(id, toAngle);
+        return true;
+    }
+    uint16_t position = motionPosition(limits[id].profile, elapsed, cmd.moveTime);
+    long distance = (long)(toAngle - cmd.fromAngle);
+    writeAngle(id, cmd.fromAngle + (int)((distance * position) / 65535L));
+    return false;
+}
+
+/**
+ * Servo bận khi còn lệnh đang chờ, đang chạy hoặc đang giữ góc
+ */
+bool ServoController::isBusy(ServoId id) const {
+    return commands[id].phase != SERVO_IDLE;
+}
+
+/**
+ * Hủy lệnh của servo, servo giữ nguyên góc hiện tại
+ */
+void ServoController::cancel(ServoId id) {
+    commands[id].phase = SERVO_IDLE;
+}
+
+/**
+ * Cấu hình giới hạn chuyển động - ảnh hưởng tới các đoạn chuyển động bắt đầu sau đó
+ */
+void ServoController::setMotionLimits(ServoId id, uint16_t maxSpeed, uint16_t maxAccel,
+                                      MotionProfileType profile) {
+    limits[id].maxSpeed = maxSpeed;
+    limits[id].maxAccel = maxAccel;
+    limits[id].profile = profile;
+}
+
+/**
+ * Thời gian ngắn nhất để đi hết quãng đường mà không vượt vận tốc/gia tốc cho phép
+ */
+uint16_t ServoController::getMoveTime(ServoId id, int fromAngle, int toAngle) const {
+    int distance = toAngle - fromAngle;
+    if (distance < 0) distance = -distance;
+    return motionDurationMs((uint16_t)distance, limits[id].maxSpeed, limits[id].maxAccel,
+                            limits[id].profile);
 }
 
 /**
@@ -36,7 +152,8 @@ void ServoController::init() {
  * Sử dụng để đẩy sản phẩm vào ngăn tương ứng
  */
 void ServoController::setServo1Angle(int angle) {
-    servo1.write(angle);
+    cancel(SERVO_1);
+    writeAngle(SERVO_1, angle);
 }
 
 /**
@@ -44,7 +161,8 @@ void ServoController::setServo1Angle(int angle) {
  * Sử dụng để đẩy sản phẩm vào ngăn tương ứng
  */
 void ServoController::setServo2Angle(int angle) {
-    servo2.write(angle);
+    cancel(SERVO_2);
+    writeAngle(SERVO_2, angle);
 }
 
 /**
@@ -52,8 +170,8 @@ void ServoController::setServo2Angle(int angle) {
  * Hữu ích khi cần phối hợp chuyển động đồng bộ
  */
 void ServoController::setBothAngles(int angle1, int angle2) {
-    servo1.write(angle1);
-    servo2.write(angle2);
+    setServo1Angle(angle1);
+    setServo2Angle(angle2);
 }
 
 /**
@@ -61,6 +179,22 @@ void ServoController::setBothAngles(int angle1, int angle2) {
  * Sử dụng khi cần reset hệ thống hoặc kết thúc quy trình phân loại
  */
 void ServoController::resetPosition() {
-    servo1.write(0);
-    servo2.write(0);
+    setServo1Angle(0);
+    setServo2Angle(0);
+}
+
+/**
+ * Ghi góc cho servo theo định danh (không hủy lệnh - dùng nội bộ bởi update)
+ * Chỉ ghi khi góc thay đổi để không tốn thời gian cập nhật thanh ghi PWM mỗi vòng lặp
+ */
+void ServoController::writeAngle(ServoId id, int angle) {
+    if (angle == currentAngle[id]) {
+        return;
+    }
+    currentAngle[id] = angle;
+    if (id == SERVO_1) {
+        servo1.write(angle);
+    } else {
+        servo2.write(angle);
+    }
 }
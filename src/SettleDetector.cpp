@@ -0,0 +1,67 @@
+/**
+ * @file SettleDetector.cpp
+ * @brief Implementation của SettleDetector class
+ */
+
+#include "SettleDetector.h"
+
+/**
+ * Constructor - Chưa có mẫu nào
+ */
+SettleDetector::SettleDetector(int32_t tolerance)
+    : tolerance(tolerance),
+      runLength(SETTLE_MIN_RUN),
+      lo(0),
+      hi(0),
+      run(0) {
+}
+
+/**
+ * Xóa trạng thái - gọi khi phát hiện sản phẩm mới trên cân
+ */
+void SettleDetector::reset(uint8_t samples, int32_t newTolerance) {
+    runLength = (samples < SETTLE_MIN_RUN) ? SETTLE_MIN_RUN : samples;
+    tolerance = newTolerance;
+    run = 0;
+}
+
+/**
+ * Mẫu làm biên độ của đoạn vượt dung sai thì bắt đầu đoạn mới từ chính mẫu đó
+ * (spike cũng vậy: đoạn ổn định không bao giờ chứa spike)
+ */
+void SettleDetector::update(int32_t sample) {
+    if (run > 0) {
+        int32_t newLo = (sample < lo) ? sample : lo;
+        int32_t newHi = (sample > hi) ? sample : hi;
+        if (newHi - newLo <= tolerance) {
+            lo = newLo;
+            hi = newHi;
+            if (run < runLength) {
+                run++;
+            }
+            return;
+        }
+    }
+    lo = hi = sample;
+    run = 1;
+}
+
+/**
+ * Đã có đoạn ổn định đủ dài
+ */
+bool SettleDetector::isSettled() const {
+    return run >= runLength;
+}
+
+/**
+ * Độ tin cậy giảm tuyến tính theo biên độ của đoạn
+ */
+uint8_t SettleDetector::getConfidence() const {
+    if (!isSettled()) {
+        return 0;
+    }
+    if (tolerance <= 0) {
+        return 100;
+    }
+    return (uint8_t)(100 - ((hi - lo) * 50) / tolerance);
+}
@@ -4,191 +4,211 @@
  */
 
 #include "SystemController.h"
+#include "Messages.h"
 
 /**
- * Constructor - Khởi tạo và liên kết các module con
- * Thiết lập ngưỡng trọng lượng và cảm biến IR
+ * Constructor - Lưu các làn và liên kết các module dùng chung
  */
-SystemController::SystemController(LoadCellManager* loadCell, ServoController* servoController, DisplayManager* display,
-                                   int irSensorPin, int irCountPin, float weightMin, float weightMax)
-    : loadCell(loadCell), 
-      servoController(servoController), 
+SystemController::SystemController(LaneController* const lanes[], uint8_t laneCount, DisplayManager* display,
+                                   Telemetry* telemetry, MultiLoadCell* sharedClock,
+                                   PersistentStore* store)
+    : laneCount(laneCount > MAX_LANES ? MAX_LANES : laneCount),
       display(display),
-      irSensorPin(irSensorPin),
-      irCountPin(irCountPin),
-      weightMin(weightMin),
-      weightMax(weightMax),
-      passCount(0),
-      rejectCount(0),
-      currentState(STATE_IDLE),
-      lastIRCountState(HIGH) {
+      telemetry(telemetry),
+      captureLane(0),
+      gradeLane(0),
+      statsStep(0),
+      sharedClock(sharedClock),
+      store(store),
+      persistLane(0),
+      lastPersist(0) {
+    for (uint8_t i = 0; i < this->laneCount; i++) {
+        this->lanes[i] = lanes[i];
+    }
+    captureLane = this->laneCount;
+    gradeLane = this->laneCount;
+    statsStep = 2 * this->laneCount;
 }
 
 /**
  * Khởi tạo tất cả các thành phần của hệ thống theo thứ tự:
- * 1. Serial Communication (9600 baud) - để debug và giám sát
- * 2. LoadCell - cảm biến đo trọng lượng
- * 3. Servo - cơ cấu phân loại
- * 4. Display - màn hình hiển thị
- * 5. IR Sensors - cảm biến phát hiện và đếm sản phẩm
+ * 1. Telemetry (Serial, baud cấu hình trong main.cpp) - để debug và giám sát
+ * 2. Từng làn: IR Sensors, LoadCell (tare, hoặc điểm 0 lưu trong EEPROM), Servo
+ * 3. Display - màn hình hiển thị, chia ô theo số làn
+ * Lượt lưu EEPROM đầu tiên bắt đầu ngay để ghi lại điểm 0 vừa tare
  */
 void SystemController::init() {
-    Serial.begin(9600);
-    Serial.println("Serial Initialized");
-    
-    // Cấu hình cảm biến IR
-    pinMode(irSensorPin, INPUT);
-    pinMode(irCountPin, INPUT);
-    Serial.println("IR Sensors Initialized");
-    
-    loadCell->init();
-    loadCell->tare();  // Zero out the scale when empty
+    // Tô vùng trống trước khi khởi tạo để đo được cả stack lúc init
+    MemoryMonitor::paintStack();
+    telemetry->begin();
+    Serial.println(message(MSG_SERIAL_READY));
     
-    servoController->init();
-    servoController->resetPosition();  // Đưa servo về vị trí ban đầu
+    if (store != nullptr) {
+        store->begin();
+    }
+    for (uint8_t i = 0; i < laneCount; i++) {
+        LaneSnapshot saved;
+        bool warm = store != nullptr && store->load(i, saved);
+        lanes[i]->init(i, warm ? &saved : nullptr);
+    }
+    persistLane = 0;
+    lastPersist = millis();
     
+    display->setLaneCount(laneCount);
     display->init();
     
-    Serial.println("=================================");
-    Serial.println("HE THONG PHAN LOAI SAN PHAM");
-    Serial.println("Nguong: 50g - 200g");
-    Serial.println("=================================");
-    Serial.println("Setup Complete - Ready!");
+    Serial.println(message(MSG_BANNER_RULE));
+    Serial.println(message(MSG_BANNER_TITLE));
+    for (uint8_t i = 0; i < laneCount; i++) {
+        lanes[i]->printGrades();
+    }
+    Serial.print(message(MSG_BANNER_LANES));
+    Serial.println(laneCount);
+    Serial.println(message(MSG_BANNER_RULE));
+    Serial.println(message(MSG_SETUP_DONE));
 }
 
 /**
- * Thực thi chu trình chính của hệ thống
- * Quy trình:
- * 1. Kiểm tra cảm biến IR để phát hiện sản phẩm đến
- * 2. Đọc trọng lượng từ cảm biến
- * 3. Phân loại: PASS hoặc REJECT
- * 4. Điều khiển servo gạt nếu sản phẩm lỗi
- * 5. Đếm sản phẩm đạt chuẩn từ cảm biến cuối băng chuyền
+ * Thực thi một bước của hệ thống (non-blocking)
+ * Mỗi làn chạy một bước máy trạng thái của nó (xem LaneController::run),
+ * màn hình dùng chung được cập nhật một lần sau tất cả các làn
+ * SCK chung không có ngắt: đọc ở mỗi vòng lặp thay cho ISR, nếu không thì khi mọi làn
+ * đang đẩy/chờ rời cân sẽ không có mẫu nào và bộ lọc nhận lại giá trị cũ
+ * Cuối mỗi vòng lặp ghi tối đa một byte trạng thái vào EEPROM (persistState)
  */
 void SystemController::run() {
-    // Kiểm tra cảm biến đếm sản phẩm đạt chuẩn (chạy liên tục)
-    checkPassCounter();
+    PROFILE_LOOP();
     
-    // Đọc trọng lượng liên tục
-    float weight = loadCell->getWeight(5);
+    // Lệnh từ Serial và xuất dần kết quả profiler (nếu được bật)
+    serviceCommands();
     
-    // Nếu trọng lượng < 10g thì coi như nhiễu, chưa có sản phẩm
-    if (weight < 10.0) {
-        return;  // Chưa có sản phẩm, tiếp tục vòng lặp
+    if (sharedClock != nullptr) {
+        sharedClock->poll();
     }
     
-    // ========== CÓ SẢN PHẨM TRÊN CÂN ==========
-    Serial.println("\n>>> San pham tren can!");
-    delay(200);  // Chờ ổn định
-    
-    // Đọc lại trọng lượng chính xác
-    weight = loadCell->getWeight(5);
-    
-    Serial.print("Trong luong: ");
-    Serial.print(weight, 1);
-    Serial.print(" g -> ");
-    
-    // Kiểm tra đạt chuẩn
-    bool isValid = isProductValid(weight);
-    
-    // Hiển thị lên LCD
-    display->displayWeight(weight);
-    
-    // ========== SERVO 1: LUÔN GẠT 180° ĐỂ ĐẨY SẢN PHẨM LÊN BĂNG CHUYỀN ==========
-    // Servo 1 đặt bên phải cân, gạt sang 180° để đẩy sản phẩm
-    servoController->setServo1Angle(180);
-    
-    if (isValid) {
-        // ========== SẢN PHẨM ĐẠT CHUẨN (50g - 200g) ==========
-        Serial.println("DAT CHUAN!");
-        passCount++;
-        
-        // Servo 2: KHÔNG LÀM GÌ - sản phẩm đi thẳng trên băng chuyền
-        // Sản phẩm sẽ đi tới cuối băng chuyền bình thường
-        
-        delay(500);  // Chờ servo 1 hoàn thành gạt
-        servoController->setServo1Angle(0);  // Đưa servo 1 về vị trí ban đầu
-        
-    } else {
-        // ========== SẢN PHẨM KHÔNG ĐẠT CHUẨN (<50g hoặc >200g) ==========
-        if (weight < weightMin) {
-            Serial.println("LOAI - Qua nhe!");
-        } else {
-            Serial.println("LOAI - Qua nang!");
-        }
-        rejectCount++;
-        
-        delay(500);  // Chờ servo 1 hoàn thành gạt
-        servoController->setServo1Angle(0);  // Đưa servo 1 về vị trí ban đầu
-        
-        // Delay chờ sản phẩm di chuyển từ cân tới vị trí servo 2 trên băng chuyền
-        // (Thời gian này cần điều chỉnh theo tốc độ băng chuyền thực tế)
-        delay(1500);  // <-- ĐIỀU CHỈNH THỜI GIAN NÀY THEO TỐC ĐỘ BĂNG CHUYỀN
-        
-        // Servo 2: Gạt 145° để đẩy sản phẩm lỗi ra ngoài băng chuyền
-        servoController->setServo2Angle(145);
-        delay(500);  // Chờ servo 2 gạt xong
-        
-        // Đưa servo 2 về vị trí ban đầu
-        servoController->setServo2Angle(0);
+    for (uint8_t i = 0; i < laneCount; i++) {
+        lanes[i]->run();
     }
     
-    // Hiển thị thống kê
-    Serial.print("Thong ke: PASS=");
-    Serial.print(passCount);
-    Serial.print(" | REJECT=");
-    Serial.println(rejectCount);
+    persistState();
     
-    // Chờ sản phẩm rời khỏi cân hoàn toàn
-    delay(500);
+    {
+        PROFILE_SCOPE(PROF_DISPLAY);
+        // Gửi dần các ô LCD thay đổi (giới hạn thời gian mỗi vòng lặp)
+        display->update();
+    }
 }
 
 /**
- * Kiểm tra sản phẩm có đạt chuẩn không
- * Đạt chuẩn: trọng lượng nằm trong khoảng [weightMin, weightMax]
+ * Lệnh một ký tự qua Serial:
+ * - "c": ghi mẫu thô HX711 (phát lại bằng env:native --replay); mỗi lần gửi chuyển
+ *   sang làn kế tiếp, sau làn cuối thì tắt (chỉ ghi một làn một lúc)
+ * - "p": xuất thống kê profiler, mỗi vòng lặp một giai đoạn để không chặn Serial
+ * - "r": xóa thống kê profiler
+ * - "m": ảnh chụp RAM (static, heap, free, stack sâu nhất - xem MemoryMonitor.h)
+ * - "z": tare lại các làn đang rỗng (chặn ~1 s mỗi làn) rồi lưu điểm 0 mới
+ * - "g": bộ đếm từng hạng, mỗi vòng lặp một làn (chờ nếu bộ đệm TX chưa đủ chỗ)
+ * - "s": thống kê quá trình rồi biểu đồ tần suất của từng làn, mỗi vòng lặp một khung
+ * - "b": xóa thống kê quá trình, lấy lại trung bình gốc (sau khi đổi sản phẩm/chỉnh máy)
+ * Khi biên dịch không có PROFILER_ENABLED các lệnh profiler bị bỏ qua
  */
-bool SystemController::isProductValid(float weight) {
-    return (weight >= weightMin && weight <= weightMax);
+void SystemController::serviceCommands() {
+    int command = telemetry->readCommand();
+    if (command == 'c') {
+        if (captureLane < laneCount) {
+            lanes[captureLane]->setCapture(nullptr);
+        }
+        captureLane = (captureLane < laneCount) ? captureLane + 1 : 0;
+        if (captureLane < laneCount) {
+            lanes[captureLane]->setCapture(telemetry);
+        }
+    } else if (command == 'm') {
+        MemoryStats stats;
+        MemoryMonitor::snapshot(stats);
+        telemetry->logMemory(stats);
+    } else if (command == 'z') {
+        for (uint8_t i = 0; i < laneCount; i++) {
+            lanes[i]->tare();
+        }
+        persistLane = 0;
+        lastPersist = millis();
+    } else if (command == 'g') {
+        gradeLane = 0;
+    } else if (command == 's') {
+        statsStep = 0;
+    } else if (command == 'b') {
+        for (uint8_t i = 0; i < laneCount; i++) {
+            lanes[i]->resetStats();
+        }
+    }
+    if (gradeLane < laneCount && telemetry->logGrades(gradeLane, lanes[gradeLane]->getGrades())) {
+        gradeLane++;
+    }
+    if (statsStep < 2 * laneCount && lanes[statsStep / 2]->reportStats(statsStep & 1)) {
+        statsStep++;
+    }
+#ifdef PROFILER_ENABLED
+    if (command == 'p') {
+        profiler.requestDump();
+    } else if (command == 'r') {
+        profiler.reset();
+    }
+    
+    ProfileStage stage;
+    if (profiler.nextDump(stage)) {
+        ProfileStats stats;
+        profiler.snapshot(stage, stats);
+        if (!telemetry->logProfile(stage, stats)) {
+            profiler.retryDump();
+        }
+    }
+#endif
 }
 
 /**
- * Kiểm tra cảm biến IR cuối băng chuyền để xác nhận sản phẩm đã đi qua
- * Phát hiện cạnh xuống (HIGH -> LOW) để phát hiện mỗi sản phẩm
- * Lưu ý: passCount đã được đếm tại cân, đây chỉ để xác nhận
+ * Lưu trạng thái các làn không chặn: mỗi lượt (PERSIST_INTERVAL_MS) lần lượt chuẩn bị
+ * bản ghi của từng làn khi EEPROM rảnh; PersistentStore ghi một byte mỗi vòng lặp và
+ * bỏ qua làn không có gì thay đổi
  */
-void SystemController::checkPassCounter() {
-    bool currentIRState = digitalRead(irCountPin);
-    
-    // Phát hiện cạnh xuống (sản phẩm vừa đi qua cảm biến)
-    if (lastIRCountState == HIGH && currentIRState == LOW) {
-        // Chỉ log ra Serial để xác nhận, không đếm lại
-        Serial.println(">>> San pham di qua cuoi bang chuyen!");
+void SystemController::persistState() {
+    if (store == nullptr) {
+        return;
     }
-    
-    lastIRCountState = currentIRState;
+    store->service();
+    if (store->isBusy()) {
+        return;
+    }
+    if (persistLane >= laneCount) {
+        if (millis() - lastPersist < PERSIST_INTERVAL_MS) {
+            return;
+        }
+        persistLane = 0;
+        lastPersist = millis();
+    }
+    LaneSnapshot snapshot;
+    lanes[persistLane]->saveState(snapshot);
+    store->save(persistLane, snapshot);
+    persistLane++;
 }
 
 /**
- * Lấy số sản phẩm đạt chuẩn
+ * Lấy tổng số sản phẩm đạt chuẩn
  */
 int SystemController::getPassCount() {
-    return passCount;
+    int total = 0;
+    for (uint8_t i = 0; i < laneCount; i++) {
+        total += lanes[i]->getPassCount();
+    }
+    return total;
 }
 
 /**
- * Lấy số sản phẩm bị loại
+ * Lấy tổng số sản phẩm bị loại
  */
 int SystemController::getRejectCount() {
-    return rejectCount;
-}
-
-/**
- * Xử lý logic phân loại (legacy - giữ để tương thích)
- */
-void SystemController::processWeight(float weight) {
-    if (isProductValid(weight)) {
-        servoController->setServo1Angle(0);   // Đạt chuẩn - cho đi qua
-    } else {
-        servoController->setServo1Angle(90);  // Loại - gạt bỏ
+    int total = 0;
+    for (uint8_t i = 0; i < laneCount; i++) {
+        total += lanes[i]->getRejectCount();
     }
+    return total;
 }
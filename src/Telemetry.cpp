@@ -0,0 +1,655 @@
+/**
+ * @file Telemetry.cpp
+ * @brief Implementation của Telemetry class
+ */
+
+#include "Telemetry.h"
+#include "Messages.h"
+
+static_assert(7 + 2 * SPC_HIST_BINS <= TELEMETRY_MAX_PAYLOAD, "FRAME_HISTOGRAM vuot qua mot khung");
+
+/**
+ * Constructor - Chỉ lưu cấu hình, cổng Serial được mở trong begin()
+ */
+Telemetry::Telemetry(HardwareSerial& port, unsigned long baud, TelemetryMode mode)
+    : port(port), baud(baud), mode(mode), length(0), droppedFrames(0),
+      captureLength(0), captureSeq(0), captureTime(0), captureRaw(0),
+      captureTare(0), captureScaleQ8(0), captureStartPending(false), captureZeroPending(false) {
+}
+
+/**
+ * Mở cổng Serial với tốc độ đã cấu hình
+ */
+void Telemetry::begin() {
+    port.begin(baud);
+}
+
+/**
+ * Chế độ xuất hiện tại
+ */
+TelemetryMode Telemetry::getMode() const {
+    return mode;
+}
+
+/**
+ * Đổi chế độ xuất (ví dụ chuyển sang chữ khi debug trên bàn thử)
+ */
+void Telemetry::setMode(TelemetryMode newMode) {
+    mode = newMode;
+}
+
+/**
+ * Có sản phẩm trên cân - chế độ nhị phân đã có thời điểm này qua settleMs
+ */
+void Telemetry::logArrival(uint8_t lane) {
+    PROFILE_SCOPE(PROF_SERIAL);
+    if (mode == TELEMETRY_TEXT) {
+        port.print(message(MSG_ARRIVAL_PREFIX));
+        port.print(lane + 1);
+        port.println(message(MSG_ARRIVAL_SUFFIX));
+    }
+}
+
+/**
+ * Kết quả một sản phẩm
+ * - Chữ: các dòng giống log cũ (trọng lượng, tên hạng, thống kê); bảng 3 hạng
+ *   quá nhẹ/đạt/quá nặng dùng đúng các chuỗi kết luận cũ làm tên hạng
+ * - Nhị phân: một khung FRAME_PRODUCT 28 byte payload (làn, hạng, độ trôi điểm 0 ở cuối)
+ */
+void Telemetry::logProduct(const ProductRecord& record, float grams, MessageId gradeName) {
+    PROFILE_SCOPE(PROF_SERIAL);
+    if (mode == TELEMETRY_TEXT) {
+        port.print(message(MSG_PRODUCT_PREFIX));
+        port.print(record.lane + 1);
+        port.print(message(MSG_PRODUCT_WEIGHT));
+        port.print(grams, 1);
+        port.print(message(MSG_PRODUCT_CONFIDENCE));
+        port.print(record.confidence);
+        port.print(message(MSG_PRODUCT_VERDICT));
+        port.println(message(gradeName));
+        port.print(message(MSG_STATS_PASS));
+        port.print(record.passCount);
+        port.print(message(MSG_STATS_REJECT));
+        port.println(record.rejectCount);
+        port.print(message(MSG_SAMPLING_MEDIAN));
+        port.print(record.medianWindow);
+        port.print(message(MSG_LIST_SEPARATOR));
+        port.print(record.sampleRate);
+        port.print(message(MSG_SAMPLING_SPS));
+        port.print(record.noiseCounts);
+        port.print(message(MSG_SAMPLING_ZERO_DRIFT));
+        port.print(record.zeroDrift);
+        port.println(message(MSG_SAMPLING_COUNT));
+        return;
+    }
+    
+    beginFrame(FRAME_PRODUCT);
+    put32(record.timestamp);
+    put32((uint32_t)record.rawWeight);
+    put8(record.verdict);
+    put8(record.confidence);
+    put16(record.passCount);
+    put16(record.rejectCount);
+    put16(record.settleMs);
+    put16(record.pushMs);
+    put16(record.inFlight);
+    put8(record.medianWindow);
+    put8(record.sampleRate);
+    put16(record.noiseCounts);
+    put8(record.lane);
+    put8(record.grade);
+    put16((uint16_t)record.zeroDrift);
+    endFrame();
+}
+
+/**
+ * Sự kiện cảm biến cuối băng chuyền
+ * - Chữ: dòng thông báo, kèm thời gian đo được nếu ghép được sản phẩm
+ * - Nhị phân: FRAME_PASS_COUNT 9 byte: thời điểm, làn, thời gian đẩy -> cuối, tới servo 2
+ */
+void Telemetry::logPassCount(uint32_t timestamp, uint8_t lane, uint16_t exitMs, uint16_t transitMs) {
+    PROFILE_SCOPE(PROF_SERIAL);
+    if (mode == TELEMETRY_TEXT) {
+        port.print(message(MSG_PASS_PREFIX));
+        port.print(lane + 1);
+        port.print(message(MSG_PASS_SUFFIX));
+        if (exitMs != 0) {
+            port.print(message(MSG_PASS_EXIT));
+            port.print(exitMs);
+            port.print(message(MSG_PASS_TRANSIT));
+            port.print(transitMs);
+            port.print(message(MSG_PASS_END));
+        }
+        port.println();
+        return;
+    }
+    beginFrame(FRAME_PASS_COUNT);
+    put32(timestamp);
+    put8(lane);
+    put16(exitMs);
+    put16(transitMs);
+    endFrame();
+}
+
+/**
+ * Sự kiện điểm 0
+ * - Chữ: "[Lan 1] LoadCell: <sự kiện> X g"
+ * - Nhị phân: FRAME_ZERO 10 byte: thời điểm, làn, sự kiện, giá trị (count)
+ */
+bool Telemetry::logZero(uint32_t timestamp, uint8_t lane, uint8_t event, int32_t counts, float grams) {
+    PROFILE_SCOPE(PROF_SERIAL);
+    if (mode == TELEMETRY_TEXT) {
+        port.print(message(MSG_PRODUCT_PREFIX));
+        port.print(lane + 1);
+        if (event == ZERO_EVENT_TARE_NO_DATA) {
+            port.println(message(MSG_ZERO_TARE_NO_DATA));
+            return true;
+        }
+        port.print(message(event == ZERO_EVENT_TRACK_LIMIT ? MSG_ZERO_TRACK_LIMIT : MSG_ZERO_RESTORE_FALLBACK));
+        port.print(grams, 1);
+        port.println(message(MSG_ZERO_GRAMS));
+        return true;
+    }
+    
+    if (port.availableForWrite() < 4 + 10) {
+        return false;
+    }
+    beginFrame(FRAME_ZERO);
+    put32(timestamp);
+    put8(lane);
+    put8(event);
+    put32((uint32_t)counts);
+    return endFrame();
+}
+
+/**
+ * Sự kiện của làn
+ * - Chữ: "[Lan N] <thông báo>"
+ * - Nhị phân: FRAME_EVENT 6 byte payload: timestamp, lane, event
+ */
+bool Telemetry::logEvent(uint32_t timestamp, uint8_t lane, uint8_t event) {
+    PROFILE_SCOPE(PROF_SERIAL);
+    if (mode == TELEMETRY_TEXT) {
+        port.print(message(MSG_PRODUCT_PREFIX));
+        port.print(lane + 1);
+        port.println(message(event == LANE_EVENT_GRADE_UNSORTED ? MSG_EVENT_GRADE_UNSORTED : MSG_UNKNOWN));
+        return true;
+    }
+    
+    if (port.availableForWrite() < 4 + 6) {
+        return false;
+    }
+    beginFrame(FRAME_EVENT);
+    put32(timestamp);
+    put8(lane);
+    put8(event);
+    return endFrame();
+}
+
+/**
+ * Thống kê một giai đoạn
+ * - Chữ: "PROF <tên> n=.. min=.. mean=.. max=.. us hist=b0,b1,..."
+ *   (giai đoạn loop thêm tần số vòng lặp và độ rung)
+ * - Nhị phân: FRAME_PROFILE 27 byte payload: stage, count, min, max, mean, histogram
+ */
+bool Telemetry::logProfile(ProfileStage stage, const ProfileStats& stats) {
+#ifdef PROFILER_ENABLED
+    uint16_t mean = Profiler::mean(stats);
+    
+    if (mode == TELEMETRY_TEXT) {
+        port.print(message(MSG_PROF_PREFIX));
+        port.print(Profiler::stageName(stage));
+        port.print(message(MSG_PROF_COUNT));
+        port.print(stats.count);
+        port.print(message(MSG_PROF_MIN));
+        port.print(stats.count ? stats.minUs : 0);
+        port.print(message(MSG_PROF_MEAN));
+        port.print(mean);
+        port.print(message(MSG_PROF_MAX));
+        port.print(stats.maxUs);
+        port.print(message(MSG_PROF_US));
+        if (stage == PROF_LOOP && mean > 0) {
+            port.print(message(MSG_PROF_RATE));
+            port.print(1000000UL / mean);
+            port.print(message(MSG_PROF_JITTER));
+            port.print(stats.count ? stats.maxUs - stats.minUs : 0);
+            port.print(message(MSG_PROF_JITTER_UNIT));
+        }
+        port.print(message(MSG_PROF_HIST));
+        for (uint8_t i = 0; i < PROFILER_BUCKETS; i++) {
+            if (i > 0) {
+                port.print(',');
+            }
+            port.print(stats.histogram[i]);
+        }
+        port.println();
+        return true;
+    }
+    
+    // Khung 31 byte: chỉ bắt đầu khi đủ chỗ để không tính vào droppedFrames
+    if (port.availableForWrite() < 4 + 11 + PROFILER_BUCKETS) {
+        return false;
+    }
+    beginFrame(FRAME_PROFILE);
+    put8(stage);
+    put32(stats.count);
+    put16(stats.count ? stats.minUs : 0);
+    put16(stats.maxUs);
+    put16(mean);
+    for (uint8_t i = 0; i < PROFILER_BUCKETS; i++) {
+        put8(stats.histogram[i]);
+    }
+    return endFrame();
+#else
+    (void)stage;
+    (void)stats;
+    return true;
+#endif
+}
+
+/**
+ * Ảnh chụp RAM
+ * - Chữ: "MEM static=.. heap=.. free=.. free_min=.. stack_max=.."
+ * - Nhị phân: FRAME_MEMORY 10 byte payload theo thứ tự của MemoryStats
+ */
+void Telemetry::logMemory(const MemoryStats& stats) {
+    PROFILE_SCOPE(PROF_SERIAL);
+    if (mode == TELEMETRY_TEXT) {
+        port.print(message(MSG_MEM_PREFIX));
+        port.print(stats.staticBytes);
+        port.print(message(MSG_MEM_HEAP));
+        port.print(stats.heapBytes);
+        port.print(message(MSG_MEM_FREE));
+        port.print(stats.freeBytes);
+        port.print(message(MSG_MEM_FREE_MIN));
+        port.print(stats.minFreeBytes);
+        port.print(message(MSG_MEM_STACK_MAX));
+        port.println(stats.stackMaxBytes);
+        return;
+    }
+    beginFrame(FRAME_MEMORY);
+    put16(stats.staticBytes);
+    put16(stats.heapBytes);
+    put16(stats.freeBytes);
+    put16(stats.minFreeBytes);
+    put16(stats.stackMaxBytes);
+    endFrame();
+}
+
+/**
+ * Bộ đếm từng hạng
+ * - Chữ: "[Lan 1] Theo hang: <tên>: n | <tên>: n | ..."
+ * - Nhị phân: FRAME_GRADES: làn, số hạng, rồi mỗi hạng 2 byte (tối đa 14 byte payload)
+ */
+bool Telemetry::logGrades(uint8_t lane, const GradeEngine& grades) {
+    PROFILE_SCOPE(PROF_SERIAL);
+    uint8_t count = grades.getGradeCount();
+    if (mode == TELEMETRY_TEXT) {
+        port.print(message(MSG_PRODUCT_PREFIX));
+        port.print(lane + 1);
+        port.print(message(MSG_GRADES_PREFIX));
+        for (uint8_t grade = 0; grade < count; grade++) {
+            if (grade > 0) {
+                port.print(message(MSG_GRADES_SEPARATOR));
+            }
+            port.print(message(grades.getName(grade)));
+            port.print(message(MSG_BANNER_GRADE_NAME));
+            port.print(grades.getCount(grade));
+        }
+        port.println();
+        return true;
+    }
+    
+    if (port.availableForWrite() < 4 + 2 + 2 * count) {
+        return false;
+    }
+    beginFrame(FRAME_GRADES);
+    put8(lane);
+    put8(count);
+    for (uint8_t grade = 0; grade < count; grade++) {
+        put16(grades.getCount(grade));
+    }
+    return endFrame();
+}
+
+/**
+ * Thống kê quá trình
+ * - Chữ: "[Lan 1] SPC n=.. tb=.. g sd=.. g | .. sp/phut | goc .. +/- .. g | EWMA .. g |
+ *   CUSUM +..% -..% | canh bao .." kèm " | TROI: .." khi có cảnh báo đang bật
+ * - Nhị phân: FRAME_STATS 28 byte: làn, cờ, n, trung bình, sd, μ0, σ0, EWMA (count),
+ *   CUSUM trên/dưới (% của H), nhịp (sp/phút), số lần cảnh báo
+ */
+bool Telemetry::logStats(uint8_t lane, const ProcessStats& stats, float gramsPerCount, unsigned long now) {
+    PROFILE_SCOPE(PROF_SERIAL);
+    uint8_t flags = stats.getFlags();
+    if (mode == TELEMETRY_TEXT) {
+        port.print(message(MSG_PRODUCT_PREFIX));
+        port.print(lane + 1);
+        port.print(message(MSG_SPC_PREFIX));
+        port.print(stats.getCount());
+        port.print(message(MSG_SPC_MEAN));
+        port.print(stats.getMean() * gramsPerCount, 1);
+        port.print(message(MSG_SPC_SD));
+        port.print(stats.getStdDev() * gramsPerCount, 1);
+        port.print(message(MSG_SPC_RATE));
+        port.print(stats.getRatePerMinute(now));
+        port.print(message(MSG_SPC_RATE_UNIT));
+        if ((flags & SPC_BASELINE) == 0) {
+            port.println(message(MSG_SPC_NO_BASELINE));
+            return true;
+        }
+        port.print(message(MSG_SPC_BASELINE));
+        port.print(stats.getRefMean() * gramsPerCount, 1);
+        port.print(message(MSG_SPC_PLUS_MINUS));
+        port.print(stats.getRefSigma() * gramsPerCount, 1);
+        port.print(message(MSG_SPC_EWMA));
+        port.print(stats.getEwma() * gramsPerCount, 1);
+        port.print(message(MSG_SPC_CUSUM));
+        port.print(stats.getCusumPercent(true));
+        port.print(message(MSG_SPC_CUSUM_MINUS));
+        port.print(stats.getCusumPercent(false));
+        port.print(message(MSG_SPC_ALARMS));
+        port.print(stats.getAlarmCount());
+        if (flags & SPC_ALARMS) {
+            port.print(message(MSG_SPC_DRIFT));
+            if (flags & SPC_CUSUM_HIGH) {
+                port.print(message(MSG_SPC_FLAG_CUSUM_HIGH));
+            }
+            if (flags & SPC_CUSUM_LOW) {
+                port.print(message(MSG_SPC_FLAG_CUSUM_LOW));
+            }
+            if (flags & SPC_EWMA_HIGH) {
+                port.print(message(MSG_SPC_FLAG_EWMA_HIGH));
+            }
+            if (flags & SPC_EWMA_LOW) {
+                port.print(message(MSG_SPC_FLAG_EWMA_LOW));
+            }
+        }
+        port.println();
+        return true;
+    }
+    
+    if (port.availableForWrite() < 4 + 28) {
+        return false;
+    }
+    beginFrame(FRAME_STATS);
+    put8(lane);
+    put8(flags);
+    put32(stats.getCount());
+    put32((uint32_t)stats.getMean());
+    put16(stats.getStdDev());
+    put32((uint32_t)stats.getRefMean());
+    put16((uint16_t)stats.getRefSigma());
+    put32((uint32_t)stats.getEwma());
+    put8(stats.getCusumPercent(true));
+    put8(stats.getCusumPercent(false));
+    put16(stats.getRatePerMinute(now));
+    put16(stats.getAlarmCount());
+    return endFrame();
+}
+
+/**
+ * Biểu đồ tần suất
+ * - Chữ: "[Lan 1] Bieu do tu <cận> g, moi o <rộng> g: <dưới dải> <ô 1> .. <trên dải>"
+ * - Nhị phân: FRAME_HISTOGRAM 31 byte: làn, cận dưới ô 1 (count), độ rộng ô (count,
+ *   bão hòa ở 65535), rồi mỗi ô 2 byte
+ */
+bool Telemetry::logHistogram(uint8_t lane, const ProcessStats& stats, float gramsPerCount) {
+    PROFILE_SCOPE(PROF_SERIAL);
+    if (mode == TELEMETRY_TEXT) {
+        port.print(message(MSG_PRODUCT_PREFIX));
+        port.print(lane + 1);
+        port.print(message(MSG_SPC_HIST_PREFIX));
+        port.print(stats.getHistLow() * gramsPerCount, 1);
+        port.print(message(MSG_SPC_HIST_WIDTH));
+        port.print(stats.getHistWidth() * gramsPerCount, 1);
+        port.print(message(MSG_SPC_HIST_BINS));
+        for (uint8_t bin = 0; bin < SPC_HIST_BINS; bin++) {
+            port.print(' ');
+            port.print(stats.getBin(bin));
+        }
+        port.println();
+        return true;
+    }
+    
+    if (port.availableForWrite() < 4 + 7 + 2 * SPC_HIST_BINS) {
+        return false;
+    }
+    int32_t width = stats.getHistWidth();
+    beginFrame(FRAME_HISTOGRAM);
+    put8(lane);
+    put32((uint32_t)stats.getHistLow());
+    put16(width > 0xFFFF ? 0xFFFF : (uint16_t)width);
+    for (uint8_t bin = 0; bin < SPC_HIST_BINS; bin++) {
+        put16(stats.getBin(bin));
+    }
+    return endFrame();
+}
+
+/**
+ * Bắt đầu một đoạn ghi mẫu thô
+ * - Chữ: dòng chú thích "# tare=..,cpg_q8=.." (các công cụ đọc CSV bỏ qua)
+ * - Nhị phân: gửi nốt khối cũ rồi FRAME_CAPTURE_START 12 byte payload
+ *   (timestamp, tare, hệ số Q8)
+ */
+void Telemetry::beginCapture(uint32_t timestamp, int32_t tareOffset, int32_t countsPerGramQ8) {
+    PROFILE_SCOPE(PROF_SERIAL);
+    if (mode == TELEMETRY_TEXT) {
+        port.print(message(MSG_CAPTURE_TARE));
+        port.print(tareOffset);
+        port.print(message(MSG_CAPTURE_SCALE));
+        port.println(countsPerGramQ8);
+        return;
+    }
+    flushCapture();
+    captureTime = timestamp;
+    captureTare = tareOffset;
+    captureScaleQ8 = countsPerGramQ8;
+    captureStartPending = true;
+    captureZeroPending = false;
+    sendCaptureStart();
+}
+
+/**
+ * Điểm 0 mới giữa đoạn ghi
+ * - Chữ: dòng chú thích "# zero=.."
+ * - Nhị phân: gửi nốt khối cũ rồi FRAME_CAPTURE_ZERO 8 byte payload (timestamp, tare)
+ * Không phải đầu đoạn ghi mới: hệ số không đổi, bộ lọc của firmware không bị xóa
+ */
+void Telemetry::logCaptureZero(uint32_t timestamp, int32_t tareOffset) {
+    PROFILE_SCOPE(PROF_SERIAL);
+    if (mode == TELEMETRY_TEXT) {
+        port.print(message(MSG_CAPTURE_ZERO));
+        port.println(tareOffset);
+        return;
+    }
+    flushCapture();
+    captureTime = timestamp;
+    captureTare = tareOffset;
+    if (captureStartPending) {
+        return;  // Đầu đoạn ghi chưa gửi sẽ mang điểm 0 mới
+    }
+    captureZeroPending = true;
+    sendCaptureZero();
+}
+
+/**
+ * Gửi thông tin đầu đoạn ghi khi bộ đệm TX đủ chỗ, không tính vào droppedFrames
+ */
+void Telemetry::sendCaptureStart() {
+    if (port.availableForWrite() < 4 + 12) {
+        return;
+    }
+    beginFrame(FRAME_CAPTURE_START);
+    put32(captureTime);
+    put32((uint32_t)captureTare);
+    put32((uint32_t)captureScaleQ8);
+    captureStartPending = !endFrame();
+}
+
+/**
+ * Gửi điểm 0 mới khi bộ đệm TX đủ chỗ, không tính vào droppedFrames
+ */
+void Telemetry::sendCaptureZero() {
+    if (port.availableForWrite() < 4 + 8) {
+        return;
+    }
+    beginFrame(FRAME_CAPTURE_ZERO);
+    put32(captureTime);
+    put32((uint32_t)captureTare);
+    captureZeroPending = !endFrame();
+}
+
+/**
+ * Ghi một mẫu thô
+ * Mẫu đầu khối ghi đầy đủ, các mẫu sau chỉ ghi chênh lệch thời gian và giá trị
+ * (zigzag để số âm nhỏ cũng chỉ tốn 1 byte). Khối không đủ chỗ cho mẫu dài nhất
+ * thì gửi đi và bắt đầu khối mới.
+ */
+void Telemetry::logSample(uint32_t timestamp, int32_t raw) {
+    PROFILE_SCOPE(PROF_SERIAL);
+    if (mode == TELEMETRY_TEXT) {
+        port.print(timestamp);
+        port.print(',');
+        port.println(raw);
+        return;
+    }
+    
+    if (captureLength == 0) {
+        capture[0] = captureSeq;
+        for (uint8_t i = 0; i < 4; i++) {
+            capture[1 + i] = (uint8_t)(timestamp >> (8 * i));
+        }
+        for (uint8_t i = 0; i < 3; i++) {
+            capture[5 + i] = (uint8_t)((uint32_t)raw >> (8 * i));
+        }
+        captureLength = CAPTURE_HEADER_BYTES;
+    } else {
+        int32_t delta = raw - captureRaw;
+        uint32_t zigzag = ((uint32_t)delta << 1) ^ (uint32_t)(delta >> 31);
+        captureLength += putVarint(&capture[captureLength], timestamp - captureTime);
+        captureLength += putVarint(&capture[captureLength], zigzag);
+    }
+    captureTime = timestamp;
+    captureRaw = raw;
+    
+    if (captureLength + CAPTURE_MAX_SAMPLE_BYTES > TELEMETRY_MAX_PAYLOAD) {
+        flushCapture();
+    }
+}
+
+/**
+ * Gửi khối mẫu đang gom; seq tăng cả khi khung bị bỏ
+ * Thông tin đầu đoạn ghi chưa gửi được thì thử gửi trước khối
+ */
+void Telemetry::flushCapture() {
+    if (captureLength == 0) {
+        return;
+    }
+    if (captureStartPending) {
+        sendCaptureStart();
+    }
+    if (captureZeroPending) {
+        sendCaptureZero();
+    }
+    beginFrame(FRAME_SAMPLES);
+    for (uint8_t i = 0; i < captureLength; i++) {
+        put8(capture[i]);
+    }
+    endFrame();
+    captureSeq++;
+    captureLength = 0;
+}
+
+/**
+ * Varint không dấu: 7 bit thấp trước, bit 7 = còn byte tiếp theo
+ */
+uint8_t Telemetry::putVarint(uint8_t* out, uint32_t value) {
+    uint8_t n = 0;
+    while (value >= 0x80) {
+        out[n++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    out[n++] = (uint8_t)value;
+    return n;
+}
+
+/**
+ * Lệnh một ký tự từ máy tính (ví dụ "p" để xuất profiler)
+ */
+int Telemetry::readCommand() {
+    return port.available() > 0 ? port.read() : -1;
+}
+
+/**
+ * Số khung bị bỏ - nếu tăng nhanh cần tăng baud hoặc giảm tần suất gửi
+ */
+uint16_t Telemetry::getDroppedFrames() const {
+    return droppedFrames;
+}
+
+/**
+ * Ghi phần đầu khung: sync, type; len được điền khi kết thúc khung
+ */
+void Telemetry::beginFrame(uint8_t type) {
+    frame[0] = TELEMETRY_SYNC;
+    frame[1] = type;
+    length = 0;
+}
+
+/**
+ * Ghi một byte payload (bỏ qua nếu vượt kích thước tối đa)
+ */
+void Telemetry::put8(uint8_t value) {
+    if (length < TELEMETRY_MAX_PAYLOAD) {
+        frame[3 + length++] = value;
+    }
+}
+
+/**
+ * Ghi 2 byte payload, byte thấp trước
+ */
+void Telemetry::put16(uint16_t value) {
+    put8(value & 0xFF);
+    put8(value >> 8);
+}
+
+/**
+ * Ghi 4 byte payload, byte thấp trước
+ */
+void Telemetry::put32(uint32_t value) {
+    put16(value & 0xFFFF);
+    put16(value >> 16);
+}
+
+/**
+ * Hoàn tất khung: điền len, tính CRC trên [type, len, payload]
+ * Chỉ gửi khi bộ đệm TX đủ chỗ cho cả khung - port.write() không phải chờ
+ */
+bool Telemetry::endFrame() {
+    frame[2] = length;
+    uint8_t total = length + 4;
+    frame[total - 1] = crc8(&frame[1], length + 2);
+    
+    if (port.availableForWrite() < total) {
+        droppedFrames++;
+        return false;
+    }
+    port.write(frame, total);
+    return true;
+}
+
+/**
+ * CRC-8 đa thức x^8 + x^2 + x + 1 (0x07), tính từng bit
+ * Khung ngắn (< 40 byte) nên không cần bảng tra
+ */
+uint8_t Telemetry::crc8(const uint8_t* data, uint8_t len) {
+    uint8_t crc = 0;
+    for (uint8_t i = 0; i < len; i++) {
+        crc ^= data[i];
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+        }
+    }
+    return crc;
+}
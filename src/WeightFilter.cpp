@@ -0,0 +1,89 @@
+/**
+ * @file WeightFilter.cpp
+ * @brief Implementation của WeightFilter class
+ */
+
+#include "WeightFilter.h"
+
+/**
+ * Constructor - Bộ lọc rỗng
+ */
+WeightFilter::WeightFilter(uint8_t window, uint16_t alpha, int32_t spikeThreshold)
+    : median(window), value(0), valid(false), spikeThreshold(spikeThreshold), alpha(0) {
+    setAlpha(alpha);
+}
+
+/**
+ * Bộ lọc trượt, cập nhật với mỗi mẫu mới:
+ * Bước 1: Median trượt loại bỏ spike đơn lẻ (tối đa (N-1)/2 mẫu liên tiếp)
+ * Bước 2: Median lệch khỏi giá trị lọc quá spikeThreshold là bước nhảy thật
+ *         (đặt/lấy sản phẩm) -> nhảy thẳng tới median thay vì trễ theo EMA
+ * Bước 3: Ngược lại làm mượt bằng EMA: f += (m - f) * alpha
+ */
+int32_t WeightFilter::add(int32_t sample) {
+    int32_t m = median.add(sample);
+    
+    int32_t diff = m - value;
+    if (!valid || diff > spikeThreshold || diff < -spikeThreshold) {
+        value = m;
+        valid = true;
+    } else if (alpha == 0) {
+        value = m;  // alpha = 256 (lưu là 0): không làm mượt
+    } else {
+        value += (diff * alpha) / 256;
+    }
+    return m;
+}
+
+/**
+ * Giá trị đã lọc
+ */
+int32_t WeightFilter::getValue() const {
+    return value;
+}
+
+/**
+ * Đã có mẫu hay chưa
+ */
+bool WeightFilter::hasValue() const {
+    return valid;
+}
+
+/**
+ * Đổi kích thước cửa sổ median
+ */
+void WeightFilter::setWindow(uint8_t window) {
+    median.setWindow(window);
+}
+
+/**
+ * Kích thước cửa sổ median
+ */
+uint8_t WeightFilter::getWindow() const {
+    return median.getWindow();
+}
+
+/**
+ * Đặt ngưỡng bước nhảy
+ */
+void WeightFilter::setSpikeThreshold(int32_t threshold) {
+    spikeThreshold = threshold;
+}
+
+/**
+ * Đặt hệ số lọc mũ; 256 được lưu là 0 để giữ kiểu uint8_t
+ */
+void WeightFilter::setAlpha(uint16_t newAlpha) {
+    if (newAlpha < 1) newAlpha = 1;
+    if (newAlpha > 256) newAlpha = 256;
+    alpha = (uint8_t)(newAlpha & 0xFF);
+}
+
+/**
+ * Xóa trạng thái bộ lọc
+ */
+void WeightFilter::reset() {
+    median.reset();
+    value = 0;
+    valid = false;
+}
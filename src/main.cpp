@@ -2,13 +2,18 @@
 #include "LoadCellManager.h"
 #include "ServoController.h"
 #include "DisplayManager.h"
+#include "Telemetry.h"
+#include "LaneController.h"
 #include "SystemController.h"
+#include "PersistentStore.h"
+#include "GradeEngine.h"
 
 // ==================== CẤU HÌNH PHẦN CỨNG ====================
 
 // Cấu hình chân kết nối HX711 LoadCell
 constexpr int LOADCELL_DOUT_PIN = 2;  // Chân DATA OUT của HX711
 constexpr int LOADCELL_SCK_PIN = 3;   // Chân SERIAL CLOCK của HX711
+constexpr int LOADCELL_RATE_PIN = -1; // Chân RATE của HX711 (-1: nối cứng GND, luôn 10 SPS)
 
 // Cấu hình chân điều khiển Servo Motor
 constexpr int SERVO_1_PIN = 8;        // Servo gạt sản phẩm lỗi (rejector)
@@ -26,14 +31,31 @@ constexpr int LCD_ROWS = 2;           // LCD 2 hàng
 // Hệ số hiệu chuẩn cân (cần hiệu chỉnh theo cân thực tế)
 constexpr float CALIBRATION_FACTOR = 340.0;  // Giá trị mẫu
 
-// Ngưỡng phân loại sản phẩm (gram)
-constexpr float WEIGHT_MIN = 50.0;    // Trọng lượng tối thiểu đạt chuẩn
-constexpr float WEIGHT_MAX = 200.0;   // Trọng lượng tối đa đạt chuẩn
+// Bảng phân hạng sản phẩm trong Flash (xem GradeEngine.h): cận dưới (gram, tính cả cận)
+// tăng dần, hạng đầu không có cận dưới. Mỗi hạng đi hết băng chuyền (EJECT_NONE) hoặc
+// bị servo 2 gạt ra (EJECT_SERVO_2); tối đa MAX_GRADES hạng
+const GradeBand GRADES[] PROGMEM = {
+    {0.0f, EJECT_SERVO_2, MSG_VERDICT_LIGHT},    // Dưới 50 g: quá nhẹ
+    {50.0f, EJECT_NONE, MSG_GRADE_3},            // 50 - 100 g
+    {100.0f, EJECT_NONE, MSG_GRADE_2},           // 100 - 150 g
+    {150.0f, EJECT_NONE, MSG_GRADE_1},           // 150 - 200 g
+    {200.0f, EJECT_SERVO_2, MSG_VERDICT_HEAVY}   // Từ 200 g: quá nặng
+};
+constexpr uint8_t GRADE_COUNT = sizeof(GRADES) / sizeof(GRADES[0]);
+
+// Cấu hình Serial/Telemetry
+// TELEMETRY_BINARY: khung nhị phân gọn, giải mã bằng tools/telemetry_decode.py
+// TELEMETRY_TEXT: các dòng chữ dễ đọc trên Serial Monitor (debug trên bàn thử)
+constexpr unsigned long SERIAL_BAUD = 115200;
+constexpr TelemetryMode TELEMETRY_MODE = TELEMETRY_BINARY;
 
 // ==================== KHỞI TẠO CÁC ĐỐI TƯỢNG OOP ====================
 
 // Tạo đối tượng quản lý cân điện tử
-LoadCellManager loadCell(LOADCELL_DOUT_PIN, LOADCELL_SCK_PIN, CALIBRATION_FACTOR);
+// DOUT nối chân 2 (INT0) nên dùng chế độ ngắt: vòng lặp chính không phải chờ ADC
+// Chân là hằng số nên driver HX711 dịch bit bằng lệnh sbi/cbi/sbis (makeHx711Driver)
+LoadCellManager loadCell(makeHx711Driver<LOADCELL_DOUT_PIN, LOADCELL_SCK_PIN>(), CALIBRATION_FACTOR,
+                         ACQ_INTERRUPT, LOADCELL_RATE_PIN);
 
 // Tạo đối tượng điều khiển servo motor
 ServoController servoController(SERVO_1_PIN, SERVO_2_PIN);
@@ -41,10 +63,40 @@ ServoController servoController(SERVO_1_PIN, SERVO_2_PIN);
 // Tạo đối tượng quản lý màn hình LCD
 DisplayManager display(LCD_ADDR, LCD_COLUMNS, LCD_ROWS);
 
+// Tạo đối tượng xuất dữ liệu qua Serial
+Telemetry telemetry(Serial, SERIAL_BAUD, TELEMETRY_MODE);
+
+// Tạo làn phân loại: cân, servo và cảm biến IR cùng bảng phân hạng của làn
+LaneController lane(&loadCell, &servoController, &display, &telemetry,
+                    IR_SENSOR_PIN, IR_COUNT_PIN,
+                    GRADES, GRADE_COUNT);
+LaneController* const lanes[] = {&lane};
+
+// Lưu điểm 0, hệ số hiệu chuẩn và bộ đếm trong EEPROM: mất điện xong khởi động lại
+// không phải tare chặn và không mất bộ đếm (xem PersistentStore.h)
+PersistentStore store;
+
 // Tạo đối tượng điều khiển hệ thống tổng thể
-SystemController systemController(&loadCell, &servoController, &display,
-                                  IR_SENSOR_PIN, IR_COUNT_PIN,
-                                  WEIGHT_MIN, WEIGHT_MAX);
+SystemController systemController(lanes, sizeof(lanes) / sizeof(lanes[0]), &display, &telemetry,
+                                  nullptr, &store);
+
+// Nhiều làn (tối đa MAX_LANES): mọi HX711 dùng chung SCK, DOUT nằm cùng một cổng để
+// một lần đọc PINx lấy bit của tất cả các kênh (xem MultiLoadCell.h). Sơ đồ cho 4 làn:
+//   SCK chung: 3 | DOUT: A0, A1, A2, A3 (PORTC) | RATE: nối cứng GND
+//   Servo đẩy/gạt: (8, 9), (10, 11), (12, 13), (6, 7)
+//   IR làn 1: 4, 5 - các làn khác không còn chân (-1), A4/A5 dành cho LCD I2C
+// Ví dụ 2 làn:
+//   MultiLoadCell sharedClock(3);
+//   LoadCellManager loadCell1(A0, &sharedClock, CALIBRATION_FACTOR);
+//   LoadCellManager loadCell2(A1, &sharedClock, CALIBRATION_FACTOR_2);
+//   ServoController servos1(8, 9), servos2(10, 11);
+//   const GradeBand SMALL_GRADES[] PROGMEM = {
+//       {0.0f, EJECT_SERVO_2, MSG_VERDICT_LIGHT}, {20.0f, EJECT_NONE, MSG_VERDICT_PASS},
+//       {80.0f, EJECT_SERVO_2, MSG_VERDICT_HEAVY}};
+//   LaneController lane1(&loadCell1, &servos1, &display, &telemetry, 4, 5, GRADES, GRADE_COUNT);
+//   LaneController lane2(&loadCell2, &servos2, &display, &telemetry, -1, -1, SMALL_GRADES, 3);
+//   LaneController* const lanes[] = {&lane1, &lane2};
+//   SystemController systemController(lanes, 2, &display, &telemetry, &sharedClock, &store);
 
 /**
  * @brief Hàm setup - Chạy 1 lần khi khởi động Arduino
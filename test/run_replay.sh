@@ -0,0 +1,47 @@
+#!/bin/sh
+# Phép thử hồi quy: phát lại từng chuỗi mẫu thô test/replay/*.csv qua firmware (env:native,
+# "--replay") và so log chữ với file .expected cùng tên. Khác một dòng là thất bại.
+#
+#   test/run_replay.sh                    # build env:native rồi chạy
+#   test/run_replay.sh PROGRAM            # dùng chương trình đã build sẵn
+#   test/run_replay.sh --update [PROGRAM] # ghi lại .expected sau một thay đổi có chủ ý
+#
+# Mã thoát: 0 khớp hết, 1 có chuỗi khác log mong đợi, 2 không build/chạy được
+
+set -u
+cd "$(dirname "$0")/.." || exit 2
+
+update=0
+if [ "${1:-}" = "--update" ]; then
+    update=1
+    shift
+fi
+if [ $# -gt 0 ]; then
+    program=$1
+else
+    pio run -e native -s || exit 2
+    program=.pio/build/native/program
+fi
+
+actual=$(mktemp) || exit 2
+trap 'rm -f "$actual"' EXIT
+
+failed=0
+for trace in test/replay/*.csv; do
+    expected=${trace%.csv}.expected
+    # Đường dẫn tương đối: tên file nằm trong log
+    if ! "$program" --replay "$trace" > "$actual" 2> /dev/null; then
+        echo "LOI   $trace: chuong trinh thoat loi"
+        exit 2
+    fi
+    if [ $update -eq 1 ]; then
+        cp "$actual" "$expected"
+        echo "GHI   $expected"
+    elif diff -u "$expected" "$actual"; then
+        echo "KHOP  $trace"
+    else
+        echo "KHAC  $trace"
+        failed=1
+    fi
+done
+exit $failed
@@ -0,0 +1,140 @@
+#!/usr/bin/env python3
+"""Báo cáo RAM/Flash của firmware AVR sau khi link, dừng build nếu thiếu chỗ cho stack.
+
+ATmega328P có 2048 byte SRAM cho .data + .bss (tĩnh), heap và stack. Công cụ in:
+- RAM tĩnh, Flash và khoảng trống còn lại cho heap + stack (headroom)
+- các biến chiếm RAM nhiều nhất (avr-nm)
+- các khung stack lớn nhất theo hàm (file .su của -fstack-usage, nếu có)
+và trả lỗi khi headroom nhỏ hơn mức tối thiểu. Stack sâu nhất lúc chạy đo bằng lệnh
+"m" qua Serial (MemoryMonitor), so với headroom ở đây để biết còn dư bao nhiêu.
+
+Trong PlatformIO (env:uno) công cụ chạy sau mỗi lần link qua extra_scripts; mức tối
+thiểu đặt bằng custom_ram_min_headroom. Dùng riêng trên một file ELF:
+    python3 tools/ram_report.py .pio/build/uno/firmware.elf --su-dir .pio/build/uno
+    python3 tools/ram_report.py firmware.elf --min-headroom 600 --top 20
+"""
+
+import argparse
+import os
+import subprocess
+import sys
+
+RAM_SIZE = 2048
+FLASH_SIZE = 32256          # 32 KB trừ bootloader Optiboot (512 byte)
+RAM_ADDRESS_BASE = 0x800000 # avr-gcc đặt vùng dữ liệu ở 0x800000 trong file ELF
+DEFAULT_MIN_HEADROOM = 512
+DEFAULT_TOP = 10
+
+
+def section_sizes(size_tool, elf, run_env=None):
+    """Kích thước các section (byte) theo avr-size -A."""
+    output = subprocess.check_output([size_tool, "-A", elf], env=run_env).decode()
+    sizes = {}
+    for line in output.splitlines():
+        parts = line.split()
+        if len(parts) >= 2 and parts[0].startswith(".") and parts[1].isdigit():
+            sizes[parts[0]] = int(parts[1])
+    return sizes
+
+
+def ram_symbols(nm_tool, elf, run_env=None):
+    """[(size, type, name)] các biến trong RAM, lớn nhất trước."""
+    output = subprocess.check_output([nm_tool, "-S", "-C", "--size-sort", elf],
+                                     env=run_env).decode()
+    symbols = []
+    for line in output.splitlines():
+        parts = line.split(None, 3)
+        if len(parts) < 4 or parts[2] not in "bBdD":
+            continue
+        if int(parts[0], 16) < RAM_ADDRESS_BASE:
+            continue
+        symbols.append((int(parts[1], 16), parts[2], parts[3]))
+    symbols.sort(reverse=True)
+    return symbols
+
+
+def stack_frames(su_dir):
+    """[(bytes, kind, function)] từ các file .su (-fstack-usage), lớn nhất trước."""
+    frames = []
+    if not su_dir or not os.path.isdir(su_dir):
+        return frames
+    for root, _, files in os.walk(su_dir):
+        for name in files:
+            if not name.endswith(".su"):
+                continue
+            with open(os.path.join(root, name)) as su:
+                for line in su:
+                    fields = line.rstrip("\n").split("\t")
+                    if len(fields) == 3 and fields[1].isdigit():
+                        function = fields[0].rsplit(":", 1)[-1]
+                        frames.append((int(fields[1]), fields[2], function))
+    frames.sort(reverse=True)
+    return frames
+
+
+def report(elf, size_tool="avr-size", nm_tool="avr-nm", su_dir=None,
+           min_headroom=DEFAULT_MIN_HEADROOM, top=DEFAULT_TOP, run_env=None):
+    """In báo cáo, trả về True nếu headroom >= min_headroom."""
+    sizes = section_sizes(size_tool, elf, run_env)
+    data = sizes.get(".data", 0)
+    bss = sizes.get(".bss", 0) + sizes.get(".noinit", 0)
+    static = data + bss
+    flash = sizes.get(".text", 0) + data
+    headroom = RAM_SIZE - static
+
+    print("RAM:   static=%d (.data %d + .bss %d) / %d byte, headroom heap+stack=%d" %
+          (static, data, bss, RAM_SIZE, headroom))
+    print("Flash: %d / %d byte (%.1f%%)" % (flash, FLASH_SIZE, 100.0 * flash / FLASH_SIZE))
+
+    symbols = ram_symbols(nm_tool, elf, run_env)
+    if symbols:
+        print("Bien chiem RAM nhieu nhat:")
+        for size, kind, name in symbols[:top]:
+            print("  %5d  %s  %s" % (size, kind, name))
+
+    frames = stack_frames(su_dir)
+    if frames:
+        print("Khung stack lon nhat (-fstack-usage):")
+        for size, kind, function in frames[:top]:
+            print("  %5d  %-16s %s" % (size, kind, function))
+    print("Stack sau nhat luc chay: gui \"m\" qua Serial (stack_max), phai < %d" % headroom)
+
+    if headroom < min_headroom:
+        print("LOI: headroom %d byte < toi thieu %d byte (custom_ram_min_headroom)" %
+              (headroom, min_headroom), file=sys.stderr)
+        return False
+    return True
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("elf", help="file ELF sau khi link")
+    parser.add_argument("--size-tool", default="avr-size")
+    parser.add_argument("--nm-tool", default="avr-nm")
+    parser.add_argument("--su-dir", help="thu muc chua cac file .su (-fstack-usage)")
+    parser.add_argument("--min-headroom", type=int, default=DEFAULT_MIN_HEADROOM,
+                        help="RAM toi thieu con lai cho heap + stack (byte)")
+    parser.add_argument("--top", type=int, default=DEFAULT_TOP)
+    args = parser.parse_args()
+    ok = report(args.elf, args.size_tool, args.nm_tool, args.su_dir,
+                args.min_headroom, args.top)
+    sys.exit(0 if ok else 1)
+
+
+try:
+    Import("env")  # noqa: F821 - có sẵn khi PlatformIO/SCons chạy script
+except NameError:
+    env = None
+
+if env is not None:
+    def after_link(source, target, env):
+        min_headroom = int(env.GetProjectOption("custom_ram_min_headroom",
+                                                DEFAULT_MIN_HEADROOM))
+        if not report(str(target[0]), env.subst("$SIZETOOL"),
+                      env.subst("$SIZETOOL").replace("size", "nm"),
+                      env.subst("$BUILD_DIR"), min_headroom, run_env=env["ENV"]):
+            env.Exit(1)
+
+    env.AddPostAction("$BUILD_DIR/${PROGNAME}.elf", after_link)
+elif __name__ == "__main__":
+    main()
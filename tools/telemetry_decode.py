@@ -0,0 +1,295 @@
+#!/usr/bin/env python3
+"""Giải mã luồng telemetry nhị phân của FTH_ArduinoUnoR3 thành CSV.
+
+Khung: [0xA5][type][len][payload][crc8], CRC-8 đa thức 0x07 trên type, len, payload.
+Các dòng chữ lúc khởi động (trước khi vào chế độ nhị phân) được bỏ qua.
+
+Khung profiler (gửi "p" khi firmware build với -DPROFILER_ENABLED) được in ra
+stderr, hoặc ghi vào file CSV riêng nếu có --profile-csv. Ảnh chụp RAM (gửi "m")
+cũng được in ra stderr, số sản phẩm theo hạng (gửi "g") cũng vậy. Sự kiện điểm 0 (điểm
+0 EEPROM lệch quá dải kiểm tra và được tare nền, tự bám điểm 0 chạm giới hạn, tare không
+có dữ liệu HX711) và sự kiện của làn (bảng hạng cấu hình sai) cũng vậy.
+Thống kê quá trình và biểu đồ tần suất (gửi "s", firmware cũng tự gửi khi bật cảnh báo
+trôi) được in ra stderr theo count; gửi "b" để lấy lại trung bình gốc.
+
+Mẫu thô HX711 (gửi "c" để bật/tắt ghi) được ghi vào --samples-csv dạng "t_ms,raw",
+kèm dòng "# tare=..,cpg_q8=.." mỗi lần bắt đầu ghi và dòng "# zero=.." mỗi lần tự bám
+điểm 0 đổi điểm 0 giữa đoạn ghi. File này phát lại được bằng
+"program --replay" của env:native và "--trace" của env:bench.
+
+Ví dụ:
+    python3 tools/telemetry_decode.py /dev/ttyACM0 --baud 115200 > run.csv
+    python3 tools/telemetry_decode.py capture.bin > run.csv
+    python3 tools/telemetry_decode.py /dev/ttyACM0 --send p --profile-csv prof.csv > run.csv
+    python3 tools/telemetry_decode.py /dev/ttyACM0 --send c --samples-csv samples.csv > run.csv
+    python3 tools/telemetry_decode.py /dev/ttyACM0 --send m > run.csv
+    python3 tools/telemetry_decode.py /dev/ttyACM0 --send g > run.csv
+    python3 tools/telemetry_decode.py /dev/ttyACM0 --send s > run.csv
+"""
+
+import argparse
+import csv
+import os
+import stat
+import struct
+import sys
+
+SYNC = 0xA5
+MAX_PAYLOAD = 32
+FRAME_PRODUCT = 0x01
+FRAME_PASS_COUNT = 0x02
+FRAME_PROFILE = 0x03
+FRAME_CAPTURE_START = 0x04
+FRAME_SAMPLES = 0x05
+FRAME_MEMORY = 0x06
+FRAME_ZERO = 0x07
+FRAME_GRADES = 0x08
+FRAME_STATS = 0x09
+FRAME_HISTOGRAM = 0x0A
+FRAME_EVENT = 0x0B
+FRAME_CAPTURE_ZERO = 0x0C
+
+VERDICTS = {0: "PASS", 1: "LIGHT", 2: "HEAVY"}
+
+ZERO_EVENTS = {0x01: "RESTORE_FALLBACK", 0x02: "TRACK_LIMIT", 0x04: "TARE_NO_DATA"}
+LANE_EVENTS = {0x01: "GRADE_UNSORTED"}
+
+SPC_ALARMS = [(0x02, "CUSUM+"), (0x04, "CUSUM-"), (0x08, "EWMA+"), (0x10, "EWMA-")]
+
+PROFILE_STAGES = ["loop", "hx711", "filter", "classify", "servo", "display", "serial"]
+PROFILE_BUCKETS = 16
+PROFILE_COLUMNS = ["stage", "count", "min_us", "max_us", "mean_us"] + \
+    ["hist_%dus" % (1 << i) for i in range(PROFILE_BUCKETS)]
+
+COLUMNS = ["type", "timestamp_ms", "raw_weight", "verdict", "confidence",
+           "pass_count", "reject_count", "settle_ms", "push_ms", "in_flight",
+           "median_window", "sample_rate", "noise_counts", "lane", "exit_ms", "transit_ms",
+           "grade", "zero_drift"]
+
+
+def crc8(data):
+    crc = 0
+    for byte in data:
+        crc ^= byte
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x07) & 0xFF if crc & 0x80 else (crc << 1) & 0xFF
+    return crc
+
+
+def open_input(path, baud):
+    if path == "-":
+        return sys.stdin.buffer
+    if stat.S_ISCHR(os.stat(path).st_mode):
+        try:
+            import serial
+        except ImportError:
+            sys.exit("Doc cong Serial can pyserial: pip install pyserial")
+        return serial.Serial(path, baud, timeout=None)
+    return open(path, "rb")
+
+
+def frames(stream):
+    """Sinh (type, payload) cho mỗi khung hợp lệ, tự đồng bộ lại khi lỗi CRC."""
+    buf = bytearray()
+    bad = 0
+    while True:
+        chunk = stream.read(1 if hasattr(stream, "in_waiting") else 4096)
+        if not chunk:
+            break
+        buf.extend(chunk)
+        while True:
+            start = buf.find(bytes([SYNC]))
+            if start < 0:
+                buf.clear()
+                break
+            del buf[:start]
+            if len(buf) >= 3 and buf[2] > MAX_PAYLOAD:
+                del buf[0]
+                continue
+            if len(buf) < 4 or len(buf) < buf[2] + 4:
+                break
+            length = buf[2]
+            total = length + 4
+            if crc8(buf[1:total - 1]) != buf[total - 1]:
+                # Byte 0xA5 nằm trong dữ liệu hoặc khung hỏng: dịch một byte và tìm lại
+                bad += 1
+                del buf[0]
+                continue
+            yield buf[1], bytes(buf[3:3 + length])
+            del buf[:total]
+    if bad:
+        print("Bo qua %d khung loi CRC" % bad, file=sys.stderr)
+
+
+def decode(frame_type, payload):
+    # Firmware cũ: 20 byte (không có lấy mẫu thích nghi), 24 byte (không có làn),
+    # 25 byte (không có hạng), 26 byte (không có độ trôi điểm 0)
+    if frame_type == FRAME_PRODUCT and len(payload) in (20, 24, 25, 26, 28):
+        (ts, raw, verdict, conf, passed, rejected,
+         settle, push, in_flight) = struct.unpack("<IiBBHHHHH", payload[:20])
+        sampling = list(struct.unpack("<BBH", payload[20:24])) if len(payload) >= 24 else ["", "", ""]
+        lane = payload[24] if len(payload) >= 25 else 0
+        grade = payload[25] if len(payload) >= 26 else ""
+        (zero_drift,) = struct.unpack("<h", payload[26:28]) if len(payload) == 28 else ("",)
+        return ["product", ts, raw, VERDICTS.get(verdict, verdict), conf,
+                passed, rejected, settle, push, in_flight] + sampling + [lane, "", "", grade, zero_drift]
+    # Firmware cũ: 4 byte (không có làn), 5 byte (không có tốc độ băng)
+    if frame_type == FRAME_PASS_COUNT and len(payload) in (4, 5, 9):
+        (ts,) = struct.unpack("<I", payload[:4])
+        lane = payload[4] if len(payload) >= 5 else 0
+        belt = list(struct.unpack("<HH", payload[5:9])) if len(payload) == 9 else ["", ""]
+        return ["pass_count", ts] + [""] * (len(COLUMNS) - 7) + [lane] + belt + ["", ""]
+    return None
+
+
+def decode_profile(payload):
+    if len(payload) != 11 + PROFILE_BUCKETS:
+        return None
+    stage, count, min_us, max_us, mean_us = struct.unpack("<BIHHH", payload[:11])
+    name = PROFILE_STAGES[stage] if stage < len(PROFILE_STAGES) else str(stage)
+    return [name, count, min_us, max_us, mean_us] + list(payload[11:])
+
+
+def read_varint(payload, pos):
+    value = 0
+    shift = 0
+    while True:
+        byte = payload[pos]
+        pos += 1
+        value |= (byte & 0x7F) << shift
+        shift += 7
+        if not byte & 0x80:
+            return value, pos
+
+
+def decode_samples(payload):
+    """Trả về (seq, [(t_ms, raw), ...]) của một khung FRAME_SAMPLES."""
+    if len(payload) < 8:
+        return None
+    seq = payload[0]
+    t, = struct.unpack("<I", payload[1:5])
+    raw = int.from_bytes(payload[5:8], "little", signed=True)
+    samples = [(t, raw)]
+    pos = 8
+    try:
+        while pos < len(payload):
+            dt, pos = read_varint(payload, pos)
+            zigzag, pos = read_varint(payload, pos)
+            t = (t + dt) & 0xFFFFFFFF
+            raw += (zigzag >> 1) ^ -(zigzag & 1)
+            samples.append((t, raw))
+    except IndexError:
+        return None
+    return seq, samples
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("input", help="cong Serial, file ghi lai, hoac - (stdin)")
+    parser.add_argument("--baud", type=int, default=115200)
+    parser.add_argument("--profile-csv", help="ghi khung profiler vao file CSV nay")
+    parser.add_argument("--samples-csv", help="ghi mau tho HX711 vao file CSV nay")
+    parser.add_argument("--send", help="gui lenh toi firmware sau khi mo cong (vd: p, c, m, g, s)")
+    args = parser.parse_args()
+
+    writer = csv.writer(sys.stdout)
+    writer.writerow(COLUMNS)
+    profile_writer = None
+    if args.profile_csv:
+        profile_writer = csv.writer(open(args.profile_csv, "w", newline=""))
+        profile_writer.writerow(PROFILE_COLUMNS)
+    samples_file = open(args.samples_csv, "w") if args.samples_csv else None
+    if samples_file is not None:
+        samples_file.write("t_ms,raw\n")
+    next_seq = None
+    lost_blocks = 0
+    stream = open_input(args.input, args.baud)
+    if args.send and hasattr(stream, "in_waiting"):
+        stream.write(args.send.encode())
+    try:
+        for frame_type, payload in frames(stream):
+            if frame_type == FRAME_CAPTURE_START and len(payload) == 12:
+                _, tare, cpg_q8 = struct.unpack("<Iii", payload)
+                if samples_file is not None:
+                    samples_file.write("# tare=%d,cpg_q8=%d\n" % (tare, cpg_q8))
+                continue
+            if frame_type == FRAME_CAPTURE_ZERO and len(payload) == 8:
+                _, tare = struct.unpack("<Ii", payload)
+                if samples_file is not None:
+                    samples_file.write("# zero=%d\n" % tare)
+                continue
+            if frame_type == FRAME_SAMPLES:
+                block = decode_samples(payload)
+                if block is None:
+                    continue
+                seq, samples = block
+                if next_seq is not None and seq != next_seq:
+                    lost_blocks += (seq - next_seq) & 0xFF
+                next_seq = (seq + 1) & 0xFF
+                if samples_file is not None:
+                    for t, raw in samples:
+                        samples_file.write("%d,%d\n" % (t, raw))
+                continue
+            if frame_type == FRAME_PROFILE:
+                row = decode_profile(payload)
+                if row is None:
+                    continue
+                if profile_writer is not None:
+                    profile_writer.writerow(row)
+                else:
+                    print("PROF %-8s n=%d min=%d mean=%d max=%d us hist=%s" % (
+                        row[0], row[1], row[2], row[4], row[3],
+                        ",".join(str(v) for v in row[5:])), file=sys.stderr)
+                continue
+            if frame_type == FRAME_MEMORY and len(payload) == 10:
+                print("MEM static=%d heap=%d free=%d free_min=%d stack_max=%d" %
+                      struct.unpack("<HHHHH", payload), file=sys.stderr)
+                continue
+            if frame_type == FRAME_ZERO and len(payload) == 10:
+                ts, lane, event, counts = struct.unpack("<IBBi", payload)
+                print("ZERO lane=%d t=%d %s counts=%d" % (
+                    lane, ts, ZERO_EVENTS.get(event, event), counts), file=sys.stderr)
+                continue
+            if frame_type == FRAME_EVENT and len(payload) == 6:
+                ts, lane, event = struct.unpack("<IBB", payload)
+                print("EVENT lane=%d t=%d %s" % (
+                    lane, ts, LANE_EVENTS.get(event, event)), file=sys.stderr)
+                continue
+            if frame_type == FRAME_STATS and len(payload) == 28:
+                (lane, flags, n, mean, sd, ref_mean, ref_sigma, ewma, cusum_high, cusum_low,
+                 rate, alarms) = struct.unpack("<BBIiHiHiBBHH", payload)
+                drift = " ".join(name for bit, name in SPC_ALARMS if flags & bit)
+                if flags & 0x01:
+                    baseline = "ref=%d+/-%d ewma=%d cusum=+%d%%/-%d%%" % (
+                        ref_mean, ref_sigma, ewma, cusum_high, cusum_low)
+                else:
+                    baseline = "ref=pending"
+                print("SPC lane=%d n=%d mean=%d sd=%d rate=%d/min %s alarms=%d%s" % (
+                    lane, n, mean, sd, rate, baseline, alarms,
+                    " DRIFT " + drift if drift else ""), file=sys.stderr)
+                continue
+            if frame_type == FRAME_HISTOGRAM and len(payload) >= 7 and (len(payload) - 7) % 2 == 0:
+                lane, low, width = struct.unpack("<BiH", payload[:7])
+                bins = struct.unpack("<%dH" % ((len(payload) - 7) // 2), payload[7:])
+                print("HIST lane=%d from=%d width=%d %s" % (
+                    lane, low, width, " ".join(str(v) for v in bins)), file=sys.stderr)
+                continue
+            if frame_type == FRAME_GRADES and len(payload) >= 2 and len(payload) == 2 + 2 * payload[1]:
+                counts = struct.unpack("<%dH" % payload[1], payload[2:])
+                print("GRADES lane=%d %s" % (payload[0], " ".join(
+                    "%d:%d" % (i, n) for i, n in enumerate(counts))), file=sys.stderr)
+                continue
+            row = decode(frame_type, payload)
+            if row is not None:
+                writer.writerow(row)
+                sys.stdout.flush()
+    except KeyboardInterrupt:
+        pass
+    if samples_file is not None:
+        samples_file.close()
+    if lost_blocks:
+        print("Mat %d khoi mau tho (bo dem TX day)" % lost_blocks, file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()